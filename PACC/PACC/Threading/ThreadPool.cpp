@@ -38,87 +38,132 @@
 using namespace std;
 using namespace PACC;
 
-/*! \brief Execute a pending task.
+/*! \brief Execute pending tasks.
 
-When awakened by its parent thread pool, this method removes the next task from the head of the queue and starts executing it immediately. It also broadcasts a signal to all waiting threads for this task, both prior to task execution and after task completion.
+This method takes the next task of its own queue, or steals one from another slave, and executes it immediately. It also broadcasts a signal to all waiting threads for this task, both prior to task execution and after task completion. When no task is left, the slave sleeps until awakened by its parent thread pool.
 */
 void Threading::SlaveThread::main(void) 
 {
+	// wait for the thread pool to create all its slaves
+	mPool->lock();
+	mPool->unlock();
 	while(!mCancel)
 	{
-		// wait for available task
-		mPool->lock();
-		while(mPool->mTasks.empty() && !mCancel) mPool->wait();
-		if(!mCancel)
+		Task* lTask = mPool->popTask(mIndex, false);
+		if(lTask == 0)
 		{
-			// dequeu next task
-			Task* lTask = mPool->mTasks.front();
-			mPool->mTasks.pop();
+			// queues are checked again with the pool locked, so that a push cannot be missed
+			mPool->lock();
+			while(!mCancel && (lTask = mPool->popTask(mIndex, true)) == 0) mPool->wait();
 			mPool->unlock();
-			// signal all that task is running
-			lTask->lock();
-			lTask->mRunning = true;
-			lTask->broadcast();
-			lTask->unlock();
-			// run task
-			lTask->main();
-			// signal all that task is completed
-			lTask->lock();
-			lTask->mRunning = false;
-			lTask->mCompleted = true;
-			lTask->broadcast();
-			lTask->unlock();
+			if(lTask == 0) break;
 		}
-		else mPool->unlock();
+		// signal all that task is running
+		lTask->lock();
+		lTask->mRunning = true;
+		lTask->broadcast();
+		lTask->unlock();
+		// run task
+		lTask->main();
+		// signal all that task is completed
+		lTask->lock();
+		lTask->mRunning = false;
+		lTask->mCompleted = true;
+		lTask->broadcast();
+		lTask->unlock();
 	}
 }
 
 //! Construct thread pool by allocating \c inSlaves threads.
-Threading::ThreadPool::ThreadPool(unsigned int inSlaves)
+Threading::ThreadPool::ThreadPool(unsigned int inSlaves) : mNextSlave(0)
 {
-	// allocate slave threads
+	// allocate slave threads, they start once the pool is complete
+	lock();
 	for(unsigned int i = 0; i < inSlaves; ++i) 
 	{
-		SlaveThread* lThread = new SlaveThread(this);
+		SlaveThread* lThread = new SlaveThread(this, i);
 		push_back(lThread);
 	}
+	unlock();
 }
 
 //! Delete thread pool.
 Threading::ThreadPool::~ThreadPool(void)
 {
-	lock();
-	// wait for queue to become empty
-	while(!mTasks.empty()) 
+	// wait for all queues to become empty
+	for(unsigned int i = 0; i < size(); ++i) 
 	{
-		// wait for last task in queue to at least start running
-		Task* lTask = mTasks.back();
-		lTask->lock();
-		unlock();
-		lTask->wait(false);
-		lTask->unlock();
-		lock();
+		SlaveThread* lSlave = (*this)[i];
+		lSlave->mTasksMutex.lock();
+		while(!lSlave->mTasks.empty()) 
+		{
+			// wait for last task in queue to complete
+			Task* lTask = lSlave->mTasks.back();
+			lTask->lock();
+			lSlave->mTasksMutex.unlock();
+			lTask->wait(false);
+			lTask->unlock();
+			lSlave->mTasksMutex.lock();
+		}
+		lSlave->mTasksMutex.unlock();
 	}
 	// now cancel all threads
+	lock();
 	for(unsigned int i = 0; i < size(); ++i) (*this)[i]->cancel();
 	// signal them to wake up
 	broadcast();
 	unlock();
-	// then delete them (the thread destructor will wait for thread completion)
+	// wait for all of them before deleting any, a slave looking for a task reads the queues of the others
+	for(unsigned int i = 0; i < size(); ++i) (*this)[i]->wait(true);
 	for(unsigned int i = 0; i < size(); ++i) delete (*this)[i];
 }
 
-/*! \brief Push task \c inTask onto the thread pool queue.
+/*! \brief Remove a task for slave \c inSlave.
+
+The slave takes the oldest task of its own queue. Otherwise, it steals the newest task of another slave. If \c inBlocking is false, the queues that are locked by another thread are skipped. Return 0 if no task was found.
+*/
+Threading::Task* Threading::ThreadPool::popTask(unsigned int inSlave, bool inBlocking)
+{
+	Task* lTask = 0;
+	SlaveThread* lOwn = (*this)[inSlave];
+	lOwn->mTasksMutex.lock();
+	if(!lOwn->mTasks.empty())
+	{
+		lTask = lOwn->mTasks.front();
+		lOwn->mTasks.pop_front();
+	}
+	lOwn->mTasksMutex.unlock();
+	
+	for(unsigned int i = 1; i < size() && lTask == 0; ++i)
+	{
+		SlaveThread* lVictim = (*this)[(inSlave+i) % size()];
+		if(inBlocking) lVictim->mTasksMutex.lock();
+		else if(!lVictim->mTasksMutex.tryLock()) continue;
+		if(!lVictim->mTasks.empty())
+		{
+			lTask = lVictim->mTasks.back();
+			lVictim->mTasks.pop_back();
+		}
+		lVictim->mTasksMutex.unlock();
+	}
+	return lTask;
+}
+
+/*! \brief Push task \c inTask onto the thread pool.
 
-The thread pool maintains a queue of task references that will be executed in FIFO order.
+The tasks are assigned in turn to the queues of the slave threads. Each slave executes its own tasks in FIFO order, idle slaves steal tasks from the others.
 */
 void Threading::ThreadPool::push(Task& inTask)
 {
 	// reset task flags
 	inTask.reset();
-	// push task onto queue and signal availability
+	// push task onto the queue of the next slave and signal availability
 	lock();
-	mTasks.push(&inTask);
+	SlaveThread* lSlave = (*this)[mNextSlave];
+	mNextSlave = (mNextSlave+1) % size();
+	lSlave->mTasksMutex.lock();
+	lSlave->mTasks.push_back(&inTask);
+	lSlave->mTasksMutex.unlock();
 	signal();
 	unlock();
 }
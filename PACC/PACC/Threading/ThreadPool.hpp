@@ -38,7 +38,8 @@
 
 #include "PACC/Threading/Thread.hpp"
 #include "PACC/Threading/Task.hpp"
-#include <queue>
+#include "PACC/Threading/Mutex.hpp"
+#include <deque>
 #include <vector>
 
 namespace PACC {
@@ -53,26 +54,31 @@ namespace PACC {
 		\author Marc Parizeau, Laboratoire de vision et syst&egrave;mes num&eacute;riques, Universit&eacute; Laval
 		\ingroup Threading
 		
-		This class defines a specialized thread for executing thread pool tasks. A slave thread simply sleeps until awakened by its parent thread pool when the later needs to execute a pending Task (see SlaveThread::main for more details). 
+		This class defines a specialized thread for executing thread pool tasks. Each slave thread owns a queue of tasks assigned by its parent thread pool. It executes them in order, steals tasks from the other slaves when its own queue is empty, and sleeps when no task is left (see SlaveThread::main for more details). 
 		*/
 		class SlaveThread : public Thread {
 			public:
-			//! Construct a slave thread for a thread pool.
-			SlaveThread(ThreadPool* inPool) : mPool(inPool) {run();}
+			//! Construct slave thread \c inIndex for a thread pool.
+			SlaveThread(ThreadPool* inPool, unsigned int inIndex=0) : mPool(inPool), mIndex(inIndex) {run();}
 			//! Delete slave thread; wait for thread termination.
 			~SlaveThread(void) {wait(true);}
 			
 			protected:
 			ThreadPool* mPool; //!< Pointer to parent thread pool
+			unsigned int mIndex; //!< Index of this slave in its parent thread pool
+			deque<Task*> mTasks; //!< Queue of tasks assigned to this slave.
+			Mutex mTasksMutex; //!< Lock of the task queue.
 			
 			void main(void);
+			
+			friend class ThreadPool;
 		};
 		
 		/*! \brief Portable thread pool of slaves.
 			\author Marc Parizeau, Laboratoire de vision et syst&egrave;mes num&eacute;riques, Universit&eacute; Laval
 			\ingroup Threading
 			
-			This class implements a thread pool of slave threads that process a FIFO queue of tasks derived from class Threading::Task. A task is simply an object with a Task::main method. Here is a simple usage example:
+			This class implements a thread pool of slave threads that process tasks derived from class Threading::Task. A task is simply an object with a Task::main method. The tasks are assigned in turn to the queues of the slaves, and an idle slave steals the most recently queued task of another slave, so that long tasks do not hold back the tasks queued behind them. Each queue has its own lock, the lock of the pool is only taken to push a task and to put an idle slave to sleep. Here is a simple usage example:
 			\code
 #include "Threading/Task.hpp"
 
@@ -104,7 +110,9 @@ int void main(int argc, char** argv)
 			void push(Task& inTask);
 			
 			protected:
-			queue<Task*> mTasks; //!< Queue of tasks.
+			unsigned int mNextSlave; //!< Index of the slave receiving the next pushed task.
+			
+			Task* popTask(unsigned int inSlave, bool inBlocking);
 			
 			friend class SlaveThread;
 		};
@@ -44,4 +44,5 @@
 
 #include "PACC/XML/Document.hpp"
 #include "PACC/XML/Finder.hpp"
+#include "PACC/XML/Parser.hpp"
 #include "PACC/XML/Streamer.hpp"
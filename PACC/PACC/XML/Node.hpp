@@ -196,6 +196,7 @@ namespace PACC {
 			friend class Iterator;
 			friend class ConstIterator;
 			friend class Document;
+			friend class Parser;
 			
 		};
 		
@@ -0,0 +1,184 @@
+/*
+ *  Portable Agile C++ Classes (PACC)
+ *  Copyright (C) 2001-2003 by Marc Parizeau
+ *  http://manitou.gel.ulaval.ca/~parizeau/PACC
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  Contact:
+ *  Laboratoire de Vision et Systemes Numeriques
+ *  Departement de genie electrique et de genie informatique
+ *  Universite Laval, Quebec, Canada, G1K 7P4
+ *  http://vision.gel.ulaval.ca
+ *
+ */
+/*!
+ * \file PACC/XML/Parser.cpp
+ * \brief Class methods for the streaming %XML parser.
+ * \author Jean-Francois Dupuis
+ */
+
+#include "PACC/XML/Parser.hpp"
+#include "PACC/Util/Assert.hpp"
+#include <stdexcept>
+
+using namespace std;
+using namespace PACC;
+
+/*!
+*/
+XML::Parser::Parser(istream& inStream, const string& inName) : mTokenizer(inStream), mEvent(eEndOfDocument), mNode(new Node), mEmptyTag(false)
+{
+	mTokenizer.setStreamName(inName);
+}
+
+/*!
+*/
+XML::Parser::~Parser(void)
+{
+	delete mNode;
+}
+
+/*!
+The node returned by getNode is only valid until the next call to this method.
+*/
+XML::Parser::Event XML::Parser::next(void)
+{
+	// an empty tag <tag/> produces its end tag event
+	if(mEmptyTag) {
+		mEmptyTag = false;
+		mEndName = mNode->getValue();
+		return mEvent = eEndTag;
+	}
+	delete mNode;
+	mNode = new Node;
+	
+	// look for next tag or string
+	string lToken;
+	mTokenizer.setDelimiters("", "<");
+	if(!mTokenizer.getNextToken(lToken)) {
+		if(!mOpenTags.empty()) mNode->throwError(mTokenizer, "unexpected eof");
+		return mEvent = eEndOfDocument;
+	}
+	// remove any leading white space
+	string::size_type lPos = lToken.find_first_not_of(" \t\r\n");
+	if(lPos == string::npos) {
+		if(!mTokenizer.getNextToken(lToken)) {
+			if(!mOpenTags.empty()) mNode->throwError(mTokenizer, "unexpected eof");
+			return mEvent = eEndOfDocument;
+		}
+	} else if(lPos > 0) lToken.erase(0, lPos);
+	
+	if(lToken[0] == '<') {
+		if(mTokenizer.peekNextChar() == '/') {
+			// found end tag
+			if(mOpenTags.empty()) mNode->throwError(mTokenizer, "invalid end tag");
+			mTokenizer.setDelimiters("", "/");
+			mTokenizer.getNextToken(lToken);
+			mEndName = mOpenTags.back();
+			mOpenTags.pop_back();
+			readEndTag(mEndName);
+			return mEvent = eEndTag;
+		}
+		// found start tag
+		mNode->parseStartTag(mTokenizer, lToken);
+		if(mNode->getType() != eData) return mEvent = eContent;
+		if(lToken[0] == '/') {
+			// found empty tag; next token must be '>'
+			mTokenizer.setDelimiters("", ">");
+			if(!mTokenizer.getNextToken(lToken)) mNode->throwError(mTokenizer, "unexpected eof");
+			if(lToken[0] != '>') mNode->throwError(mTokenizer, "invalid start tag");
+			mEmptyTag = true;
+		} else mOpenTags.push_back(mNode->getValue());
+		return mEvent = eStartTag;
+	}
+	
+	// found a simple string node
+	mNode->setType(eString);
+	// remove any ending white space
+	lPos = lToken.find_last_not_of(" \t\r\n");
+	PACC_AssertM(lPos != string::npos, "Internal error!");
+	if(lPos < lToken.size()-1) lToken.resize(lPos+1);
+	// convert basic quotes
+	(*mNode)[""] = Node::convertFromQuotes(lToken);
+	return mEvent = eContent;
+}
+
+/*!
+This method assumes that token "</" has already been read.
+*/
+void XML::Parser::readEndTag(const string& inName)
+{
+	string lToken;
+	mTokenizer.setDelimiters("", " \t\n\r>");
+	if(!mTokenizer.getNextToken(lToken)) mNode->throwError(mTokenizer, "unexpected eof");
+	if(lToken != inName) mNode->throwError(mTokenizer, "invalid end tag");
+	// next token must be '>'
+	mTokenizer.setDelimiters(" \t\n\r", ">");
+	if(!mTokenizer.getNextToken(lToken)) mNode->throwError(mTokenizer, "unexpected eof");
+	if(lToken[0] != '>') mNode->throwError(mTokenizer, "invalid end tag");
+}
+
+/*!
+\return A detached node that must be deleted by the caller (see class Subtree).
+
+The parser must be on a start tag. The whole element is parsed, up to and including its end tag, and the parser is left on the end tag event.
+*/
+XML::Node* XML::Parser::readSubtree(void)
+{
+	if(mEvent != eStartTag) throw runtime_error("Parser::readSubtree() the parser is not on a start tag");
+	Node* lRoot = mNode;
+	mNode = new Node(*lRoot);
+	mEndName = lRoot->getValue();
+	if(mEmptyTag) {
+		mEmptyTag = false;
+	} else {
+		try {
+			if(mNoParseTags.find(mEndName) != mNoParseTags.end()) {
+				lRoot->readContentAsString(mTokenizer);
+			} else {
+				Node* lChild;
+				// parse all child
+				while((lChild=Node::parse(mTokenizer, mNoParseTags)) != NULL) lRoot->insertAsLastChild(lChild);
+				readEndTag(mEndName);
+			}
+			if(mNoParseTags.find(mEndName) != mNoParseTags.end()) {
+				// next token must be '>'
+				string lToken;
+				mTokenizer.setDelimiters(" \t\n\r", ">");
+				if(!mTokenizer.getNextToken(lToken)) lRoot->throwError(mTokenizer, "unexpected eof");
+				if(lToken[0] != '>') lRoot->throwError(mTokenizer, "invalid end tag");
+			}
+		} catch(...) {
+			delete lRoot;
+			throw;
+		}
+		mOpenTags.pop_back();
+	}
+	mEvent = eEndTag;
+	return lRoot;
+}
+
+/*!
+The parser must be on a start tag. The element is read without being built, and the parser is left on its end tag event.
+*/
+void XML::Parser::skipSubtree(void)
+{
+	if(mEvent != eStartTag) throw runtime_error("Parser::skipSubtree() the parser is not on a start tag");
+	unsigned int lDepth = mOpenTags.size() - (mEmptyTag ? 0 : 1);
+	do {
+		next();
+	} while(mEvent != eEndTag || mOpenTags.size() != lDepth);
+}
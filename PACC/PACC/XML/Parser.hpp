@@ -0,0 +1,158 @@
+/*
+ *  Portable Agile C++ Classes (PACC)
+ *  Copyright (C) 2001-2003 by Marc Parizeau
+ *  http://manitou.gel.ulaval.ca/~parizeau/PACC
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  Contact:
+ *  Laboratoire de Vision et Systemes Numeriques
+ *  Departement de genie electrique et de genie informatique
+ *  Universite Laval, Quebec, Canada, G1K 7P4
+ *  http://vision.gel.ulaval.ca
+ *
+ */
+/*!
+ * \file PACC/XML/Parser.hpp
+ * \brief Class definition for the streaming %XML parser.
+ * \author Jean-Francois Dupuis
+ */
+
+#ifndef PACC_XML_Parser_hpp_
+#define PACC_XML_Parser_hpp_
+
+#include "PACC/XML/Iterator.hpp"
+#include "PACC/Util/Tokenizer.hpp"
+#include <vector>
+
+namespace PACC { 
+	
+	using namespace std;
+	
+	namespace XML {
+		
+		/*! \brief Streaming %XML parser.
+		\ingroup XML
+		
+		This class reads an %XML stream one element at a time, without building the document tree. Method Parser::next advances to the next event: the start of a data tag, the end of a data tag, a content node (string, comment, CDATA section, declaration, etc.), or the end of the document. Only the current tag and the names of the opened tags are kept in memory. It follows the same syntax rules as the Document parser.
+		
+		A subtree can be materialized on demand with method Parser::readSubtree when the parser is on a start tag. The returned node can be used with the usual ConstIterator interface, so existing read methods can be applied to one element of a large file at a time. Method Parser::skipSubtree skips an element without building it. For example, to read the individuals of a large file:
+		\code
+		ifstream lFile("milestone.obm");
+		Parser lParser(lFile, "milestone.obm");
+		while(lParser.next() != Parser::eEndOfDocument) {
+			if(lParser.getEvent() == Parser::eStartTag && lParser.getName() == "Individual") {
+				Subtree lSubtree(lParser.readSubtree());
+				lIndividual->read(lSubtree.getRoot());
+			}
+		}
+		\endcode
+		*/
+		class Parser {
+		 public:
+			//! Types of parser event.
+			enum Event {
+				eStartTag, //!< Start of a data tag.
+				eEndTag, //!< End of a data tag.
+				eContent, //!< Non markup node (string, comment, CDATA, declaration, etc.).
+				eEndOfDocument //!< End of the stream.
+			};
+			
+			//! Construct a parser for input stream \c inStream, using string \c inName as stream name for error messages.
+			Parser(istream& inStream, const string& inName="");
+			
+			//! Delete parser.
+			~Parser(void);
+			
+			//! Advance to the next event and return it.
+			Event next(void);
+			
+			//! Return the current event.
+			Event getEvent(void) const {return mEvent;}
+			
+			//! Return the current node (tag with its attributes for eStartTag, content node for eContent).
+			const Node& getNode(void) const {return *mNode;}
+			
+			//! Return the tag name for eStartTag and eEndTag, the node value for eContent.
+			const string& getName(void) const {return mEvent == eEndTag ? mEndName : mNode->getValue();}
+			
+			//! Return the value of attribute \c inName of the current start tag.
+			const string& getAttribute(const string& inName) const {return mNode->getAttribute(inName);}
+			
+			//! Return the number of opened data tags.
+			unsigned int getDepth(void) const {return mOpenTags.size();}
+			
+			//! Return the current line number.
+			unsigned int getLineNumber(void) {return mTokenizer.getLineNumber();}
+			
+			//! Read the element of the current start tag and return it as a detached node.
+			Node* readSubtree(void);
+			
+			//! Skip the element of the current start tag.
+			void skipSubtree(void);
+			
+			//! Add \c inTag to the list of tag names for which content should not be parsed by readSubtree.
+			void setNoParse(const string& inTag) {mNoParseTags.insert(inTag);}
+			
+		 protected:
+			Tokenizer mTokenizer; //!< Stream tokenizer.
+			Event mEvent; //!< Current event.
+			Node* mNode; //!< Current node.
+			string mEndName; //!< Tag name of the current end tag.
+			vector<string> mOpenTags; //!< Names of the opened data tags.
+			bool mEmptyTag; //!< The current start tag is also its end tag (<tag/>).
+			set<string> mNoParseTags; //!< Tag names for which content should not be parsed
+			
+			//! Read the end of the current tag: name and '>'.
+			void readEndTag(const string& inName);
+			
+		 private:
+			// disable copy
+			Parser(const Parser&);
+			void operator=(const Parser&);
+		};
+		
+		/*! \brief Owner of a detached subtree.
+		\ingroup XML
+		
+		This class deletes the node returned by Parser::readSubtree when it goes out of scope, and gives a const iterator on it for the read methods.
+		*/
+		class Subtree {
+		 public:
+			//! Take ownership of detached node \c inRoot.
+			explicit Subtree(Node* inRoot=0) : mRoot(inRoot) {}
+			
+			//! Delete the subtree.
+			~Subtree(void) {delete mRoot;}
+			
+			//! Return a const iterator on the root of the subtree.
+			ConstIterator getRoot(void) const {return mRoot;}
+			
+			//! Delete the current subtree and take ownership of detached node \c inRoot.
+			void reset(Node* inRoot=0) {delete mRoot; mRoot = inRoot;}
+			
+		 private:
+			Node* mRoot; //!< Root of the subtree.
+			
+			// disable copy
+			Subtree(const Subtree&);
+			void operator=(const Subtree&);
+		};
+		
+	} // end of XML namespace
+	
+} // end of PACC namespace
+
+#endif // PACC_XML_Parser_hpp_
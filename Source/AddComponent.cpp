@@ -110,19 +110,22 @@ void AddComponent::add(Beagle::GP::Datum& inJunction, BG::Component* inComponent
 
 void AddR::execute(Beagle::GP::Datum& inDatum, Beagle::GP::Context& ioContext) {
 	//Create the new component
-	BG::Passive *lR = new BG::Passive(BG::Passive::eResistor);
+	BGContext& lContext = castObjectT<BGContext&>(ioContext);
+	BG::Passive *lR = lContext.getComponentArena().create<BG::Passive>(BG::Passive::eResistor);
 	add(inDatum,lR,ioContext,RFactor);
 
 }
 
 void AddC::execute(Beagle::GP::Datum& inDatum, Beagle::GP::Context& ioContext) {
 	//Create the new component
-	BG::Passive *lC = new BG::Passive(BG::Passive::eCapacitor);
+	BGContext& lContext = castObjectT<BGContext&>(ioContext);
+	BG::Passive *lC = lContext.getComponentArena().create<BG::Passive>(BG::Passive::eCapacitor);
 	add(inDatum,lC,ioContext,CFactor);
 }
 
 void AddI::execute(Beagle::GP::Datum& inDatum, Beagle::GP::Context& ioContext) {
 	//Create the new component
-	BG::Passive *lI = new BG::Passive(BG::Passive::eInductor);
+	BGContext& lContext = castObjectT<BGContext&>(ioContext);
+	BG::Passive *lI = lContext.getComponentArena().create<BG::Passive>(BG::Passive::eInductor);
 	add(inDatum,lI,ioContext,IFactor);
 }
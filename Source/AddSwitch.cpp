@@ -57,18 +57,18 @@ std::vector<const std::type_info*> AddSwitch::getReturnTypes(GP::Context& ioCont
 }
 
 void AddSwitch::execute(Beagle::GP::Datum& inDatum, Beagle::GP::Context& ioContext) {
-	//Create the new component
-	BG::Switch *lSw = new BG::Switch;
+	BGContext& lContext = castObjectT<BGContext&>(ioContext);
 	
+	//Create the new component
+	BG::Switch *lSw = lContext.getComponentArena().create<BG::Switch>();
 	
-	BGContext& lContext = castObjectT<BGContext&>(ioContext);
 	JunctionPtr& lInJunction = castObjectT<JunctionPtr&>(inDatum);
 	GrowingHybridBondGraph::Handle lGrowingBondGraph = castHandleT<GrowingHybridBondGraph>(lContext.getBondGraph());
 	
 	//Insert R
 	BG::Bond* lNewBond = 0;
 #ifdef INSERT_RESISTANCE_WITH_SWITCH
-	BG::Passive *lR = new BG::Passive(BG::Passive::eResistor);
+	BG::Passive *lR = lContext.getComponentArena().create<BG::Passive>(BG::Passive::eResistor);
 	lGrowingBondGraph->insertComponent(lInJunction.getValue(),lR,lNewBond);
 #endif
 	//Insert switch
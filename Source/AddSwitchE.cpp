@@ -38,8 +38,8 @@ void AddSwitchE::insert(Beagle::GP::Datum& inBond, BG::Junction::JunctionType in
 	GrowingHybridBondGraph::Handle lGrowingBondGraph = castHandleT<GrowingHybridBondGraph>(lContext.getBondGraph());
 	
 	
-	BG::Junction* lNewJunction1 = new BG::Junction(inType1);
-	BG::Junction* lNewJunction2 = new BG::Junction(inType2);
+	BG::Junction* lNewJunction1 = lContext.getComponentArena().create<BG::Junction>(inType1);
+	BG::Junction* lNewJunction2 = lContext.getComponentArena().create<BG::Junction>(inType2);
 	
 	BG::Bond* lNewBond1 = 0;
 	BG::Bond* lNewBond2 = 0;
@@ -52,8 +52,8 @@ void AddSwitchE::insert(Beagle::GP::Datum& inBond, BG::Junction::JunctionType in
 	JunctionPtr lNewJunctionPtr1(lNewJunction1);
 	JunctionPtr lNewJunctionPtr2(lNewJunction2);
 	
-	BG::Switch *lSw1 = new BG::Switch;
-	BG::SwitchME *lSw2 = new BG::SwitchME(lSw1);
+	BG::Switch *lSw1 = lContext.getComponentArena().create<BG::Switch>();
+	BG::SwitchME *lSw2 = lContext.getComponentArena().create<BG::SwitchME>(lSw1);
 	
 	BG::Bond* lNewBond = 0;
 	lGrowingBondGraph->insertComponent(lNewJunction1,lSw1,lNewBond);
@@ -110,6 +110,9 @@ void AnalogFilterEmbryo::execute(Beagle::GP::Datum& outDatum, Beagle::GP::Contex
 	Bond* lBond = lGrowingBondGraph->connect(lJ1_1,lJ0_1);
 	lGrowingBondGraph->connect(lJ0_1,lR);
 	
+	//The causality of the embryo is extended by the insertions of the subtrees
+	lGrowingBondGraph->assignCausality();
+	
 	lReturnID.setValue(lR->getId());
 	
 	//For each modifable site a subtree can be parsed.
@@ -128,8 +128,9 @@ Beagle::Fitness::Handle AnalogFilterEvalOp::evaluate(Beagle::GP::Individual& inI
 						 );
 		lBondGraph->simplify();	
 
-		//Get state equations
-		lBondGraph->assignCausality();
+		//Get state equations, the causality kept valid during the growth is reused
+		if(!lBondGraph->isCausalityValid())
+			lBondGraph->assignCausality();
 		lBondGraph->computeStateEquation();
 		PACC::Matrix lA,lB,lB2,lC,lD,lD2;
 		lBondGraph->getStateMatrix(lA,lB,lB2);
@@ -230,9 +231,11 @@ Beagle::Fitness::Handle AnalogFilterEvalOp::evaluate(Beagle::GP::Individual& inI
 #ifndef WITHOUT_GRAPHVIZ
 		lBondGraph->plotGraph(lFilename.str()+std::string(".svg"));
 #endif
-		ofstream lFileStream((lFilename.str()+std::string(".xml")).c_str());
+		std::ostringstream lFileStream;
 		PACC::XML::Streamer lStreamer(lFileStream);
 		lBondGraph->write(lStreamer);
+		std::string lBuffer = lFileStream.str();
+		mFileWriter->write(lFilename.str()+std::string(".xml"), lBuffer);
 #ifdef STOP_ON_ERROR
 		exit(EXIT_FAILURE);
 #endif
@@ -246,7 +249,7 @@ Beagle::Fitness::Handle AnalogFilterEvalOp::evaluate(Beagle::GP::Individual& inI
 #ifndef WITHOUT_GRAPHVIZ
 		lBondGraph->plotGraph(lFilename.str()+std::string(".svg"));
 #endif
-		ofstream lFileStream((lFilename.str()+std::string(".xml")).c_str());
+		std::ostringstream lFileStream;
 		PACC::XML::Streamer lStreamer(lFileStream);
 		lBondGraph->write(lStreamer);
 		
@@ -254,6 +257,8 @@ Beagle::Fitness::Handle AnalogFilterEvalOp::evaluate(Beagle::GP::Individual& inI
 		lFitness->setValue(0);
 		
 		inIndividual.write(lStreamer);
+		std::string lBuffer = lFileStream.str();
+		mFileWriter->write(lFilename.str()+std::string(".xml"), lBuffer);
 		
 #ifdef STOP_ON_ERROR
 		exit(EXIT_FAILURE);
@@ -106,8 +106,9 @@ Beagle::Fitness::Handle AnalogFilterParameterEvalOp::evaluate(Beagle::Individual
 						 );
 		//lBondGraph->simplify();		
 		
-		//Get state equations
-		lBondGraph->assignCausality();
+		//Get state equations, the causality kept valid during the growth is reused
+		if(!lBondGraph->isCausalityValid())
+			lBondGraph->assignCausality();
 		lBondGraph->computeStateEquation();
 		PACC::Matrix lA,lB,lB2,lC,lD,lD2;
 		lBondGraph->getStateMatrix(lA,lB,lB2);
@@ -0,0 +1,106 @@
+/*
+ *  AsyncFileWriter.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *  
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#include "AsyncFileWriter.h"
+#include <fstream>
+#include <iostream>
+
+AsyncFileWriter::AsyncFileWriter(unsigned int inQueueSize) : mQueueSize(inQueueSize), mWriting(false), mStop(false) {
+	if(mQueueSize > 0)
+		run();
+}
+
+/*! \brief Write the pending files and stop the thread
+ */
+AsyncFileWriter::~AsyncFileWriter() {
+	if(mQueueSize > 0) {
+		mQueueCondition.lock();
+		mStop = true;
+		mQueueCondition.broadcast();
+		mQueueCondition.unlock();
+		Thread::wait();
+	}
+}
+
+/*! \brief Queue the content of a file
+ *  \param inFilename Name of the file to write.
+ *  \param ioBuffer Content of the file, it is empty on return.
+ */
+void AsyncFileWriter::write(const std::string& inFilename, std::string& ioBuffer) {
+	if(mQueueSize == 0) {
+		writeFile(inFilename, ioBuffer);
+		ioBuffer.clear();
+		return;
+	}
+	
+	mQueueCondition.lock();
+	while(mQueue.size() >= mQueueSize)
+		mQueueCondition.wait();
+	mQueue.push_back(std::make_pair(inFilename,std::string()));
+	mQueue.back().second.swap(ioBuffer);
+	mQueueCondition.broadcast();
+	mQueueCondition.unlock();
+}
+
+/*! \brief Wait until all the queued files are written
+ */
+void AsyncFileWriter::flush() {
+	mQueueCondition.lock();
+	while(!mQueue.empty() || mWriting)
+		mQueueCondition.wait();
+	mQueueCondition.unlock();
+}
+
+void AsyncFileWriter::main() {
+	mQueueCondition.lock();
+	while(true) {
+		while(mQueue.empty() && !mStop)
+			mQueueCondition.wait();
+		if(mQueue.empty())
+			break;
+		
+		std::string lFilename;
+		std::string lBuffer;
+		lFilename.swap(mQueue.front().first);
+		lBuffer.swap(mQueue.front().second);
+		mQueue.pop_front();
+		mWriting = true;
+		mQueueCondition.broadcast();
+		mQueueCondition.unlock();
+		
+		writeFile(lFilename, lBuffer);
+		
+		mQueueCondition.lock();
+		mWriting = false;
+		mQueueCondition.broadcast();
+	}
+	mQueueCondition.unlock();
+}
+
+void AsyncFileWriter::writeFile(const std::string& inFilename, const std::string& inBuffer) {
+	std::ofstream lFileStream(inFilename.c_str());
+	if(!lFileStream) {
+		std::cerr << "Unable to write the file " << inFilename << std::endl;
+		return;
+	}
+	lFileStream.write(inBuffer.data(), inBuffer.size());
+}
@@ -0,0 +1,59 @@
+/*
+ *  AsyncFileWriter.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *  
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef AsyncFileWriter_H
+#define AsyncFileWriter_H
+
+#include <PACC/Threading.hpp>
+#include <list>
+#include <string>
+
+/*! \brief Write files from a background thread
+ *  The evaluation threads format their output in a buffer and hand it to the writer, which
+ *	writes it to disk in its own thread. The buffer is swapped into the queue, it is not copied.
+ *	The queue is bounded, a caller waits when it is full. With a queue size of 0, the files
+ *	are written directly by the caller.
+ */
+class AsyncFileWriter : public PACC::Threading::Thread {
+public:
+	explicit AsyncFileWriter(unsigned int inQueueSize = 16);
+	virtual ~AsyncFileWriter();
+	
+	void write(const std::string& inFilename, std::string& ioBuffer);
+	void flush();
+	
+	unsigned int getQueueSize() const { return mQueueSize; }
+	
+protected:
+	virtual void main();
+	
+	static void writeFile(const std::string& inFilename, const std::string& inBuffer);
+	
+private:
+	std::list< std::pair<std::string,std::string> > mQueue; //!< Filename and content of the pending files
+	unsigned int mQueueSize;					//!< Maximum number of pending files
+	bool mWriting;								//!< A file is being written by the thread
+	bool mStop;									//!< Stop the thread once the queue is empty
+	PACC::Threading::Condition mQueueCondition;	//!< Protect the queue and signal its changes
+};
+
+#endif
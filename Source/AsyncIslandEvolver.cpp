@@ -0,0 +1,221 @@
+/*
+ *  AsyncIslandEvolver.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#include "AsyncIslandEvolver.h"
+#include "StructuralHierarchicalFairCompetitionOp.h"
+#include "BondGraphEvalOp.h"
+#include "beagle/Beagle.hpp"
+
+using namespace Beagle;
+
+bool AsyncIslandEvolver::smRunning = false;
+
+/*! \brief Thread running the main loop of a deme
+ *  The operators are applied with the BeagleLock held. They may read the other demes, but only
+ *	modify their own deme and the migration buffers.
+ */
+class AsyncIslandEvolver::Island : public PACC::Threading::Thread {
+public:
+	Island(AsyncIslandEvolver& inEvolver, Deme::Handle inDeme, Context::Handle inContext) :
+		mEvolver(inEvolver), mDeme(inDeme), mContext(inContext) { }
+
+	//! Return the error message of the exception that stopped the island, empty if none.
+	const std::string& getError() const { return mError; }
+	Context& getContext() { return *mContext; }
+
+protected:
+	virtual void main();
+
+	AsyncIslandEvolver& mEvolver;
+	Deme::Handle mDeme;
+	Context::Handle mContext;
+	std::string mError;
+};
+
+/*! \brief Apply the main loop to the deme until its termination
+ */
+void AsyncIslandEvolver::Island::main() {
+	BeagleLock::acquire();
+	try {
+		while(mContext->getContinueFlag()) {
+			mContext->setGeneration(mContext->getGeneration()+1);
+			for(unsigned int i = 0; i < mEvolver.mMainLoopSet.size(); ++i) {
+				mEvolver.mMainLoopSet[i]->operate(*mDeme, *mContext);
+			}
+			//Give the waiting islands a chance between the generations
+			BeagleLock::release();
+			BeagleLock::acquire();
+		}
+	} catch(Beagle::Exception& inException) {
+		mError = inException.getMessage();
+		mEvolver.stopIslands();
+	} catch(std::exception& inException) {
+		mError = inException.what();
+		mEvolver.stopIslands();
+	}
+	BeagleLock::release();
+}
+
+AsyncIslandEvolver::AsyncIslandEvolver() { }
+
+AsyncIslandEvolver::AsyncIslandEvolver(EvaluationOp::Handle inEvalOp) : GP::Evolver(inEvalOp) { }
+
+/*!
+ *  \brief Initialize the evolver, its operators and the system.
+ *  \param ioSystem Evolutionary system.
+ *  \param ioArgc Number of arguments on the command-line.
+ *  \param ioArgv Arguments on the command-line.
+ */
+void AsyncIslandEvolver::initialize(System::Handle ioSystem, int& ioArgc, char** ioArgv)
+{
+	Beagle_StackTraceBeginM();
+	if(ioSystem->getRegister().isRegistered("ec.island.async")) {
+		mAsynchronous = castHandleT<Bool>(ioSystem->getRegister()["ec.island.async"]);
+	} else {
+		mAsynchronous = new Bool(false);
+		Register::Description lDescription(
+										   "Asynchronous islands",
+										   "Bool",
+										   mAsynchronous->serialize(),
+										   "Run the main loop of each deme in its own thread. The demes evolve at their own pace and exchange their migrants without waiting for each other."
+										   );
+		ioSystem->getRegister().addEntry("ec.island.async", mAsynchronous, lDescription);
+	}
+	GP::Evolver::initialize(ioSystem, ioArgc, ioArgv);
+	Beagle_StackTraceEndM("void AsyncIslandEvolver::initialize(System::Handle ioSystem, int& ioArgc, char** ioArgv)");
+}
+
+/*!
+ *  \brief Evolve the vivarium.
+ *  \param ioVivarium Vivarium to evolve.
+ *
+ *  The bootstrap is applied to the demes one after the other, as in the synchronous evolution.
+ *	The main loop of each deme is then run by its own island thread. A worker of the evaluation
+ *	farm doesn't evolve, it serves the evaluations of its master and returns when the master
+ *	closes the connection.
+ */
+void AsyncIslandEvolver::evolve(Vivarium::Handle ioVivarium)
+{
+	Beagle_StackTraceBeginM();
+#ifndef USE_MPI
+	for(OperatorMap::iterator lIter = mOperatorMap.begin(); lIter != mOperatorMap.end(); ++lIter) {
+		BondGraphEvalOp* lEvalOp = dynamic_cast<BondGraphEvalOp*>(&(*lIter->second));
+		if(lEvalOp == NULL || !lEvalOp->isFarmWorker()) continue;
+		ioVivarium->resize(1);
+		Context::Handle lContext = castHandleT<Context>(mSystemHandle->getContextAllocator().allocate());
+		lContext->setSystemHandle(mSystemHandle);
+		lContext->setEvolverHandle(this);
+		lContext->setVivariumHandle(ioVivarium);
+		lContext->setDemeIndex(0);
+		lContext->setDemeHandle((*ioVivarium)[0]);
+		lContext->setGeneration(0);
+		lEvalOp->serveEvaluations(*(*ioVivarium)[0], *lContext);
+		return;
+	}
+#endif
+	if(!mAsynchronous->getWrappedValue()) {
+		GP::Evolver::evolve(ioVivarium);
+		return;
+	}
+	checkMainLoop();
+
+	Beagle_LogDetailedM(
+						mSystemHandle->getLogger(),
+						"evolver", "AsyncIslandEvolver",
+						std::string("Evolving the ")+uint2str(mPopSize->size())+std::string(" demes as asynchronous islands")
+						);
+	ioVivarium->resize(mPopSize->size());
+	for(unsigned int i = 0; i < ioVivarium->size(); ++i) {
+		Context::Handle lContext = castHandleT<Context>(mSystemHandle->getContextAllocator().allocate());
+		lContext->setSystemHandle(mSystemHandle);
+		lContext->setEvolverHandle(this);
+		lContext->setVivariumHandle(ioVivarium);
+		lContext->setDemeIndex(i);
+		lContext->setDemeHandle((*ioVivarium)[i]);
+		lContext->setGeneration(0);
+		lContext->setContinueFlag(true);
+		for(unsigned int j = 0; j < mBootStrapSet.size(); ++j) {
+			mBootStrapSet[j]->operate(*(*ioVivarium)[i], *lContext);
+		}
+		mIslands.push_back(new Island(*this, (*ioVivarium)[i], lContext));
+	}
+
+	BeagleLock::acquire();
+	smRunning = true;
+	for(unsigned int i = 0; i < mIslands.size(); ++i) {
+		mIslands[i]->run();
+	}
+	BeagleLock::release();
+
+	std::string lError;
+	for(unsigned int i = 0; i < mIslands.size(); ++i) {
+		mIslands[i]->wait();
+		if(lError.empty()) lError = mIslands[i]->getError();
+	}
+	smRunning = false;
+	for(unsigned int i = 0; i < mIslands.size(); ++i) {
+		Beagle_LogDetailedM(
+							mSystemHandle->getLogger(),
+							"evolver", "AsyncIslandEvolver",
+							std::string("The deme ")+uint2str(i)+std::string(" stopped at the generation ")+
+							uint2str(mIslands[i]->getContext().getGeneration())
+							);
+		delete mIslands[i];
+	}
+	mIslands.clear();
+
+	if(!lError.empty()) {
+		throw Beagle_RunTimeExceptionM(std::string("AsyncIslandEvolver : Error in island: ")+lError);
+	}
+	Beagle_StackTraceEndM("void AsyncIslandEvolver::evolve(Vivarium::Handle ioVivarium)");
+}
+
+/*!
+ *  \brief Refuse the operators that exchange individuals at the generation barrier.
+ *
+ *  The migration operators of Beagle expect every deme to be at the same generation, and the
+ *	HFC of Beagle drops the migrants that the next deme didn't take yet.
+ */
+void AsyncIslandEvolver::checkMainLoop() const
+{
+	Beagle_StackTraceBeginM();
+	for(unsigned int i = 0; i < mMainLoopSet.size(); ++i) {
+		Operator* lOperator = &(*mMainLoopSet[i]);
+		bool lSynchronous = (dynamic_cast<MigrationOp*>(lOperator) != NULL);
+		if(dynamic_cast<HierarchicalFairCompetitionOp*>(lOperator) != NULL &&
+		   dynamic_cast<StructuralHierarchicalFairCompetitionOp*>(lOperator) == NULL)
+			lSynchronous = true;
+		if(lSynchronous) {
+			throw Beagle_RunTimeExceptionM(std::string("AsyncIslandEvolver : The operator ")+lOperator->getName()+
+										   std::string(" needs synchronous demes, use StructuralHierarchicalFairCompetitionOp or set ec.island.async to 0"));
+		}
+	}
+	Beagle_StackTraceEndM("void AsyncIslandEvolver::checkMainLoop() const");
+}
+
+//! Stop every island at the end of its generation, the BeagleLock must be held.
+void AsyncIslandEvolver::stopIslands()
+{
+	for(unsigned int i = 0; i < mIslands.size(); ++i) {
+		mIslands[i]->getContext().setContinueFlag(false);
+	}
+}
@@ -0,0 +1,72 @@
+/*
+ *  AsyncIslandEvolver.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef AsyncIslandEvolver_H
+#define AsyncIslandEvolver_H
+
+#include <string>
+#include <vector>
+#include <beagle/GP.hpp>
+#include "BeagleLock.h"
+
+/*! \brief Evolver running the demes as asynchronous islands
+ *  When ec.island.async is set, the bootstrap is applied to every deme, then each deme runs its
+ *	own main loop in its own thread until its termination criterion is reached. The operators
+ *	and the Beagle objects are not thread-safe: an island runs its operators while holding the
+ *	BeagleLock, the evaluation operator releases it only around the simulation of the bond graph,
+ *	which uses no Beagle object. The islands thus breed one at a time but simulate concurrently,
+ *	and a deme with slow evaluations doesn't hold back the others. The migrations must not wait
+ *	for the other demes, the migration operators of Beagle are refused,
+ *	StructuralHierarchicalFairCompetitionOp keeps the best migrants until the next deme takes them.
+ *	Without ec.island.async, the usual synchronous evolution is done.
+ */
+class AsyncIslandEvolver : public Beagle::GP::Evolver {
+public:
+	typedef Beagle::AllocatorT<AsyncIslandEvolver,Beagle::GP::Evolver::Alloc> Alloc;
+	typedef Beagle::PointerT<AsyncIslandEvolver,Beagle::GP::Evolver::Handle> Handle;
+	typedef Beagle::ContainerT<AsyncIslandEvolver,Beagle::GP::Evolver::Bag> Bag;
+
+	AsyncIslandEvolver();
+	explicit AsyncIslandEvolver(Beagle::EvaluationOp::Handle inEvalOp);
+	virtual ~AsyncIslandEvolver() {}
+
+	virtual void initialize(Beagle::System::Handle ioSystem, int& ioArgc, char** ioArgv);
+	virtual void evolve(Beagle::Vivarium::Handle ioVivarium);
+
+	//! Return true while the islands are running.
+	static bool isRunning() { return smRunning; }
+
+protected:
+	class Island;
+
+	void checkMainLoop() const;
+	void stopIslands();
+
+	Beagle::Bool::Handle mAsynchronous;		//!< Run the demes as asynchronous islands
+	std::vector<Island*> mIslands;
+
+	static bool smRunning;
+
+	friend class Island;
+};
+
+#endif
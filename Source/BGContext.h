@@ -29,6 +29,8 @@
 #include <beagle/ContainerT.hpp>
 #include <beagle/GP/Context.hpp>
 #include "GrowingBG.h"
+#include "ParametersHolder.h"
+#include "ComponentArena.h"
 
 using namespace Beagle;
 		
@@ -38,12 +40,39 @@ public:
 	typedef PointerT< BGContext, GP::Context::Handle > Handle;
 	typedef ContainerT< BGContext, GP::Context::Bag >	Bag;
 	
-	BGContext() { mSubGeneration = -1; }
-	BGContext(Beagle::Context &inContext) { (Beagle::Context)(*this) = inContext; mSubGeneration = -1; }
-	virtual ~BGContext() { }
+	BGContext() { mSubGeneration = -1; mParametersHolder = new ParametersHolder; mComponentArena = 0; }
+	BGContext(Beagle::Context &inContext) { (Beagle::Context)(*this) = inContext; mSubGeneration = -1; mParametersHolder = new ParametersHolder; mComponentArena = 0; }
+	BGContext(const BGContext& inContext) : Beagle::GP::Context(inContext), mBondGraph(inContext.mBondGraph), mParametersHolder(inContext.mParametersHolder), mSubGeneration(inContext.mSubGeneration), mSubContinueFlag(inContext.mSubContinueFlag), mComponentArena(0) { }
+	virtual ~BGContext() { if(mComponentArena != 0) mComponentArena->release(); }
 	
-	void setBondGraph( GrowingBG::Handle inBondGraph) { mBondGraph = inBondGraph; }
+	//! Copy the context, the component arena stays with each context.
+	BGContext& operator=(const BGContext& inContext) {
+		Beagle::GP::Context::operator=(inContext);
+		mBondGraph = inContext.mBondGraph;
+		mParametersHolder = inContext.mParametersHolder;
+		mSubGeneration = inContext.mSubGeneration;
+		mSubContinueFlag = inContext.mSubContinueFlag;
+		return *this;
+	}
+	
+	void setBondGraph( GrowingBG::Handle inBondGraph) { 
+		mBondGraph = inBondGraph; 
+		if(mBondGraph != NULL)
+			mBondGraph->setComponentArena(&getComponentArena());
+	}
 	GrowingBG::Handle getBondGraph() { return mBondGraph; }
+	
+	/*! \brief Return the arena of the components created by the primitives
+	 *  Each context has its own arena, the parallel evaluation uses one context per thread.
+	 */
+	ComponentArena& getComponentArena() {
+		if(mComponentArena == 0)
+			mComponentArena = new ComponentArena;
+		return *mComponentArena;
+	}
+
+	//! Return the simulation parameters components of the bond graph being evaluated in this context.
+	ParametersHolder::Handle getParametersHolder() { return mParametersHolder; }
 
 	void setSubGeneration(int inGeneration) { mSubGeneration = inGeneration; }
 	int getSubGeneration() const { return mSubGeneration; }
@@ -75,8 +104,10 @@ public:
 	
 protected:
 	GrowingBG::Handle mBondGraph;
+	ParametersHolder::Handle mParametersHolder;
 	int mSubGeneration;
 	bool mSubContinueFlag;
+	ComponentArena* mComponentArena;	//!< Arena of the components built during the tree execution
 };
 
 
@@ -31,8 +31,46 @@
 
 using namespace Beagle;
 
+unsigned long BGFitness::smLastRevision = 0;
+PACC::Threading::Mutex BGFitness::smRevisionMutex;
+
+/*! \brief Return a new revision number
+ *  CheckpointWriteOp only serializes the individuals whose fitness revision changed since the
+ *	previous checkpoint: breeding invalidates the fitness and the evaluation sets a new one.
+ */
+unsigned long BGFitness::newRevision() {
+	smRevisionMutex.lock();
+	unsigned long lRevision = ++smLastRevision;
+	smRevisionMutex.unlock();
+	return lRevision;
+}
+
+/*! \brief Serialize an XML subtree
+ *  Used to keep the parts of the fitness that are decoded on request.
+ */
+static void serializeNode(PACC::XML::ConstIterator inNode, std::string& outXML) {
+	std::ostringstream lStream;
+	PACC::XML::Streamer lStreamer(lStream);
+	inNode->serialize(lStreamer, false);
+	outXML = lStream.str();
+}
+
+/*! \brief Read a bond graph from its serialized <BondGraph> tag
+ */
+static GrowingBG::Handle parseBondGraph(const std::string& inXML) {
+	std::istringstream lStream(inXML);
+	PACC::XML::Document lDocument(lStream);
+	PACC::XML::ConstIterator lNode = lDocument.getFirstDataTag();
+	if(!lNode || lNode->getValue() != "BondGraph")
+		throw Beagle_IOExceptionMessageM("tag <BondGraph> expected!");
+	GrowingBG::Handle lBondGraph = new GrowingHybridBondGraph;
+	lBondGraph->read(lNode);
+	return lBondGraph;
+}
+
 
 void BGFitness::read(PACC::XML::ConstIterator inNode) {	
+	mRevision = newRevision();
 	//	Beagle_StackTraceBeginM();
 	
 	if((inNode->getType()!=PACC::XML::eData) || (inNode->getValue()!="Fitness"))
@@ -45,10 +83,13 @@ void BGFitness::read(PACC::XML::ConstIterator inNode) {
 		if(lType != "LogFitness")
 			throw Beagle_IOExceptionNodeM((*inNode), "fitness type mismatch!");
 		
-		mUncompressedSize.clear();
-		mVariableData.clear();
-		mVariableName.clear();
+		clearData();
 		mStateMatrices.clear();
+		mBondGraph = NULL;
+		mSimplifiedBondGraph = NULL;
+		mRawStateMatrices.clear();
+		mRawBondGraph = NULL;
+		mRawSimplifiedBondGraph.clear();
 		
 		for(PACC::XML::ConstIterator lChild=inNode->getFirstChild(); lChild; lChild=lChild->getNextSibling()) {
 			if(lChild->getValue() == "Obj") {
@@ -70,29 +111,11 @@ void BGFitness::read(PACC::XML::ConstIterator inNode) {
 				
 			}
 			if(lChild->getValue() == "StateMatrices") {
-				for(PACC::XML::ConstIterator lChild2=lChild->getFirstChild(); lChild2; lChild2=lChild2->getNextSibling()) {
-					PACC::Matrix lMatrix;
-					lMatrix.read(lChild2);
-					//MatrixInterface lInterface;
-//					lInterface.read(lMatrix,*lChild2);
-					mStateMatrices.push_back(lMatrix);
-				}
+				if(lChild->getFirstChild())
+					serializeNode(lChild, mRawStateMatrices);
 			}
 			else if(lChild->getValue() == "Data") {
-				mVariableName.push_back(lChild->getAttribute("Name"));
-				mUncompressedSize.push_back( str2uint(lChild->getAttribute("usize")) );
-				if(str2uint(lChild->getAttribute("usize")) != 0) {
-					PACC::XML::ConstIterator lChild2 = lChild->getFirstChild();
-					if(!lChild2) {
-						throw Beagle_IOExceptionNodeM((*lChild), "needed a CDATA value in the <Path> tag!");
-					}
-					if(lChild2->getType() != PACC::XML::eString) {
-						throw Beagle_IOExceptionNodeM((*lChild2), "needed a string value in the <Path> tag!");
-					}
-					mVariableData.push_back(lChild2->getValue());
-				} else {
-					mVariableData.push_back("");
-				}
+				readData(lChild, 0);
 			}
 			else if(lChild->getValue() == "DataSet") {
 				unsigned int lID = str2uint(lChild->getAttribute("ID"));
@@ -106,21 +129,7 @@ void BGFitness::read(PACC::XML::ConstIterator inNode) {
 						lFitness = str2dbl(lChild3->getValue());
 					}
 					else if(lChild2->getValue() == "Data") {
-						mVariableName.push_back(lChild2->getAttribute("Name"));
-						mVariableDataSet.push_back(lID);
-						mUncompressedSize.push_back( str2uint(lChild2->getAttribute("usize")) );
-						if(str2uint(lChild2->getAttribute("usize")) != 0) {
-							PACC::XML::ConstIterator lChild3 = lChild2->getFirstChild();
-							if(!lChild3) {
-								throw Beagle_IOExceptionNodeM((*lChild2), "needed a CDATA value in the <Path> tag!");
-							}
-							if(lChild3->getType() != PACC::XML::eString) {
-								throw Beagle_IOExceptionNodeM((*lChild3), "needed a string value in the <Path> tag!");
-							}
-							mVariableData.push_back(lChild3->getValue());
-						} else {
-							mVariableData.push_back("");
-						}
+						readData(lChild2, lID);
 					}
 				}
 				
@@ -139,15 +148,14 @@ void BGFitness::read(PACC::XML::ConstIterator inNode) {
 				}
 			}
 			else if(lChild->getValue() == "BondGraph") {
-				mBondGraph = new GrowingHybridBondGraph;
-				mBondGraph->read(lChild);
+				mRawBondGraph = new Beagle::String;
+				serializeNode(lChild, mRawBondGraph->getWrappedValue());
 			}	
 			else if(lChild->getValue() == "SimplifiedBondGraph") {
 				PACC::XML::ConstIterator lChild2 = lChild->getFirstChild();
 				if(!lChild2) throw Beagle_IOExceptionNodeM(*inNode, "No simplified bond graph present!");
 				if(lChild2->getValue() == "BondGraph") {
-					mSimplifiedBondGraph = new GrowingHybridBondGraph;
-					mSimplifiedBondGraph->read(lChild2);
+					serializeNode(lChild2, mRawSimplifiedBondGraph);
 				}
 			}
 			else //Ignore anything else
@@ -180,21 +188,21 @@ void BGFitness::write(PACC::XML::Streamer& ioStreamer, bool inIndent) const {
 		ioStreamer.closeTag();
 		
 		//State Matrix
-		ioStreamer.openTag("StateMatrices",inIndent);
-//		MatrixInterface lInterface;		
-		for(unsigned int i = 0; i < mStateMatrices.size(); ++i) {
-			mStateMatrices[i].write(ioStreamer);
-//			lInterface.write(mStateMatrices[i],ioStreamer);
+		if(!mRawStateMatrices.empty()) {
+			ioStreamer.insertStringContent(mRawStateMatrices, false);
+		} else {
+			ioStreamer.openTag("StateMatrices",inIndent);
+//			MatrixInterface lInterface;		
+			for(unsigned int i = 0; i < mStateMatrices.size(); ++i) {
+				mStateMatrices[i].write(ioStreamer);
+//				lInterface.write(mStateMatrices[i],ioStreamer);
+			}
+			ioStreamer.closeTag();
 		}
-		ioStreamer.closeTag();
 		
 		if(mDataSet.size() == 0) {
 			for(unsigned int i = 0; i < mVariableData.size(); ++i) {
-				ioStreamer.openTag("Data", false);
-				ioStreamer.insertAttribute("Name", mVariableName[i]);
-				ioStreamer.insertAttribute("usize", uint2str(mUncompressedSize[i]));
-				ioStreamer.insertStringContent(mVariableData[i]);
-				ioStreamer.closeTag();
+				writeData(ioStreamer, i);
 			}
 		} else {
 			for(std::map<unsigned int, double>::const_iterator lIter = mDataSet.begin(); lIter != mDataSet.end(); ++lIter) {
@@ -205,11 +213,7 @@ void BGFitness::write(PACC::XML::Streamer& ioStreamer, bool inIndent) const {
 				ioStreamer.closeTag();
 				for(unsigned int i = 0; i < mVariableData.size(); ++i) {
 					if(lIter->first == mVariableDataSet[i]) {
-						ioStreamer.openTag("Data", false);
-						ioStreamer.insertAttribute("Name", mVariableName[i]);
-						ioStreamer.insertAttribute("usize", uint2str(mUncompressedSize[i]));
-						ioStreamer.insertStringContent(mVariableData[i]);
-						ioStreamer.closeTag();
+						writeData(ioStreamer, i);
 					}
 				}
 				ioStreamer.closeTag();
@@ -225,10 +229,16 @@ void BGFitness::write(PACC::XML::Streamer& ioStreamer, bool inIndent) const {
 			}		
 			ioStreamer.closeTag();
 		}
-		if(mBondGraph!=NULL) {
+		if(mRawBondGraph != NULL) {
+			ioStreamer.insertStringContent(mRawBondGraph->getWrappedValue(), false);
+		} else if(mBondGraph!=NULL) {
 			mBondGraph->write(ioStreamer,false);
 		}
-		if(mSimplifiedBondGraph!=NULL) {
+		if(!mRawSimplifiedBondGraph.empty()) {
+			ioStreamer.openTag("SimplifiedBondGraph", inIndent);
+			ioStreamer.insertStringContent(mRawSimplifiedBondGraph, false);
+			ioStreamer.closeTag();
+		} else if(mSimplifiedBondGraph!=NULL) {
 			ioStreamer.openTag("SimplifiedBondGraph", inIndent);
 			mSimplifiedBondGraph->write(ioStreamer,false);
 			ioStreamer.closeTag();
@@ -243,15 +253,79 @@ void BGFitness::write(PACC::XML::Streamer& ioStreamer, bool inIndent) const {
 BGFitness& BGFitness::operator=(const BGFitness& inRightFitness) {
 	LogFitness::operator=(inRightFitness);
 	mStateMatrices = inRightFitness.mStateMatrices;
+	mRawStateMatrices = inRightFitness.mRawStateMatrices;
+	//An assigned fitness, like one found in the fitness cache, may belong to another individual
+	mRevision = newRevision();
 	return *this;
 }
 
+/*! \brief Keep the current state of a bond graph that will be modified afterward
+ *  The bond graph is kept in its serialized form, as after a read, instead of a deep copy.
+ *	The evaluation simplifies its working bond graph, so the fitness needs its own version of
+ *	the original one. The text is much smaller than the components and it is written as is in
+ *	the milestones, the bond graph is only rebuilt if getBondGraph is called. The text is never
+ *	modified, the copies of the fitness made by the selection share it.
+ */
+void BGFitness::setBondGraphSnapshot(const GrowingBG& inBondGraph) {
+	std::ostringstream lStream;
+	PACC::XML::Streamer lStreamer(lStream);
+	inBondGraph.write(lStreamer, false);
+	mBondGraph = NULL;
+	mRawBondGraph = new Beagle::String(lStream.str());
+}
+
+/*! \brief Return the bond graph, it is decoded at the first request after a read
+ */
+GrowingBG::Handle BGFitness::getBondGraph() {
+	if(mRawBondGraph != NULL) {
+		mBondGraph = parseBondGraph(mRawBondGraph->getWrappedValue());
+		mRawBondGraph = NULL;
+	}
+	return mBondGraph;
+}
+
+/*! \brief Return the simplified bond graph, it is decoded at the first request after a read
+ */
+GrowingBG::Handle BGFitness::getSimplifiedBondGraph() {
+	if(!mRawSimplifiedBondGraph.empty()) {
+		mSimplifiedBondGraph = parseBondGraph(mRawSimplifiedBondGraph);
+		mRawSimplifiedBondGraph.clear();
+	}
+	return mSimplifiedBondGraph;
+}
+
+void BGFitness::decodeStateMatrices() {
+	if(mRawStateMatrices.empty())
+		return;
+	
+	std::istringstream lStream(mRawStateMatrices);
+	PACC::XML::Document lDocument(lStream);
+	mRawStateMatrices.clear();
+	mStateMatrices.clear();
+	PACC::XML::ConstIterator lNode = lDocument.getFirstDataTag();
+	if(!lNode) return;
+	for(PACC::XML::ConstIterator lChild=lNode->getFirstChild(); lChild; lChild=lChild->getNextSibling()) {
+		PACC::Matrix lMatrix;
+		lMatrix.read(lChild);
+		mStateMatrices.push_back(lMatrix);
+	}
+}
+
 void BGFitness::setValue(float inFitness) {
 	FitnessSimple::setValue(inFitness);
 	mOriginalFitness = FitnessSimple::getValue();
+	mRevision = newRevision();
 }
 
+/*! \brief Set the fitness adjusted by the speciation, the original fitness is kept
+ *  The speciation adjusts every individual at each generation, a new revision is only taken
+ *	when the value changes so that the checkpoints don't write the unchanged individuals again.
+ */
 void BGFitness::setAdjustedValue(float inFitness) {
+	float lPrevious = FitnessSimple::getValue();
+	bool lWasValid = isValid();
 	FitnessSimple::setValue(inFitness);
+	if(!lWasValid || FitnessSimple::getValue() != lPrevious)
+		mRevision = newRevision();
 }
 
@@ -24,9 +24,11 @@
 #define BGFitness_H
 
 #include <beagle/FitnessSimple.hpp>
+#include <beagle/String.hpp>
 #include <string>
 #include <vector>
 #include <PACC/Math.hpp>
+#include <PACC/Threading.hpp>
 #include "LogFitness.h"
 #include "GrowingBG.h"
 
@@ -42,32 +44,49 @@ public:
 	typedef Beagle::ContainerT<BGFitness,LogFitness::Bag>
 	Bag;
 	
-	BGFitness(float inFitness = 0) : LogFitness(inFitness), mOriginalFitness(inFitness) {}
+	BGFitness(float inFitness = 0) : LogFitness(inFitness), mOriginalFitness(inFitness), mRevision(newRevision()) {}
 	~BGFitness() {}
 	
-	void addStateMatrix(const PACC::Matrix& inMatrix) { mStateMatrices.push_back(inMatrix); }
+	void addStateMatrix(const PACC::Matrix& inMatrix) { decodeStateMatrices(); mStateMatrices.push_back(inMatrix); }
+	const std::vector<PACC::Matrix>& getStateMatrices() { decodeStateMatrices(); return mStateMatrices; }
 
 	virtual void read(PACC::XML::ConstIterator inIter);
 	virtual void write(PACC::XML::Streamer& ioStreamer, bool inIndent) const;
 	
 	BGFitness& operator=(const BGFitness& inRightFitness);
 	
-	void setBondGraph( GrowingBG::Handle inBondGraph) { mBondGraph = inBondGraph; }
-	GrowingBG::Handle getBondGraph() { return mBondGraph; }
+	void setBondGraph( GrowingBG::Handle inBondGraph) { mBondGraph = inBondGraph; mRawBondGraph = NULL; }
+	void setBondGraphSnapshot(const GrowingBG& inBondGraph);
+	GrowingBG::Handle getBondGraph();
 	
-	void setSimplifiedBondGraph( GrowingBG::Handle inBondGraph) { mSimplifiedBondGraph = inBondGraph; }
-	GrowingBG::Handle getSimplifiedBondGraph() { return mSimplifiedBondGraph; }
+	void setSimplifiedBondGraph( GrowingBG::Handle inBondGraph) { mSimplifiedBondGraph = inBondGraph; mRawSimplifiedBondGraph.clear(); }
+	GrowingBG::Handle getSimplifiedBondGraph();
 	
 	virtual void setValue(float inFitness);
 	virtual void setAdjustedValue(float inFitness);
 	float getOriginalFitnessValue() const { return mOriginalFitness; }
 	
+	//! Return the revision of the fitness, it changes when the fitness is created, read, assigned, set or adjusted to another value, and is kept by the clones.
+	unsigned long getRevision() const { return mRevision; }
+	
 private:
+	void decodeStateMatrices();
+	static unsigned long newRevision();
+	
 	std::vector<PACC::Matrix> mStateMatrices;
 	GrowingBG::Handle mBondGraph;
 	GrowingBG::Handle mSimplifiedBondGraph;
 	
+	//The XML read of the state matrices and of the bond graphs is kept as is until they are requested
+	std::string mRawStateMatrices;		//!< <StateMatrices> tag not yet decoded
+	Beagle::String::Handle mRawBondGraph;	//!< <BondGraph> tag not yet decoded, shared by the copies of the fitness
+	std::string mRawSimplifiedBondGraph;	//!< <BondGraph> tag of the simplified bond graph not yet decoded
+	
 	float mOriginalFitness;
+	unsigned long mRevision;				//!< Revision of the fitness, never 0
+	
+	static unsigned long smLastRevision;	//!< Last revision given to a fitness
+	static PACC::Threading::Mutex smRevisionMutex;	//!< Protect smLastRevision, the fitness are created by the evaluation threads
 };
 
 #endif
@@ -28,6 +28,8 @@
 #include <beagle/IOException.hpp>
 #include <beagle/Context.hpp>
 #include "VectorUtil.h"
+#include "BondGraphSignature.h"
+#include "GrowingHybridBondGraph.h"
 #include <assert.h>
 
 using namespace Beagle;
@@ -37,6 +39,19 @@ BGSpecies::BGSpecies(GrowingBG::Handle inBondGraph, unsigned int inGeneration, u
 	mBondGraph = inBondGraph;
 }
 
+/*! \brief Write the species with its bond graph, which is needed to match the species again
+ */
+void BGSpecies::write(PACC::XML::Streamer& ioStreamer, bool inIndent) const {
+	Beagle_StackTraceBeginM();
+	ioStreamer.openTag("Species", inIndent);
+	ioStreamer.insertAttribute("id", mId);
+	ioStreamer.insertAttribute("size", mCount);
+	ioStreamer.insertAttribute("age", mAge);
+	mBondGraph->write(ioStreamer, inIndent);
+	ioStreamer.closeTag();
+	Beagle_StackTraceEndM("void BGSpecies::write(PACC::XML::Streamer& ioStreamer, bool inIndent) const");
+}
+
 BGSpeciesHolder::BGSpeciesHolder() : Beagle::Component("BGSpeciesHolder"), mIdCounter(0)
 { }
 
@@ -46,7 +61,8 @@ BGSpecies* BGSpeciesHolder::findSpecies(GrowingBG::Handle inBondGraph, Beagle::C
 }
 
 /*! \brief Find a matching specie
- *  If there is no matching specie, a new one is created
+ *  If there is no matching specie, a new one is created. Only the species with the same
+ *	structural fingerprint are compared with the bond graph.
  *  \param  inBondGraph Bond graph for which a matching specie is needed
  *  \return Assiociated specie
  */
@@ -54,11 +70,15 @@ BGSpecies* BGSpeciesHolder::findSpecies(GrowingBG::Handle inBondGraph, Beagle::C
 	assert(inBondGraph != 0);
 	unsigned int lDeme = ioContext.getDemeIndex();
 	assert(this->size() > lDeme);
+	if(mFingerprintIndex.size() < this->size())
+		mFingerprintIndex.resize(this->size());
 	
-	for(std::map<unsigned int, BGSpecies*>::iterator lIter = (*this)[lDeme].begin(); lIter != (*this)[lDeme].end(); ++lIter) {
-		GrowingBG::Handle lBondGraphObj = lIter->second->getBondGraphObject();
+	unsigned long lFingerprint = BondGraphSignature(inBondGraph->getBondGraph(), false).getFingerprint();
+	std::pair<std::multimap<unsigned long, BGSpecies*>::iterator, std::multimap<unsigned long, BGSpecies*>::iterator> lBucket;
+	lBucket = mFingerprintIndex[lDeme].equal_range(lFingerprint);
+	for(std::multimap<unsigned long, BGSpecies*>::iterator lIter = lBucket.first; lIter != lBucket.second; ++lIter) {
+		assert(lIter->second != 0);
 		if( lIter->second->getBondGraphObject()->getBondGraph()->compare(*inBondGraph->getBondGraph()) ) {
-			assert(lIter->second != 0);
 			outIsNew = false;
 			return lIter->second;
 		}
@@ -70,6 +90,7 @@ BGSpecies* BGSpeciesHolder::findSpecies(GrowingBG::Handle inBondGraph, Beagle::C
 	++mIdCounter;
 	lNewElement = (*this)[lDeme].insert( make_pair(mIdCounter, new BGSpecies(inBondGraph, ioContext.getGeneration(), mIdCounter) ) );
 	assert(lNewElement.first->second != 0);
+	mFingerprintIndex[lDeme].insert( make_pair(lFingerprint, lNewElement.first->second) );
 	return lNewElement.first->second;	
 }
 
@@ -83,43 +104,109 @@ void BGSpeciesHolder::clearCount(Beagle::Context& ioContext) {
 	}
 }
 
+/*! \brief Add a species read from a <Species> tag
+ *  The species keeps its id and its age, its size is counted again by BGSpeciationOp.
+ *  \param  inDeme Deme of the species
+ *  \param  inIter <Species> tag
+ *  \return The species, or the one already holding its id
+ */
+BGSpecies* BGSpeciesHolder::insertSpecies(unsigned int inDeme, PACC::XML::ConstIterator inIter) {
+	Beagle_StackTraceBeginM();
+	if((inIter->getType()!=PACC::XML::eData) || (inIter->getValue()!="Species"))
+		throw Beagle_IOExceptionNodeM(*inIter, "tag <Species> expected!");
+	PACC::XML::ConstIterator lBondGraphTag = inIter->getFirstChild();
+	while(lBondGraphTag && ((lBondGraphTag->getType()!=PACC::XML::eData) || (lBondGraphTag->getValue()!="BondGraph")))
+		lBondGraphTag = lBondGraphTag->getNextSibling();
+	if(!lBondGraphTag)
+		throw Beagle_IOExceptionNodeM(*inIter, "tag <BondGraph> expected!");
+	
+	if(this->size() <= inDeme)
+		this->resize(inDeme+1);
+	if(mFingerprintIndex.size() < this->size())
+		mFingerprintIndex.resize(this->size());
+	
+	unsigned int lId = str2uint(inIter->getAttribute("id"));
+	std::map<unsigned int, BGSpecies*>::iterator lExisting = (*this)[inDeme].find(lId);
+	if(lExisting != (*this)[inDeme].end())
+		return lExisting->second;
+	
+	GrowingBG::Handle lBondGraph = new GrowingHybridBondGraph;
+	lBondGraph->read(lBondGraphTag);
+	BGSpecies* lSpecies = new BGSpecies(lBondGraph, str2uint(inIter->getAttribute("age")), lId);
+	(*this)[inDeme][lId] = lSpecies;
+	unsigned long lFingerprint = BondGraphSignature(lBondGraph->getBondGraph(), false).getFingerprint();
+	mFingerprintIndex[inDeme].insert( make_pair(lFingerprint, lSpecies) );
+	if(lId > mIdCounter)
+		mIdCounter = lId;
+	return lSpecies;
+	Beagle_StackTraceEndM("BGSpecies* BGSpeciesHolder::insertSpecies(unsigned int inDeme, PACC::XML::ConstIterator inIter)");
+}
+
+//! Delete every species, the number of demes is kept.
+void BGSpeciesHolder::clearSpecies() {
+	for(unsigned int lDeme = 0; lDeme < this->size(); ++lDeme) {
+		for(std::map<unsigned int, BGSpecies*>::iterator lIterMap=(*this)[lDeme].begin(); lIterMap!=(*this)[lDeme].end(); ++lIterMap) {
+			delete lIterMap->second;
+		}
+		(*this)[lDeme].clear();
+	}
+	mFingerprintIndex.clear();
+	mIdCounter = 0;
+}
+
+/*! \brief Read the species of a milestone
+ *  The species written before their bond graph was kept can't be matched anymore, they are
+ *	skipped and the individuals of these species get a new one.
+ */
 void BGSpeciesHolder::readWithSystem(PACC::XML::ConstIterator inIter, System& ioSystem)
 {
 	Beagle_StackTraceBeginM();
-	//	if((inIter->getType()!=PACC::XML::eData) || (inIter->getValue()!="BGSpeciesHolder"))
-	//		throw Beagle_IOExceptionNodeM(*inIter, "tag <BGSpeciesHolder> expected!");
-	//	clear();
-	//	
-	//	for(PACC::XML::ConstIterator lChild=inIter->getFirstChild(); lChild; ++lChild) {
-	//		if((lChild->getType()==PACC::XML::eData) && (lChild->getValue()=="Values")) {
-	//			PACC::XML::ConstIterator lChild2 = lChild->getFirstChild();
-	//			if(!lChild2) throw Beagle_IOExceptionNodeM(*lChild, "no value present!");
-	//			if(lChild2->getType() != PACC::XML::eString)
-	//				throw Beagle_IOExceptionNodeM(*lChild2, "no value present!");
-	//			
-	//			std::istringstream lStream(lChild2->getValue().c_str());
-	//			lStream >> *this;
-	//		}
-	//	}
+	if((inIter->getType()!=PACC::XML::eData) || (inIter->getValue()!="BGSpeciesHolder"))
+		throw Beagle_IOExceptionNodeM(*inIter, "tag <BGSpeciesHolder> expected!");
+	//writeContent opens its own tag inside the one of the component
+	PACC::XML::ConstIterator lContent = inIter->getFirstChild();
+	while(lContent && (lContent->getType()!=PACC::XML::eData))
+		lContent = lContent->getNextSibling();
+	if(lContent && (lContent->getValue()=="BGSpeciesHolder"))
+		inIter = lContent;
+	
+	clearSpecies();
+	unsigned int lIdCounter = 0;
+	if(!inIter->getAttribute("counter").empty())
+		lIdCounter = str2uint(inIter->getAttribute("counter"));
+	for(PACC::XML::ConstIterator lDeme=inIter->getFirstChild(); lDeme; ++lDeme) {
+		if((lDeme->getType()!=PACC::XML::eData) || (lDeme->getValue()!="Deme"))
+			continue;
+		unsigned int lDemeIndex = str2uint(lDeme->getAttribute("id"));
+		for(PACC::XML::ConstIterator lSpecies=lDeme->getFirstChild(); lSpecies; ++lSpecies) {
+			if((lSpecies->getType()!=PACC::XML::eData) || (lSpecies->getValue()!="Species"))
+				continue;
+			unsigned int lId = str2uint(lSpecies->getAttribute("id"));
+			if(lId > lIdCounter)
+				lIdCounter = lId;
+			PACC::XML::ConstIterator lBondGraphTag = lSpecies->getFirstChild();
+			while(lBondGraphTag && (lBondGraphTag->getType()!=PACC::XML::eData))
+				lBondGraphTag = lBondGraphTag->getNextSibling();
+			if(lBondGraphTag)
+				insertSpecies(lDemeIndex, lSpecies);
+		}
+	}
+	mIdCounter = lIdCounter;
 	Beagle_StackTraceEndM("void BGSpeciesHolder::readWithSystem(PACC::XML::ConstIterator inIter, System& ioSystem)");
 }
 
-
+/*! \brief Write every species with its bond graph, so that a resumed evolution keeps matching them
+ */
 void BGSpeciesHolder::writeContent(PACC::XML::Streamer& ioStreamer, bool inIndent) const
 {
 	Beagle_StackTraceBeginM();
 	ioStreamer.openTag("BGSpeciesHolder", inIndent);
+	ioStreamer.insertAttribute("counter", mIdCounter);
 	for(unsigned int lDeme = 0; lDeme < this->size(); ++lDeme) {
 		ioStreamer.openTag("Deme", inIndent);
 		ioStreamer.insertAttribute("id", lDeme);
 		for(std::map<unsigned int, BGSpecies*>::const_iterator lIterMap=(*this)[lDeme].begin(); lIterMap!=(*this)[lDeme].end(); ++lIterMap) {
-			if(lIterMap->second->getSize() > 0) {
-				ioStreamer.openTag("Species", false);
-				ioStreamer.insertAttribute("id", lIterMap->first);
-				ioStreamer.insertAttribute("size", lIterMap->second->getSize());
-				ioStreamer.insertAttribute("age", lIterMap->second->getAge());
-				ioStreamer.closeTag();
-			}
+			lIterMap->second->write(ioStreamer, false);
 		}
 		ioStreamer.closeTag();
 	}
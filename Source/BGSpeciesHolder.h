@@ -54,6 +54,7 @@ public:
 	BGSpecies& operator++() { ++mCount; return *this; }
 	//BGSpecies& operator--() { if(mCount>0) --mCount; return *this; };
 	
+	virtual void write(PACC::XML::Streamer& ioStreamer, bool inIndent=true) const;
 };
 
 
@@ -62,6 +63,7 @@ class BGSpeciesHolder : public Beagle::Component, public vector< std::map<unsign
 {
 private:
 	unsigned int mIdCounter;
+	std::vector< std::multimap<unsigned long, BGSpecies*> > mFingerprintIndex; //!< Species of each deme by structural fingerprint
 
 public:
     typedef Beagle::AllocatorT<BGSpeciesHolder,Beagle::Component::Alloc> Alloc;
@@ -75,10 +77,14 @@ public:
 	
 	BGSpecies* findSpecies(GrowingBG::Handle inBondGraph, Beagle::Context& ioContext);
 	BGSpecies* findSpecies(GrowingBG::Handle inBondGraph, Beagle::Context& ioContext, bool& outIsNew);
+	BGSpecies* insertSpecies(unsigned int inDeme, PACC::XML::ConstIterator inIter);
+	unsigned int getIdCounter() const { return mIdCounter; }
 	
 	virtual void readWithSystem(PACC::XML::ConstIterator inIter, Beagle::System& ioSystem);
 	virtual void writeContent(PACC::XML::Streamer& ioStreamer, bool inIndent=true) const;
 
+private:
+	void clearSpecies();
 };
 
 #endif
@@ -0,0 +1,69 @@
+/*
+ *  BeagleLock.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#include "BeagleLock.h"
+
+PACC::Threading::Mutex BeagleLock::smMutex;
+PACC::Threading::TLS BeagleLock::smDepth;
+
+/*! \brief Take the lock, or count one more acquisition if the calling thread already holds it
+ */
+void BeagleLock::acquire() {
+	unsigned long lDepth = (unsigned long)smDepth.getValue();
+	if(lDepth == 0) smMutex.lock();
+	smDepth.setValue((void*)(lDepth+1));
+}
+
+/*! \brief Undo one acquire, the lock is given back when the calling thread released it as often as acquired
+ */
+void BeagleLock::release() {
+	unsigned long lDepth = (unsigned long)smDepth.getValue();
+	if(lDepth == 0) return;
+	smDepth.setValue((void*)(lDepth-1));
+	if(lDepth == 1) smMutex.unlock();
+}
+
+//! Return true if the calling thread holds the lock.
+bool BeagleLock::isHeld() {
+	return smDepth.getValue() != 0;
+}
+
+/*! \brief Give the lock back whatever the number of acquisitions
+ *  \return Number of acquisitions to restore with resume.
+ */
+unsigned long BeagleLock::suspend() {
+	unsigned long lDepth = (unsigned long)smDepth.getValue();
+	if(lDepth > 0) {
+		smDepth.setValue(0);
+		smMutex.unlock();
+	}
+	return lDepth;
+}
+
+/*! \brief Take back the lock given back by suspend
+ *  \param inDepth Number of acquisitions returned by suspend.
+ */
+void BeagleLock::resume(unsigned long inDepth) {
+	if(inDepth == 0) return;
+	smMutex.lock();
+	smDepth.setValue((void*)inDepth);
+}
@@ -0,0 +1,71 @@
+/*
+ *  BeagleLock.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef BeagleLock_H
+#define BeagleLock_H
+
+#include <PACC/Threading.hpp>
+
+/*! \brief Process-wide lock of the Beagle objects
+ *  The reference counts of the Beagle handles are not atomic, and the system, the register, the
+ *	primitive sets and the demes are shared by every thread. A thread other than the main thread
+ *	(an evaluation task, an asynchronous island) must hold this lock whenever it runs Beagle code:
+ *	interpreting a tree, copying a handle, allocating a fitness or logging. The lock is only
+ *	released, with a Release object, around the simulation of a bond graph that is private to
+ *	the thread, which is where the time is spent. The lock is recursive for its owner thread.
+ */
+class BeagleLock {
+public:
+	static void acquire();
+	static void release();
+	static bool isHeld();
+
+	//! Hold the lock for the lifetime of the object.
+	class Guard {
+	public:
+		Guard() { BeagleLock::acquire(); }
+		~Guard() { BeagleLock::release(); }
+	private:
+		Guard(const Guard&);
+		void operator=(const Guard&);
+	};
+
+	//! Let the other threads run Beagle code for the lifetime of the object. No-op if the lock isn't held.
+	class Release {
+	public:
+		Release() : mDepth(BeagleLock::suspend()) { }
+		~Release() { BeagleLock::resume(mDepth); }
+	private:
+		Release(const Release&);
+		void operator=(const Release&);
+		unsigned long mDepth;
+	};
+
+protected:
+	static unsigned long suspend();
+	static void resume(unsigned long inDepth);
+
+	static PACC::Threading::Mutex smMutex;
+	static PACC::Threading::TLS smDepth;	//!< Number of times the calling thread acquired the lock
+};
+
+#endif
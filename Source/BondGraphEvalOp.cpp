@@ -22,9 +22,296 @@
 
 #include "BondGraphEvalOp.h"
 #include "LogFitness.h"
+#include "BGContext.h"
+#include "BondGraphSignature.h"
+#include "LookaheadController.h"
+#include "EvaluationServer.h"
+#include "EvaluationSandbox.h"
+#include "stringcompression.h"
+#include <PACC/XML.hpp>
+#include <cstdlib>
+#include <cmath>
+#include <sstream>
 
 using namespace Beagle;
 
+#ifndef USE_MPI
+/*!
+ *  \brief Evaluation task executed by the evaluation thread pool.
+ *
+ *  Each task owns its own evaluation context, and thus its own bond graph, controller and
+ *  parameters holder. Individuals are pulled one at a time from the pending list of the operator
+ *  and their fitness is stored at the individual index. The fitness values are assigned to the
+ *  individuals afterward by the serial evaluation loop, in the deme order.
+ *
+ *  The shared Beagle objects (system, register, primitive sets, individuals and their handles)
+ *  are not thread-safe, the task runs with the BeagleLock held. The evaluation operator releases
+ *  it around the simulation of the bond graph, the only part that runs concurrently. The fitness
+ *  cache, the file writer, the simulation log names and the lookahead pool are thread-safe.
+ */
+class BondGraphEvalTask : public PACC::Threading::Task {
+public:
+	BondGraphEvalTask(BondGraphEvalOp& inOp, Deme& ioDeme, BGContext::Handle inContext) :
+		mOp(inOp), mDeme(ioDeme), mContext(inContext) { }
+	
+	virtual void main();
+	
+	//! Return the error message of the first exception raised by this task, empty if none.
+	const std::string& getError() const { return mError; }
+	
+protected:
+	BondGraphEvalOp& mOp;
+	Deme& mDeme;
+	BGContext::Handle mContext;
+	std::string mError;
+};
+
+/*!
+ *  \brief Evaluate pending individuals until none are left.
+ */
+void BondGraphEvalTask::main()
+{
+	BeagleLock::Guard lBeagleGuard;
+	unsigned int lIndex;
+	while(mOp.popPendingIndividual(lIndex)) {
+		try {
+			mContext->setIndividualIndex(lIndex);
+			mContext->setIndividualHandle(mDeme[lIndex]);
+			mOp.mParallelFitness[lIndex] = mOp.Beagle::GP::EvaluationOp::evaluate(*mDeme[lIndex], *mContext);
+		} catch(Beagle::Exception& inException) {
+			if(mError.empty()) mError = inException.getMessage();
+		} catch(std::exception& inException) {
+			if(mError.empty()) mError = inException.what();
+		}
+	}
+	mContext->setIndividualHandle(NULL);
+}
+
+/*!
+ *  \brief Evaluation task driving the connection to a worker of the evaluation farm.
+ *
+ *  The individuals are pulled from the same pending list as the evaluation threads, sent to the
+ *  worker and their fitness is read back at the individual index. When the connection is lost
+ *  during an evaluation, or the worker doesn't answer within eval.farm.timeout, the worker most
+ *  likely crashed or hangs on that individual: it is saved in the bug directory and gets a null
+ *  fitness, like a failed local evaluation. The connection is closed, the task then stops and
+ *  leaves the remaining individuals to the other workers. The task holds the BeagleLock except
+ *  while it waits for its worker.
+ */
+class BondGraphFarmTask : public PACC::Threading::Task {
+public:
+	BondGraphFarmTask(BondGraphEvalOp& inOp, Deme& ioDeme, unsigned int inWorker, Fitness::Alloc::Handle inFitnessAlloc,
+					  unsigned int inGeneration, int inSubGeneration) :
+		mOp(inOp), mDeme(ioDeme), mWorker(inWorker), mFitnessAlloc(inFitnessAlloc),
+		mGeneration(inGeneration), mSubGeneration(inSubGeneration), mCrashedIndividual(-1) { }
+	
+	virtual void main();
+	
+	//! Return the error message of the first exception raised by the worker, empty if none.
+	const std::string& getError() const { return mError; }
+	//! Return the individual being evaluated when the connection was lost, -1 if none.
+	int getCrashedIndividual() const { return mCrashedIndividual; }
+	//! Return the error raised by the lost connection.
+	const std::string& getConnectionError() const { return mConnectionError; }
+	
+protected:
+	void readReply(const std::string& inReply, unsigned int inIndex);
+	
+	BondGraphEvalOp& mOp;
+	Deme& mDeme;
+	unsigned int mWorker;
+	Fitness::Alloc::Handle mFitnessAlloc;
+	unsigned int mGeneration;
+	int mSubGeneration;
+	int mCrashedIndividual;
+	std::string mConnectionError;
+	std::string mError;
+};
+
+/*!
+ *  \brief Send pending individuals to the worker until none are left or the worker is lost.
+ */
+void BondGraphFarmTask::main()
+{
+	BeagleLock::Guard lBeagleGuard;
+	unsigned int lIndex;
+	while(mOp.popPendingIndividual(lIndex)) {
+		std::ostringstream lRequest;
+		PACC::XML::Streamer lStreamer(lRequest);
+		lStreamer.openTag("Evaluate", false);
+		lStreamer.insertAttribute("index", uint2str(lIndex));
+		lStreamer.insertAttribute("generation", uint2str(mGeneration));
+		lStreamer.insertAttribute("subgeneration", int2str(mSubGeneration));
+		lStreamer.insertAttribute("racing", dbl2str(mOp.mRacingThreshold));
+		mDeme[lIndex]->write(lStreamer, false);
+		lStreamer.closeTag();
+		
+		std::string lReply;
+		try {
+			//The other tasks can run Beagle code while this one waits for its worker
+			BeagleLock::Release lBeagleRelease;
+			mOp.mFarmConnections[mWorker]->sendMessage(lRequest.str(), mOp.mFarmCompression->getWrappedValue());
+			mOp.mFarmConnections[mWorker]->receiveMessage(lReply);
+		} catch(const PACC::Socket::Exception& inError) {
+			mCrashedIndividual = lIndex;
+			mConnectionError = inError.getMessage();
+			delete mOp.mFarmConnections[mWorker];
+			mOp.mFarmConnections[mWorker] = NULL;
+			
+			std::string lBuffer = lRequest.str();
+			mOp.mFileWriter->write(std::string("bug/individual_crash_")+uint2str(mGeneration)+"_"+uint2str(lIndex)+".xml", lBuffer);
+			Fitness::Handle lFitness = castHandleT<Fitness>(mFitnessAlloc->allocate());
+			castHandleT<FitnessSimple>(lFitness)->setValue(0);
+			mOp.mParallelFitness[lIndex] = lFitness;
+			return;
+		}
+		
+		try {
+			readReply(lReply, lIndex);
+		} catch(Beagle::Exception& inException) {
+			if(mError.empty()) mError = inException.getMessage();
+		} catch(std::exception& inException) {
+			if(mError.empty()) mError = inException.what();
+		}
+	}
+}
+
+/*!
+ *  \brief Read the fitness sent back by the worker.
+ *  \param inReply Reply of the worker.
+ *  \param inIndex Index of the evaluated individual.
+ */
+void BondGraphFarmTask::readReply(const std::string& inReply, unsigned int inIndex)
+{
+	std::istringstream lStream(inReply);
+	PACC::XML::Document lDocument(lStream);
+	PACC::XML::ConstIterator lResult = lDocument.getFirstDataTag();
+	if(lResult && lResult->getValue() == "Error") {
+		PACC::XML::ConstIterator lMessage = lResult->getFirstChild();
+		throw Beagle_RunTimeExceptionM(std::string("Worker ")+mOp.mFarmAddresses[mWorker]+": "+
+									   (lMessage ? lMessage->getValue() : std::string("unknown error")));
+	}
+	if(!lResult || lResult->getValue() != "Result" || str2uint(lResult->getAttribute("index")) != inIndex)
+		throw Beagle_IOExceptionMessageM("tag <Result> expected!");
+	
+	PACC::XML::ConstIterator lNode = lResult->getFirstChild();
+	while(lNode && lNode->getType() != PACC::XML::eData)
+		lNode = lNode->getNextSibling();
+	if(!lNode)
+		throw Beagle_IOExceptionNodeM(*lResult, "tag <Fitness> expected!");
+	
+	Fitness::Handle lFitness = castHandleT<Fitness>(mFitnessAlloc->allocate());
+	lFitness->read(lNode);
+	mOp.mParallelFitness[inIndex] = lFitness;
+}
+
+/*!
+ *  \brief Evaluation of the individuals of a deme in forked processes.
+ *
+ *  The child processes evaluate the individuals with the evaluation operator and send back the
+ *  serialized fitness. An individual that crashes its process, or exceeds the time or memory
+ *  budget, is saved in the bug directory and gets a null fitness, like a failed evaluation.
+ */
+class BondGraphSandbox : public EvaluationSandbox {
+public:
+	BondGraphSandbox(BondGraphEvalOp& inOp, Deme& ioDeme, Context& ioContext) :
+		EvaluationSandbox(inOp.mSandboxProcesses->getWrappedValue(), inOp.mSandboxTimeout->getWrappedValue(),
+						  inOp.mSandboxMemory->getWrappedValue()),
+		mOp(inOp), mDeme(ioDeme), mContext(ioContext), mFitnessAlloc(ioDeme[0]->getFitnessAlloc()), mNbFailures(0) { }
+	
+	//! Return the number of individuals that ended their process.
+	unsigned int getNumberOfFailures() const { return mNbFailures; }
+	
+protected:
+	virtual void prepareChild();
+	virtual std::string runJob(unsigned int inIndex);
+	virtual void receiveResult(unsigned int inIndex, const std::string& inResult);
+	virtual void receiveFailure(unsigned int inIndex, const std::string& inReason);
+	
+	BondGraphEvalOp& mOp;
+	Deme& mDeme;
+	Context& mContext;
+	Fitness::Alloc::Handle mFitnessAlloc;
+	unsigned int mNbFailures;
+};
+
+/*!
+ *  \brief Start the lookahead threads of the child process.
+ *
+ *  The evolver runs no other thread when it forks, the child starts its own lookahead pool.
+ */
+void BondGraphSandbox::prepareChild()
+{
+	LookaheadController::setNumberOfThreads(mOp.mLookaheadThreads->getWrappedValue());
+}
+
+/*!
+ *  \brief Evaluate an individual in the child process.
+ *  \param inIndex Index of the individual in the deme.
+ *  \return Serialized fitness.
+ */
+std::string BondGraphSandbox::runJob(unsigned int inIndex)
+{
+	try {
+		mContext.setIndividualIndex(inIndex);
+		mContext.setIndividualHandle(mDeme[inIndex]);
+		Fitness::Handle lFitness = mOp.Beagle::GP::EvaluationOp::evaluate(*mDeme[inIndex], mContext);
+		
+		std::ostringstream lStream;
+		PACC::XML::Streamer lStreamer(lStream);
+		lFitness->write(lStreamer, false);
+		return lStream.str();
+	} catch(Beagle::Exception& inException) {
+		throw std::runtime_error(inException.getMessage());
+	}
+}
+
+/*!
+ *  \brief Read the fitness sent back by a child process.
+ *  \param inIndex Index of the individual in the deme.
+ *  \param inResult Serialized fitness.
+ */
+void BondGraphSandbox::receiveResult(unsigned int inIndex, const std::string& inResult)
+{
+	std::istringstream lStream(inResult);
+	PACC::XML::Document lDocument(lStream);
+	PACC::XML::ConstIterator lNode = lDocument.getFirstDataTag();
+	if(!lNode)
+		throw Beagle_IOExceptionMessageM("tag <Fitness> expected!");
+	
+	Fitness::Handle lFitness = castHandleT<Fitness>(mFitnessAlloc->allocate());
+	lFitness->read(lNode);
+	mOp.mParallelFitness[inIndex] = lFitness;
+}
+
+/*!
+ *  \brief Penalize an individual that ended its process.
+ *  \param inIndex Index of the individual in the deme.
+ *  \param inReason Description of the end of the process.
+ */
+void BondGraphSandbox::receiveFailure(unsigned int inIndex, const std::string& inReason)
+{
+	++mNbFailures;
+	Beagle_LogDetailedM(
+						mContext.getSystem().getLogger(),
+						"evaluation", "BondGraphEvalOp",
+						std::string("Sandbox process of the individual ")+uint2str(inIndex)+std::string(" ")+
+						inReason+std::string(", the individual gets a null fitness")
+						);
+	
+	std::ostringstream lFileStream;
+	PACC::XML::Streamer lStreamer(lFileStream);
+	mDeme[inIndex]->write(lStreamer);
+	lFileStream << std::endl;
+	std::string lBuffer = lFileStream.str();
+	mOp.mFileWriter->write(std::string("bug/individual_crash_")+uint2str(mContext.getGeneration())+"_"+uint2str(inIndex)+".xml", lBuffer);
+	
+	Fitness::Handle lFitness = castHandleT<Fitness>(mFitnessAlloc->allocate());
+	castHandleT<FitnessSimple>(lFitness)->setValue(0);
+	mOp.mParallelFitness[inIndex] = lFitness;
+}
+#endif
+
 /*!
  *  \brief Construct the individual evaluation operator.
  */
@@ -35,7 +322,27 @@ MPI::GP::EvaluationOp(inName)
 Beagle::GP::EvaluationOp(inName)
 #endif
 { 
+	mRacingThreshold = 0;
+	mRacingAborts = 0;
+	mFileWriter = NULL;
+#ifndef USE_MPI
+	mThreadPool = NULL;
+	mFarmThreadPool = NULL;
+	mNextPending = 0;
+#endif
+}
 
+BondGraphEvalOp::~BondGraphEvalOp()
+{
+#ifndef USE_MPI
+	delete mThreadPool;
+	delete mFarmThreadPool;
+	//Closing the connections stops the workers
+	for(unsigned int i = 0; i < mFarmConnections.size(); ++i) {
+		delete mFarmConnections[i];
+	}
+#endif
+	delete mFileWriter;
 }
 //
 ///*!
@@ -66,6 +373,168 @@ void BondGraphEvalOp::initialize(Beagle::System& ioSystem)
 	Beagle::EvaluationOp::initialize(ioSystem);
 #endif
 	
+	if(ioSystem.getRegister().isRegistered("eval.cache.size")) {
+		mFitnessCacheSize = castHandleT<UInt>(ioSystem.getRegister()["eval.cache.size"]);
+	} else {
+		mFitnessCacheSize = new UInt(1000);
+		Register::Description lDescription(
+										   "Fitness cache size",
+										   "UInt",
+										   mFitnessCacheSize->serialize(),
+										   "Maximum number of simplified bond graphs for which the fitness is kept between generations, 0 disable the cache."
+										   );
+		ioSystem.getRegister().addEntry("eval.cache.size", mFitnessCacheSize, lDescription);
+	}
+	
+	if(ioSystem.getRegister().isRegistered("eval.racing.casefitness")) {
+		mRacingCaseFitness = castHandleT<Double>(ioSystem.getRegister()["eval.racing.casefitness"]);
+	} else {
+		mRacingCaseFitness = new Double(0);
+		Register::Description lDescription(
+										   "Racing case fitness bound",
+										   "Double",
+										   mRacingCaseFitness->serialize(),
+										   "Expected upper bound of the fitness of a single simulation case. When set, the evaluation of an individual stops as soon as the remaining cases can't bring its average over the lowest fitness of the deme, 0 disable the racing. The fitness of a case isn't bounded, it is the inverse of its error, the racing is thus a heuristic: a case over this bound could have saved a stopped individual."
+										   );
+		ioSystem.getRegister().addEntry("eval.racing.casefitness", mRacingCaseFitness, lDescription);
+	}
+	
+	if(ioSystem.getRegister().isRegistered("sim.lookahead.threads")) {
+		mLookaheadThreads = castHandleT<UInt>(ioSystem.getRegister()["sim.lookahead.threads"]);
+	} else {
+		mLookaheadThreads = new UInt(1);
+		Register::Description lDescription(
+										   "Number of lookahead threads",
+										   "UInt",
+										   mLookaheadThreads->serialize(),
+										   "Number of threads used by the lookahead controllers to simulate the switch states, 1 means serial lookahead."
+										   );
+		ioSystem.getRegister().addEntry("sim.lookahead.threads", mLookaheadThreads, lDescription);
+	}
+	if(ioSystem.getRegister().isRegistered("log.data.encoding")) {
+		mLogDataEncoding = castHandleT<String>(ioSystem.getRegister()["log.data.encoding"]);
+	} else {
+		mLogDataEncoding = new String("xor");
+		Register::Description lDescription(
+										   "Encoding of the logged data",
+										   "String",
+										   mLogDataEncoding->serialize(),
+										   "Storage format of the simulation data kept in the fitness: \"xor\" for the binary XOR encoding, \"hex\" for the former text encoding."
+										   );
+		ioSystem.getRegister().addEntry("log.data.encoding", mLogDataEncoding, lDescription);
+	}
+	if(ioSystem.getRegister().isRegistered("log.writer.queue")) {
+		mFileWriterQueue = castHandleT<UInt>(ioSystem.getRegister()["log.writer.queue"]);
+	} else {
+		mFileWriterQueue = new UInt(16);
+		Register::Description lDescription(
+										   "Size of the file writer queue",
+										   "UInt",
+										   mFileWriterQueue->serialize(),
+										   "Number of simulation logs and debug files that can wait to be written by the writer thread, 0 means the files are written by the evaluation."
+										   );
+		ioSystem.getRegister().addEntry("log.writer.queue", mFileWriterQueue, lDescription);
+	}
+	
+#ifndef USE_MPI
+	if(ioSystem.getRegister().isRegistered("eval.thread.number")) {
+		mNumberThreads = castHandleT<UInt>(ioSystem.getRegister()["eval.thread.number"]);
+	} else {
+		mNumberThreads = new UInt(1);
+		Register::Description lDescription(
+										   "Number of evaluation threads",
+										   "UInt",
+										   mNumberThreads->serialize(),
+										   "Number of threads used to evaluate the individuals of a deme, 1 means serial evaluation."
+										   );
+		ioSystem.getRegister().addEntry("eval.thread.number", mNumberThreads, lDescription);
+	}
+	if(ioSystem.getRegister().isRegistered("eval.farm.workers")) {
+		mFarmWorkers = castHandleT<String>(ioSystem.getRegister()["eval.farm.workers"]);
+	} else {
+		mFarmWorkers = new String("");
+		Register::Description lDescription(
+										   "Evaluation farm workers",
+										   "String",
+										   mFarmWorkers->serialize(),
+										   "Comma separated host:port addresses of the worker processes evaluating the individuals, empty means the individuals are evaluated by this process."
+										   );
+		ioSystem.getRegister().addEntry("eval.farm.workers", mFarmWorkers, lDescription);
+	}
+	if(ioSystem.getRegister().isRegistered("eval.farm.port")) {
+		mFarmPort = castHandleT<UInt>(ioSystem.getRegister()["eval.farm.port"]);
+	} else {
+		mFarmPort = new UInt(0);
+		Register::Description lDescription(
+										   "Evaluation farm worker port",
+										   "UInt",
+										   mFarmPort->serialize(),
+										   "Port on which this process serves the evaluations of a master as a worker of the evaluation farm, 0 means this process runs the evolution."
+										   );
+		ioSystem.getRegister().addEntry("eval.farm.port", mFarmPort, lDescription);
+	}
+	if(ioSystem.getRegister().isRegistered("eval.farm.compression")) {
+		mFarmCompression = castHandleT<UInt>(ioSystem.getRegister()["eval.farm.compression"]);
+	} else {
+		mFarmCompression = new UInt(0);
+		Register::Description lDescription(
+										   "Evaluation farm compression level",
+										   "UInt",
+										   mFarmCompression->serialize(),
+										   "Compression level of the messages exchanged with the evaluation farm workers, from 0 (none) to 9. Compression requires PACC built with zlib."
+										   );
+		ioSystem.getRegister().addEntry("eval.farm.compression", mFarmCompression, lDescription);
+	}
+	if(ioSystem.getRegister().isRegistered("eval.farm.timeout")) {
+		mFarmTimeout = castHandleT<Double>(ioSystem.getRegister()["eval.farm.timeout"]);
+	} else {
+		mFarmTimeout = new Double(600);
+		Register::Description lDescription(
+										   "Evaluation farm timeout",
+										   "Double",
+										   mFarmTimeout->serialize(),
+										   "Time in seconds allowed to a worker of the evaluation farm to answer a request, the individual of a worker that doesn't answer gets a null fitness and the worker is dropped. 0 means no limit."
+										   );
+		ioSystem.getRegister().addEntry("eval.farm.timeout", mFarmTimeout, lDescription);
+	}
+	if(ioSystem.getRegister().isRegistered("eval.sandbox.processes")) {
+		mSandboxProcesses = castHandleT<UInt>(ioSystem.getRegister()["eval.sandbox.processes"]);
+	} else {
+		mSandboxProcesses = new UInt(0);
+		Register::Description lDescription(
+										   "Number of sandbox processes",
+										   "UInt",
+										   mSandboxProcesses->serialize(),
+										   "Number of forked processes evaluating the individuals of a deme, a crash only penalizes the individual being evaluated. The evaluation threads and the file writer thread are then disabled, the evolver must not run any thread when it forks. 0 means the individuals are evaluated by this process."
+										   );
+		ioSystem.getRegister().addEntry("eval.sandbox.processes", mSandboxProcesses, lDescription);
+	}
+	if(ioSystem.getRegister().isRegistered("eval.sandbox.timeout")) {
+		mSandboxTimeout = castHandleT<Double>(ioSystem.getRegister()["eval.sandbox.timeout"]);
+	} else {
+		mSandboxTimeout = new Double(0);
+		Register::Description lDescription(
+										   "Sandbox evaluation time budget",
+										   "Double",
+										   mSandboxTimeout->serialize(),
+										   "Wall-clock time in seconds allowed to the evaluation of an individual in a sandbox process, 0 means no limit. A limit is required when sim.lookahead.threads is more than 1."
+										   );
+		ioSystem.getRegister().addEntry("eval.sandbox.timeout", mSandboxTimeout, lDescription);
+	}
+	if(ioSystem.getRegister().isRegistered("eval.sandbox.memory")) {
+		mSandboxMemory = castHandleT<UInt>(ioSystem.getRegister()["eval.sandbox.memory"]);
+	} else {
+		mSandboxMemory = new UInt(0);
+		Register::Description lDescription(
+										   "Sandbox memory budget",
+										   "UInt",
+										   mSandboxMemory->serialize(),
+										   "Address space in MB allowed to a sandbox process, including the memory inherited from the evolver, 0 means no limit."
+										   );
+		ioSystem.getRegister().addEntry("eval.sandbox.memory", mSandboxMemory, lDescription);
+	}
+#endif
+	
 }
 
 
@@ -79,7 +548,545 @@ void BondGraphEvalOp::postInit(Beagle::System& ioSystem)
 	Beagle::MPI::EvaluationOp::postInit(ioSystem);
 #else
 	Beagle::EvaluationOp::postInit(ioSystem);
-#endif	
+#endif
+	
+	mFitnessCache.setCapacity(mFitnessCacheSize->getWrappedValue());
+	
+#ifndef USE_MPI
+	if(mFarmThreadPool == NULL) {
+		std::istringstream lWorkers(mFarmWorkers->getWrappedValue());
+		std::string lAddress;
+		while(std::getline(lWorkers, lAddress, ',')) {
+			std::string::size_type lBegin = lAddress.find_first_not_of(" \t");
+			if(lBegin == std::string::npos) continue;
+			mFarmAddresses.push_back(lAddress.substr(lBegin, lAddress.find_last_not_of(" \t")-lBegin+1));
+		}
+		mFarmConnections.resize(mFarmAddresses.size(), NULL);
+		if(!mFarmAddresses.empty()) {
+			mFarmThreadPool = new PACC::Threading::ThreadPool(mFarmAddresses.size());
+		}
+	}
+	//A forked child only gets the forking thread, the mutexes held by the other threads of the
+	//evolver would stay locked forever in the child. The evolver then runs no helper thread.
+	bool lForking = mSandboxProcesses->getWrappedValue() > 0 && mFarmAddresses.empty();
+	if(lForking && mLookaheadThreads->getWrappedValue() > 1 && mSandboxTimeout->getWrappedValue() <= 0) {
+		throw Beagle_RunTimeExceptionM("BondGraphEvalOp : The sandbox processes run lookahead threads, set eval.sandbox.timeout to stop a hung process");
+	}
+	if(lForking && (mNumberThreads->getWrappedValue() > 1 || mFileWriterQueue->getWrappedValue() > 0 || mLookaheadThreads->getWrappedValue() > 1)) {
+		Beagle_LogInfoM(
+						ioSystem.getLogger(),
+						"evaluation", "BondGraphEvalOp",
+						"The sandbox processes are forked, the evaluation threads and the file writer thread are disabled and the lookahead threads only run in the sandbox processes"
+						);
+	}
+	if(mFileWriter == NULL) {
+		mFileWriter = new AsyncFileWriter(lForking ? 0 : mFileWriterQueue->getWrappedValue());
+	}
+	LookaheadController::setNumberOfThreads(lForking ? 0 : mLookaheadThreads->getWrappedValue());
+	if(!lForking && mNumberThreads->getWrappedValue() > 1 && mThreadPool == NULL) {
+		mThreadPool = new PACC::Threading::ThreadPool(mNumberThreads->getWrappedValue());
+	}
+#else
+	if(mFileWriter == NULL) {
+		mFileWriter = new AsyncFileWriter(mFileWriterQueue->getWrappedValue());
+	}
+	LookaheadController::setNumberOfThreads(mLookaheadThreads->getWrappedValue());
+#endif
+	
+	if(mLogDataEncoding->getWrappedValue() == "hex") {
+		LogFitness::setDataEncoding(LogFitness::eTextHex);
+	} else if(mLogDataEncoding->getWrappedValue() == "xor") {
+		LogFitness::setDataEncoding(LogFitness::eXorBase64);
+	} else {
+		throw Beagle_RunTimeExceptionM("Unknown log data encoding \""+mLogDataEncoding->getWrappedValue()+"\", expected \"xor\" or \"hex\"");
+	}
 }
 
+#ifndef USE_MPI
+/*!
+ *  \brief Evaluate the individuals of a deme.
+ *  \param ioDeme Deme to evaluate.
+ *  \param ioContext Evolutionary context.
+ *
+ *  When evaluation farm workers, sandbox processes or more than one evaluation thread are given,
+ *  the invalid individuals are first evaluated concurrently. The usual serial loop then assigns
+ *  the precomputed fitness in the deme order, which keeps the statistics, the hall-of-fame and
+ *  the logs identical to a serial run. A worker process of the farm never evolves, its evolver calls
+ *  serveEvaluations instead. When the demes run as
+ *  asynchronous islands, the individuals are simulated by the serial loop without racing, each
+ *  island releasing the BeagleLock during its simulations.
+ */
+void BondGraphEvalOp::operate(Deme& ioDeme, Context& ioContext)
+{
+	Beagle_StackTraceBeginM();
+	if(isFarmWorker())
+		throw Beagle_RunTimeExceptionM("BondGraphEvalOp : A worker of the evaluation farm must be run by AsyncIslandEvolver, which serves the evaluations instead of evolving");
+	mRacingAborts = 0;
+	if(AsyncIslandEvolver::isRunning()) {
+		//The islands simulate their own individuals concurrently, and the racing
+		//threshold is computed per deme in shared members
+		mRacingThreshold = 0;
+	} else {
+		updateRacingThreshold(ioDeme);
+		if(mFarmThreadPool != NULL) {
+			evaluateFarm(ioDeme, ioContext);
+		} else if(mSandboxProcesses->getWrappedValue() > 0) {
+			evaluateSandbox(ioDeme, ioContext);
+		} else if(mThreadPool != NULL) {
+			evaluateParallel(ioDeme, ioContext);
+		}
+	}
+	Beagle::GP::EvaluationOp::operate(ioDeme, ioContext);
+	mParallelFitness.clear();
+	
+	if(mFitnessCache.getCapacity() > 0) {
+		Beagle_LogDetailedM(
+							ioContext.getSystem().getLogger(),
+							"evaluation", "BondGraphEvalOp",
+							std::string("Fitness cache: ")+uint2str(mFitnessCache.getHits())+std::string(" hits, ")+
+							uint2str(mFitnessCache.getMisses())+std::string(" misses, ")+
+							uint2str(mFitnessCache.size())+std::string(" entries")
+							);
+	}
+	if(mRacingThreshold > 0) {
+		Beagle_LogDetailedM(
+							ioContext.getSystem().getLogger(),
+							"evaluation", "BondGraphEvalOp",
+							std::string("Racing: ")+uint2str(mRacingAborts)+std::string(" evaluations stopped under the fitness ")+
+							dbl2str(mRacingThreshold)
+							);
+	}
+	Beagle_StackTraceEndM("void BondGraphEvalOp::operate(Deme& ioDeme, Context& ioContext)");
+}
 
+/*!
+ *  \brief Return the fitness of an individual, the one computed by the workers if available.
+ *  \param inIndividual Current individual to evaluate.
+ *  \param ioContext Evolutionary context.
+ *  \return Handle to the fitness value of the individual.
+ */
+Fitness::Handle BondGraphEvalOp::evaluate(Individual& inIndividual, Context& ioContext)
+{
+	Beagle_StackTraceBeginM();
+	unsigned int lIndex = ioContext.getIndividualIndex();
+	if(lIndex < mParallelFitness.size() && mParallelFitness[lIndex] != NULL) {
+		Fitness::Handle lFitness = mParallelFitness[lIndex];
+		mParallelFitness[lIndex] = NULL;
+		return lFitness;
+	}
+	return Beagle::GP::EvaluationOp::evaluate(inIndividual, ioContext);
+	Beagle_StackTraceEndM("Fitness::Handle BondGraphEvalOp::evaluate(Individual& inIndividual, Context& ioContext)");
+}
+
+/*!
+ *  \brief Evaluate the invalid individuals of a deme using the thread pool.
+ *  \param ioDeme Deme to evaluate.
+ *  \param ioContext Evolutionary context.
+ *
+ *  Every worker gets a fresh context so that the bond graph built by the embryo, the controller
+ *  and the parameters holder are never shared between threads. The fitness values are kept in
+ *  mParallelFitness until the serial loop assigns them.
+ */
+void BondGraphEvalOp::evaluateParallel(Deme& ioDeme, Context& ioContext)
+{
+	Beagle_StackTraceBeginM();
+	collectPendingIndividuals(ioDeme);
+	if(mPendingIndividuals.size() < 2) return;
+	
+	Beagle_LogVerboseM(
+					   ioContext.getSystem().getLogger(),
+					   "evaluation", "BondGraphEvalOp",
+					   std::string("Evaluating ")+uint2str(mPendingIndividuals.size())+
+					   std::string(" individuals using ")+uint2str(mThreadPool->size())+std::string(" threads")
+					   );
+	
+	//Contexts are created here since handle reference counting is not thread-safe
+	unsigned int lNbTasks = std::min((unsigned int)mThreadPool->size(), (unsigned int)mPendingIndividuals.size());
+	std::vector<BondGraphEvalTask*> lTasks(lNbTasks);
+	for(unsigned int i = 0; i < lNbTasks; ++i) {
+		lTasks[i] = new BondGraphEvalTask(*this, ioDeme, createTaskContext(ioContext));
+	}
+	for(unsigned int i = 0; i < lNbTasks; ++i) {
+		mThreadPool->push(*lTasks[i]);
+	}
+	
+	std::string lError;
+	for(unsigned int i = 0; i < lNbTasks; ++i) {
+		lTasks[i]->wait();
+		if(lError.empty()) lError = lTasks[i]->getError();
+		delete lTasks[i];
+	}
+	if(!lError.empty()) {
+		throw Beagle_RunTimeExceptionM(std::string("BondGraphEvalOp : Error in evaluation thread: ")+lError);
+	}
+	Beagle_StackTraceEndM("void BondGraphEvalOp::evaluateParallel(Deme& ioDeme, Context& ioContext)");
+}
+
+/*!
+ *  \brief Evaluate the invalid individuals of a deme using the evaluation farm workers.
+ *  \param ioDeme Deme to evaluate.
+ *  \param ioContext Evolutionary context.
+ *
+ *  Each connected worker is driven by its own task. A worker that crashes loses its connection,
+ *  a new connection is tried at the next generation. The individuals left when every worker is
+ *  lost are evaluated by this process in the serial loop.
+ */
+void BondGraphEvalOp::evaluateFarm(Deme& ioDeme, Context& ioContext)
+{
+	Beagle_StackTraceBeginM();
+	BGContext& lContext = castObjectT<BGContext&>(ioContext);
+	collectPendingIndividuals(ioDeme);
+	if(mPendingIndividuals.empty()) return;
+	connectFarmWorkers(ioContext);
+	
+	//Tasks are created here since handle reference counting is not thread-safe
+	std::vector<BondGraphFarmTask*> lTasks;
+	for(unsigned int i = 0; i < mFarmConnections.size(); ++i) {
+		if(mFarmConnections[i] != NULL) {
+			lTasks.push_back(new BondGraphFarmTask(*this, ioDeme, i, ioDeme[0]->getFitnessAlloc(),
+												   ioContext.getGeneration(), lContext.getSubGeneration()));
+		}
+	}
+	if(lTasks.empty()) return;
+	
+	Beagle_LogVerboseM(
+					   ioContext.getSystem().getLogger(),
+					   "evaluation", "BondGraphEvalOp",
+					   std::string("Evaluating ")+uint2str(mPendingIndividuals.size())+
+					   std::string(" individuals using ")+uint2str(lTasks.size())+std::string(" workers")
+					   );
+	for(unsigned int i = 0; i < lTasks.size(); ++i) {
+		mFarmThreadPool->push(*lTasks[i]);
+	}
+	
+	std::string lError;
+	for(unsigned int i = 0; i < lTasks.size(); ++i) {
+		lTasks[i]->wait();
+		if(lError.empty()) lError = lTasks[i]->getError();
+		if(lTasks[i]->getCrashedIndividual() >= 0) {
+			Beagle_LogDetailedM(
+								ioContext.getSystem().getLogger(),
+								"evaluation", "BondGraphEvalOp",
+								std::string("Connection lost while evaluating the individual ")+
+								int2str(lTasks[i]->getCrashedIndividual())+std::string(", the individual gets a null fitness: ")+
+								lTasks[i]->getConnectionError()
+								);
+		}
+		delete lTasks[i];
+	}
+	if(!lError.empty()) {
+		throw Beagle_RunTimeExceptionM(std::string("BondGraphEvalOp : Error in evaluation farm: ")+lError);
+	}
+	Beagle_StackTraceEndM("void BondGraphEvalOp::evaluateFarm(Deme& ioDeme, Context& ioContext)");
+}
+
+/*!
+ *  \brief Evaluate the invalid individuals of a deme in forked processes.
+ *  \param ioDeme Deme to evaluate.
+ *  \param ioContext Evolutionary context.
+ *
+ *  The individuals are split between eval.sandbox.processes child processes. A crash, a hang or
+ *  an exhausted memory budget only costs the individual being evaluated, the rest of its batch
+ *  is given to a new process. The fitness cache entries added by the children are lost. The
+ *  evolver must run no other thread when it forks.
+ */
+void BondGraphEvalOp::evaluateSandbox(Deme& ioDeme, Context& ioContext)
+{
+	Beagle_StackTraceBeginM();
+	collectPendingIndividuals(ioDeme);
+	if(mPendingIndividuals.empty()) return;
+	if(mThreadPool != NULL || mFarmThreadPool != NULL || mFileWriter->getQueueSize() > 0 ||
+	   LookaheadController::hasThreads() || AsyncIslandEvolver::isRunning()) {
+		throw Beagle_RunTimeExceptionM("BondGraphEvalOp : The evaluation sandbox can't fork while other threads are running");
+	}
+	
+	Beagle_LogVerboseM(
+					   ioContext.getSystem().getLogger(),
+					   "evaluation", "BondGraphEvalOp",
+					   std::string("Evaluating ")+uint2str(mPendingIndividuals.size())+
+					   std::string(" individuals using ")+uint2str(mSandboxProcesses->getWrappedValue())+std::string(" sandbox processes")
+					   );
+	BondGraphSandbox lSandbox(*this, ioDeme, ioContext);
+	try {
+		lSandbox.run(mPendingIndividuals);
+	} catch(std::runtime_error& inError) {
+		throw Beagle_RunTimeExceptionM(std::string("BondGraphEvalOp : Error in evaluation sandbox: ")+inError.what());
+	}
+	if(lSandbox.getNumberOfFailures() > 0) {
+		Beagle_LogDetailedM(
+							ioContext.getSystem().getLogger(),
+							"evaluation", "BondGraphEvalOp",
+							uint2str(lSandbox.getNumberOfFailures())+std::string(" individuals ended their sandbox process")
+							);
+	}
+	Beagle_StackTraceEndM("void BondGraphEvalOp::evaluateSandbox(Deme& ioDeme, Context& ioContext)");
+}
+
+/*!
+ *  \brief Connect to the evaluation farm workers that are not connected.
+ *  \param ioContext Evolutionary context.
+ *
+ *  A new connection starts with a <Setup> message giving the simulation cases of the master, so
+ *  that every worker scores the individuals on the same cases, including the random case drawn
+ *  when no target is given. The worker answers <Ready/>.
+ */
+void BondGraphEvalOp::connectFarmWorkers(Context& ioContext)
+{
+	Beagle_StackTraceBeginM();
+	std::string lSetup;
+	for(unsigned int i = 0; i < mFarmConnections.size(); ++i) {
+		if(mFarmConnections[i] != NULL) continue;
+		if(lSetup.empty()) lSetup = writeFarmSetup();
+		try {
+			mFarmConnections[i] = new PACC::Socket::Cafe(PACC::Socket::Address(mFarmAddresses[i]));
+			if(mFarmTimeout->getWrappedValue() > 0)
+				mFarmConnections[i]->setSockOpt(PACC::Socket::eRecvTimeOut, mFarmTimeout->getWrappedValue());
+			std::string lReply;
+			mFarmConnections[i]->sendMessage(lSetup, mFarmCompression->getWrappedValue());
+			mFarmConnections[i]->receiveMessage(lReply);
+			
+			std::istringstream lStream(lReply);
+			PACC::XML::Document lDocument(lStream);
+			PACC::XML::ConstIterator lResult = lDocument.getFirstDataTag();
+			if(!lResult || lResult->getValue() != "Ready")
+				throw PACC::Socket::Exception(PACC::Socket::eOtherError, "unexpected answer to the setup");
+		} catch(const PACC::Socket::Exception& inError) {
+			delete mFarmConnections[i];
+			mFarmConnections[i] = NULL;
+			Beagle_LogDetailedM(
+								ioContext.getSystem().getLogger(),
+								"evaluation", "BondGraphEvalOp",
+								std::string("Unable to connect to the evaluation worker ")+mFarmAddresses[i]+
+								std::string(": ")+inError.getMessage()
+								);
+		}
+	}
+	Beagle_StackTraceEndM("void BondGraphEvalOp::connectFarmWorkers(Context& ioContext)");
+}
+
+/*!
+ *  \brief Build the <Setup> message sent to a new worker of the evaluation farm.
+ *  \return Message holding the binary simulation cases in base64.
+ */
+std::string BondGraphEvalOp::writeFarmSetup() const
+{
+	std::ostringstream lCases(std::ios::out | std::ios::binary);
+	writeSimulationCases(lCases, mSimulationCases);
+	std::string lContent = lCases.str();
+	string2base64(lContent);
+	
+	std::ostringstream lMessage;
+	PACC::XML::Streamer lStreamer(lMessage);
+	lStreamer.openTag("Setup", false);
+	lStreamer.insertStringContent(lContent);
+	lStreamer.closeTag();
+	return lMessage.str();
+}
+
+/*!
+ *  \brief Use the simulation cases of the master, read from its <Setup> message.
+ *  \param inSetup <Setup> tag.
+ *
+ *  The fitness cache is emptied, its entries were computed on other cases.
+ */
+void BondGraphEvalOp::readFarmSetup(PACC::XML::ConstIterator inSetup)
+{
+	Beagle_StackTraceBeginM();
+	std::string lContent;
+	PACC::XML::ConstIterator lNode = inSetup->getFirstChild();
+	if(lNode && lNode->getType() == PACC::XML::eString)
+		lContent = lNode->getValue();
+	base642string(lContent);
+	
+	std::istringstream lCases(lContent, std::ios::in | std::ios::binary);
+	std::vector<SimulationCase> lSimulationCases;
+	try {
+		readSimulationCases(lCases, lSimulationCases);
+	} catch(std::runtime_error& inError) {
+		throw Beagle_IOExceptionNodeM(*inSetup, inError.what());
+	}
+	mSimulationCases = lSimulationCases;
+	mFitnessCache.clear();
+	Beagle_StackTraceEndM("void BondGraphEvalOp::readFarmSetup(PACC::XML::ConstIterator inSetup)");
+}
+
+/*!
+ *  \brief Serve the evaluations of a master as a worker of the evaluation farm.
+ *  \param ioDeme Deme of the worker, used to allocate the received individuals.
+ *  \param ioContext Evolutionary context.
+ *
+ *  Return when the master closes its connection.
+ */
+void BondGraphEvalOp::serveEvaluations(Deme& ioDeme, Context& ioContext)
+{
+	Beagle_StackTraceBeginM();
+	Beagle_LogDetailedM(
+						ioContext.getSystem().getLogger(),
+						"evaluation", "BondGraphEvalOp",
+						std::string("Serving evaluations on port ")+uint2str(mFarmPort->getWrappedValue())
+						);
+	unsigned long lNbEvaluations = 0;
+	try {
+		EvaluationServer lServer(*this, ioDeme, createTaskContext(ioContext),
+								 mFarmPort->getWrappedValue(), mFarmCompression->getWrappedValue());
+		lServer.run(1);
+		lServer.wait();
+		lNbEvaluations = lServer.getNumberOfEvaluations();
+	} catch(const PACC::Socket::Exception& inError) {
+		throw Beagle_RunTimeExceptionM(std::string("BondGraphEvalOp : Error in evaluation server: ")+inError.getMessage());
+	}
+	mFileWriter->flush();
+	Beagle_LogDetailedM(
+						ioContext.getSystem().getLogger(),
+						"evaluation", "BondGraphEvalOp",
+						std::string("Evaluation server stopped after ")+uint2str(lNbEvaluations)+std::string(" evaluations")
+						);
+	Beagle_StackTraceEndM("void BondGraphEvalOp::serveEvaluations(Deme& ioDeme, Context& ioContext)");
+}
+
+/*!
+ *  \brief List the invalid individuals of a deme in the pending list.
+ *  \param ioDeme Deme to evaluate.
+ */
+void BondGraphEvalOp::collectPendingIndividuals(Deme& ioDeme)
+{
+	mParallelFitness.clear();
+	mParallelFitness.resize(ioDeme.size());
+	mPendingIndividuals.clear();
+	for(unsigned int i = 0; i < ioDeme.size(); ++i) {
+		if((ioDeme[i]->getFitness() == NULL) || (ioDeme[i]->getFitness()->isValid() == false)) {
+			mPendingIndividuals.push_back(i);
+		}
+	}
+	mNextPending = 0;
+}
+
+/*!
+ *  \brief Create an evaluation context for a task.
+ *  \param ioContext Evolutionary context.
+ *
+ *  Every task gets a fresh context so that the bond graph built by the embryo, the controller
+ *  and the parameters holder are never shared between threads.
+ */
+BGContext::Handle BondGraphEvalOp::createTaskContext(Context& ioContext)
+{
+	Beagle_StackTraceBeginM();
+	BGContext::Handle lTaskContext = castHandleT<BGContext>(ioContext.getSystem().getContextAllocator().allocate());
+	lTaskContext->setSystemHandle(ioContext.getSystemHandle());
+	lTaskContext->setEvolverHandle(ioContext.getEvolverHandle());
+	lTaskContext->setVivariumHandle(ioContext.getVivariumHandle());
+	lTaskContext->setDemeHandle(ioContext.getDemeHandle());
+	lTaskContext->setDemeIndex(ioContext.getDemeIndex());
+	lTaskContext->setGeneration(ioContext.getGeneration());
+	lTaskContext->setSubGeneration(castObjectT<BGContext&>(ioContext).getSubGeneration());
+	return lTaskContext;
+	Beagle_StackTraceEndM("BGContext::Handle BondGraphEvalOp::createTaskContext(Context& ioContext)");
+}
+
+/*!
+ *  \brief Take the next individual to evaluate from the pending list.
+ *  \param outIndex Index of the individual in the deme.
+ *  \return False if there is no more individual to evaluate.
+ */
+bool BondGraphEvalOp::popPendingIndividual(unsigned int& outIndex)
+{
+	mPendingMutex.lock();
+	bool lAvailable = mNextPending < mPendingIndividuals.size();
+	if(lAvailable) {
+		outIndex = mPendingIndividuals[mNextPending++];
+	}
+	mPendingMutex.unlock();
+	return lAvailable;
+}
+#endif
+
+/*!
+ *  \brief Build the fitness cache key of a simplified bond graph.
+ *  \param inBondGraph Simplified bond graph.
+ *  \param inSimulationCases Identification of the simulation cases used for the evaluation.
+ *  \return Key made of the bond graph encoding, its parameters and the simulation cases.
+ */
+std::string BondGraphEvalOp::getFitnessCacheKey(GrowingBG& inBondGraph, const std::string& inSimulationCases)
+{
+	Beagle_StackTraceBeginM();
+	std::ostringstream lKey;
+	lKey.precision(17);
+	lKey << BondGraphSignature(inBondGraph.getBondGraph(), true).getEncoding() << "|";
+	
+	GA::FloatVector lParameters;
+	inBondGraph.extractParameters(lParameters);
+	for(unsigned int i = 0; i < lParameters.size(); ++i) {
+		lKey << lParameters[i] << ",";
+	}
+	lKey << "|" << inSimulationCases;
+	return lKey.str();
+	Beagle_StackTraceEndM("std::string BondGraphEvalOp::getFitnessCacheKey(GrowingBG& inBondGraph, const std::string& inSimulationCases)");
+}
+
+/*!
+ *  \brief Tell if an individual can't beat the racing threshold anymore.
+ *  \param inFitnessSum Sum of the fitness of the simulated cases.
+ *  \param inNbSimulatedCases Number of simulated cases.
+ *  \param inNbCases Number of cases of the complete evaluation.
+ *  \return True if the average fitness is under the threshold even if every remaining case
+ *	reach the bound eval.racing.casefitness.
+ *
+ *  The fitness of a case is the inverse of its error, up to DBL_MAX for a null error, so no
+ *	bound can be derived. The bound is set by the user and the racing is a heuristic.
+ */
+bool BondGraphEvalOp::isHopeless(double inFitnessSum, unsigned int inNbSimulatedCases, unsigned int inNbCases)
+{
+	if(mRacingThreshold <= 0 || mRacingCaseFitness == NULL || mRacingCaseFitness->getWrappedValue() <= 0)
+		return false;
+	if(inNbSimulatedCases >= inNbCases)
+		return false;
+	
+	double lUpperBound = (inFitnessSum + (inNbCases-inNbSimulatedCases)*mRacingCaseFitness->getWrappedValue())/inNbCases;
+	if(lUpperBound >= mRacingThreshold)
+		return false;
+	
+	mLogMutex.lock();
+	++mRacingAborts;
+	mLogMutex.unlock();
+	return true;
+}
+
+/*!
+ *  \brief Return the fitness of an individual stopped by the racing.
+ *  \param inFitnessSum Sum of the fitness of the simulated cases.
+ *  \param inNbCases Number of cases of the complete evaluation.
+ *  \return The average fitness, the skipped cases counting as null, kept under the racing
+ *	threshold once rounded to the precision of the fitness.
+ */
+float BondGraphEvalOp::getRacingFitness(double inFitnessSum, unsigned int inNbCases) const
+{
+	float lFitness = float(inFitnessSum/inNbCases);
+	if(mRacingThreshold > 0 && lFitness >= mRacingThreshold)
+		lFitness = nextafterf(float(mRacingThreshold), 0);
+	return lFitness;
+}
+
+/*!
+ *  \brief Set the racing threshold from the individuals of the deme that are not reevaluated.
+ *  \param inDeme Deme about to be evaluated.
+ *
+ *  The threshold is the lowest fitness of the individuals with a valid fitness. The null fitness
+ *  given to the failed evaluations are ignored. Without a valid individual, the racing is disabled.
+ */
+void BondGraphEvalOp::updateRacingThreshold(Deme& inDeme)
+{
+	Beagle_StackTraceBeginM();
+	mRacingThreshold = 0;
+	if(mRacingCaseFitness == NULL || mRacingCaseFitness->getWrappedValue() <= 0)
+		return;
+	
+	for(unsigned int i = 0; i < inDeme.size(); ++i) {
+		Fitness::Handle lFitness = inDeme[i]->getFitness();
+		if(lFitness == NULL || !lFitness->isValid())
+			continue;
+		double lValue = castHandleT<FitnessSimple>(lFitness)->getValue();
+		if(lValue > 0 && (mRacingThreshold == 0 || lValue < mRacingThreshold))
+			mRacingThreshold = lValue;
+	}
+	Beagle_StackTraceEndM("void BondGraphEvalOp::updateRacingThreshold(Deme& inDeme)");
+}
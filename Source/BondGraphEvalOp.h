@@ -25,6 +25,30 @@
 
 #include <beagle/GP.hpp>
 #include <stdexcept>
+#include <vector>
+#include <PACC/Threading.hpp>
+#include <PACC/Socket.hpp>
+#include "FitnessCache.h"
+#include "SimulationCase.h"
+#include "GrowingBG.h"
+#include "BGContext.h"
+#include "AsyncFileWriter.h"
+#include "AsyncIslandEvolver.h"
+#include "BeagleLock.h"
+
+/*!
+ *  \brief Call a Beagle logging macro while holding the BeagleLock.
+ *
+ *  The individuals can be simulated concurrently by the evaluation threads or the asynchronous
+ *  islands, the system logger must then be accessed by one thread at a time. The lock is
+ *  recursive, the macro can be used whether the lock is already held or not.
+ */
+#define BondGraph_LogSafeM(LOGCALL) { BeagleLock::Guard lLogGuard; LOGCALL; }
+
+class BondGraphEvalTask;
+class BondGraphFarmTask;
+class BondGraphSandbox;
+class EvaluationServer;
 
 #ifdef USE_MPI
 #include <MPI_GP_EvaluationOp.hpp>
@@ -51,13 +75,73 @@ public:
 #endif
 	
 	explicit BondGraphEvalOp(std::string inName="BondGraphEvalOp");
+	virtual ~BondGraphEvalOp();
 
 	virtual Beagle::Fitness::Handle evaluate(Beagle::GP::Individual& inIndividual, Beagle::GP::Context& ioContext) { throw std::runtime_error("Undefined BondGraphEvalOp::evaluate"); }
 	
 	virtual void initialize(Beagle::System& ioSystem);
 	virtual void postInit(Beagle::System& ioSystem);
 
-
+#ifndef USE_MPI
+	virtual Beagle::Fitness::Handle evaluate(Beagle::Individual& inIndividual, Beagle::Context& ioContext);
+	virtual void operate(Beagle::Deme& ioDeme, Beagle::Context& ioContext);
+	
+	//! Return true if this process is a worker of the evaluation farm.
+	bool isFarmWorker() const { return mFarmPort != NULL && mFarmPort->getWrappedValue() != 0; }
+	void serveEvaluations(Beagle::Deme& ioDeme, Beagle::Context& ioContext);
+	
+protected:
+	void evaluateParallel(Beagle::Deme& ioDeme, Beagle::Context& ioContext);
+	void evaluateFarm(Beagle::Deme& ioDeme, Beagle::Context& ioContext);
+	void evaluateSandbox(Beagle::Deme& ioDeme, Beagle::Context& ioContext);
+	void connectFarmWorkers(Beagle::Context& ioContext);
+	std::string writeFarmSetup() const;
+	void readFarmSetup(PACC::XML::ConstIterator inSetup);
+	void collectPendingIndividuals(Beagle::Deme& ioDeme);
+	BGContext::Handle createTaskContext(Beagle::Context& ioContext);
+	bool popPendingIndividual(unsigned int& outIndex);
+	
+	Beagle::UInt::Handle mNumberThreads;             //!< Number of evaluation threads
+	PACC::Threading::ThreadPool* mThreadPool;        //!< Evaluation thread pool, NULL when evaluating serially
+	std::vector<Beagle::Fitness::Handle> mParallelFitness; //!< Fitness computed by the workers, indexed by individual
+	std::vector<unsigned int> mPendingIndividuals;   //!< Individuals waiting to be evaluated by a worker
+	unsigned int mNextPending;                       //!< Next individual to dispatch in mPendingIndividuals
+	PACC::Threading::Mutex mPendingMutex;            //!< Protect the dispatch of the pending individuals
+	
+	Beagle::String::Handle mFarmWorkers;             //!< Addresses of the evaluation farm workers, empty if none
+	Beagle::UInt::Handle mFarmPort;                  //!< Port of the evaluation server, non-zero for a worker process
+	Beagle::UInt::Handle mFarmCompression;           //!< Compression level of the evaluation farm messages
+	Beagle::Double::Handle mFarmTimeout;             //!< Time allowed to a worker to answer a request
+	std::vector<std::string> mFarmAddresses;         //!< Address of each worker
+	std::vector<PACC::Socket::Cafe*> mFarmConnections; //!< Connection to each worker, NULL when lost
+	PACC::Threading::ThreadPool* mFarmThreadPool;    //!< One thread per worker connection, NULL without workers
+	Beagle::UInt::Handle mSandboxProcesses;          //!< Number of forked evaluation processes, 0 disable the sandbox
+	Beagle::Double::Handle mSandboxTimeout;          //!< Wall-clock time budget of an evaluation in the sandbox
+	Beagle::UInt::Handle mSandboxMemory;             //!< Memory budget of a sandbox process in MB
+	
+	friend class BondGraphEvalTask;
+	friend class BondGraphFarmTask;
+	friend class BondGraphSandbox;
+	friend class EvaluationServer;
+#else
+protected:
+#endif
+	std::string getFitnessCacheKey(GrowingBG& inBondGraph, const std::string& inSimulationCases);
+	bool isHopeless(double inFitnessSum, unsigned int inNbSimulatedCases, unsigned int inNbCases);
+	float getRacingFitness(double inFitnessSum, unsigned int inNbCases) const;
+	void updateRacingThreshold(Beagle::Deme& inDeme);
+	
+	std::vector<SimulationCase> mSimulationCases;    //!< Simulation cases, sent by the master to the farm workers
+	PACC::Threading::Mutex mLogMutex;                //!< Serialize the logging done during evaluation
+	Beagle::UInt::Handle mFitnessCacheSize;          //!< Maximum number of entries of the fitness cache
+	Beagle::UInt::Handle mLookaheadThreads;          //!< Number of threads of the lookahead controllers
+	Beagle::String::Handle mLogDataEncoding;         //!< Storage format of the logged data
+	Beagle::UInt::Handle mFileWriterQueue;           //!< Number of files waiting to be written, 0 writes them inline
+	AsyncFileWriter* mFileWriter;                    //!< Write the simulation logs and debug files in the background
+	FitnessCache mFitnessCache;                      //!< Fitness of the already simulated bond graphs
+	Beagle::Double::Handle mRacingCaseFitness;      //!< Expected upper bound of the fitness of a simulation case, 0 disable the racing
+	double mRacingThreshold;                         //!< Fitness to beat to complete the evaluation, 0 if none
+	unsigned long mRacingAborts;                     //!< Number of evaluations stopped by the racing
 };
 
 
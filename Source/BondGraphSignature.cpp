@@ -0,0 +1,228 @@
+/*
+ *  BondGraphSignature.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#include "BondGraphSignature.h"
+#include <HybridBondGraph.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+#include <typeinfo>
+
+using namespace BG;
+
+/*! \brief Compute the signature of a bond graph
+ *  \param  inBondGraph Bond graph to describe.
+ *  \param  inExact If true, the component values, the bond directions and the order of the switches
+ *		and sources are part of the labels. Otherwise, only the types and connections are described.
+ *  \param  inMaxIterations Maximum number of refinement iterations, 0 means until the labels are stable.
+ */
+BondGraphSignature::BondGraphSignature(BG::BondGraph* inBondGraph, bool inExact, unsigned int inMaxIterations) :
+mExact(inExact), mNumberOfBonds(0)
+{
+	buildAdjacency(inBondGraph);
+	buildInitialLabels(inBondGraph);
+	refine(inMaxIterations);
+}
+
+/*! \brief FNV-1a hash of a string
+ *  The hash is independent of the platform and of the run, it can be stored.
+ */
+unsigned long BondGraphSignature::hash(const std::string& inString, unsigned long inSeed) {
+	unsigned long lHash = inSeed;
+	for(unsigned int i = 0; i < inString.size(); ++i) {
+		lHash ^= (unsigned char)inString[i];
+		lHash *= 16777619UL;
+	}
+	return lHash;
+}
+
+void BondGraphSignature::buildAdjacency(BG::BondGraph* inBondGraph) {
+	std::vector<Component*> lComponents = inBondGraph->getComponents();
+	std::map<Component*,unsigned int> lIndex;
+	for(unsigned int i = 0; i < lComponents.size(); ++i) {
+		if(lComponents[i] != 0) {
+			lIndex[lComponents[i]] = mComponents.size();
+			mComponents.push_back(lComponents[i]);
+		}
+	}
+
+	mNeighbours.resize(mComponents.size());
+	for(unsigned int i = 0; i < mComponents.size(); ++i) {
+		std::vector<Port*> lPorts = mComponents[i]->getPorts();
+		for(unsigned int j = 0; j < lPorts.size(); ++j) {
+			Bond* lBond = lPorts[j]->getBond();
+			if(lBond == 0)
+				continue;
+
+			//The direction of the bond is seen from the component
+			bool lOutgoing = (lBond->getFromPort() == lPorts[j]);
+			Port* lOtherPort = lOutgoing ? lBond->getToPort() : lBond->getFromPort();
+			if(lOtherPort == 0 || lIndex.find(lOtherPort->getComponent()) == lIndex.end())
+				continue;
+
+			mNeighbours[i].push_back( std::make_pair(lOutgoing ? 1 : -1, lIndex[lOtherPort->getComponent()]) );
+			if(lOutgoing)
+				++mNumberOfBonds;
+		}
+	}
+}
+
+void BondGraphSignature::buildInitialLabels(BG::BondGraph* inBondGraph) {
+	std::vector<Source*> lSources = inBondGraph->getSources();
+	std::vector<Switch*> lSwitches;
+	HybridBondGraph* lHybridBondGraph = dynamic_cast<HybridBondGraph*>(inBondGraph);
+	if(lHybridBondGraph != 0)
+		lSwitches = lHybridBondGraph->getSwitches();
+
+	mInitialLabels.resize(mComponents.size());
+	for(unsigned int i = 0; i < mComponents.size(); ++i) {
+		std::ostringstream lLabel;
+		lLabel.precision(17);
+
+		if(Junction* lJunction = dynamic_cast<Junction*>(mComponents[i])) {
+			lLabel << (lJunction->getType() == Junction::eZero ? "J0" : "J1");
+		} else if(Passive* lPassive = dynamic_cast<Passive*>(mComponents[i])) {
+			switch(lPassive->getType()) {
+				case Passive::eResistor:
+					lLabel << "R";
+					break;
+				case Passive::eCapacitor:
+					lLabel << "C";
+					break;
+				case Passive::eInductor:
+					lLabel << "I";
+					break;
+				default:
+					lLabel << "P" << int(lPassive->getType());
+					break;
+			}
+			if(mExact)
+				lLabel << "=" << lPassive->getValue();
+		} else if(Source* lSource = dynamic_cast<Source*>(mComponents[i])) {
+			lLabel << (lSource->getType() == Source::eEffort ? "Se" : "Sf");
+			//The controller address the sources by their order
+			if(mExact)
+				lLabel << "#" << (std::find(lSources.begin(),lSources.end(),lSource) - lSources.begin());
+		} else if(Switch* lSwitch = dynamic_cast<Switch*>(mComponents[i])) {
+			lLabel << "Sw";
+			//The controller address the switches by their order
+			if(mExact)
+				lLabel << "#" << (std::find(lSwitches.begin(),lSwitches.end(),lSwitch) - lSwitches.begin());
+		} else {
+			lLabel << typeid(*mComponents[i]).name();
+		}
+		mInitialLabels[i] = lLabel.str();
+	}
+}
+
+/*! \brief Weisfeiler-Lehman refinement of the component labels
+ *  Each iteration relabels a component with its label and the sorted labels of its neighbours,
+ *	and with the bond direction for an exact signature. The refinement stops when the number of
+ *	distinct labels is stable.
+ */
+void BondGraphSignature::refine(unsigned int inMaxIterations) {
+	mLabels.resize(mComponents.size());
+	for(unsigned int i = 0; i < mComponents.size(); ++i) {
+		mLabels[i] = hash(mInitialLabels[i]);
+	}
+
+	if(inMaxIterations == 0)
+		inMaxIterations = mComponents.size();
+
+	unsigned int lNbLabels = std::set<unsigned long>(mLabels.begin(),mLabels.end()).size();
+	for(unsigned int lIteration = 0; lIteration < inMaxIterations; ++lIteration) {
+		std::vector<unsigned long> lNewLabels(mComponents.size());
+		for(unsigned int i = 0; i < mComponents.size(); ++i) {
+			std::vector< std::pair<int,unsigned long> > lNeighbourLabels(mNeighbours[i].size());
+			for(unsigned int j = 0; j < mNeighbours[i].size(); ++j) {
+				lNeighbourLabels[j] = std::make_pair(mExact ? mNeighbours[i][j].first : 0, mLabels[mNeighbours[i][j].second]);
+			}
+			std::sort(lNeighbourLabels.begin(),lNeighbourLabels.end());
+
+			std::ostringstream lLabel;
+			lLabel << mLabels[i] << "(";
+			for(unsigned int j = 0; j < lNeighbourLabels.size(); ++j) {
+				lLabel << lNeighbourLabels[j].first << ":" << lNeighbourLabels[j].second << ",";
+			}
+			lLabel << ")";
+			lNewLabels[i] = hash(lLabel.str());
+		}
+		mLabels = lNewLabels;
+
+		unsigned int lNewNbLabels = std::set<unsigned long>(mLabels.begin(),mLabels.end()).size();
+		if(lNewNbLabels == lNbLabels)
+			break;
+		lNbLabels = lNewNbLabels;
+	}
+}
+
+/*! \brief Return a hash of the sorted refined labels
+ *  Isomorphic bond graphs have the same fingerprint. Different bond graphs may share a
+ *	fingerprint, a full comparison is still needed to confirm a match.
+ */
+unsigned long BondGraphSignature::getFingerprint() const {
+	std::vector<unsigned long> lLabels(mLabels);
+	std::sort(lLabels.begin(),lLabels.end());
+
+	std::ostringstream lStream;
+	lStream << mComponents.size() << "/" << mNumberOfBonds << ":";
+	for(unsigned int i = 0; i < lLabels.size(); ++i) {
+		lStream << lLabels[i] << ",";
+	}
+	return hash(lStream.str());
+}
+
+/*! \brief Return a complete description of the bond graph
+ *  The components are listed in the order of their refined label, ties are kept in the bond
+ *	graph order. Each component is written with its initial label and the position of its
+ *	neighbours in that list, so the encoding describes the bond graph without ambiguity.
+ */
+std::string BondGraphSignature::getEncoding() const {
+	std::vector< std::pair<unsigned long,unsigned int> > lOrder(mComponents.size());
+	for(unsigned int i = 0; i < mComponents.size(); ++i) {
+		lOrder[i] = std::make_pair(mLabels[i],i);
+	}
+	std::sort(lOrder.begin(),lOrder.end());
+
+	std::vector<unsigned int> lPosition(mComponents.size());
+	for(unsigned int i = 0; i < lOrder.size(); ++i) {
+		lPosition[lOrder[i].second] = i;
+	}
+
+	std::ostringstream lStream;
+	for(unsigned int i = 0; i < lOrder.size(); ++i) {
+		unsigned int lComponent = lOrder[i].second;
+		std::vector< std::pair<int,unsigned int> > lNeighbours(mNeighbours[lComponent].size());
+		for(unsigned int j = 0; j < lNeighbours.size(); ++j) {
+			lNeighbours[j] = std::make_pair(mNeighbours[lComponent][j].first, lPosition[mNeighbours[lComponent][j].second]);
+		}
+		std::sort(lNeighbours.begin(),lNeighbours.end());
+
+		lStream << mInitialLabels[lComponent] << "(";
+		for(unsigned int j = 0; j < lNeighbours.size(); ++j) {
+			lStream << (lNeighbours[j].first > 0 ? ">" : "<") << lNeighbours[j].second;
+		}
+		lStream << ")";
+	}
+	return lStream.str();
+}
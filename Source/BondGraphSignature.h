@@ -0,0 +1,65 @@
+/*
+ *  BondGraphSignature.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef BondGraphSignature_H
+#define BondGraphSignature_H
+
+#include <BondGraph.h>
+#include <string>
+#include <vector>
+#include <utility>
+
+/*! \brief Structural signature of a bond graph
+ *  The components are labeled by their type and iteratively relabeled with the labels of
+ *	their neighbours (Weisfeiler-Lehman refinement). The fingerprint is invariant to the order
+ *	of the components in the bond graph. The encoding lists every component and bond in the
+ *	refined label order, two bond graphs with the same exact encoding are identical.
+ *	An exact signature includes the component values, the bond directions and the order of the
+ *	switches and sources, otherwise only the component types and connections are used.
+ */
+class BondGraphSignature {
+public:
+	BondGraphSignature(BG::BondGraph* inBondGraph, bool inExact, unsigned int inMaxIterations = 0);
+	~BondGraphSignature() {}
+
+	unsigned long getFingerprint() const;
+	std::string getEncoding() const;
+
+	unsigned int getNumberOfComponents() const { return mComponents.size(); }
+	unsigned int getNumberOfBonds() const { return mNumberOfBonds; }
+
+	static unsigned long hash(const std::string& inString, unsigned long inSeed = 2166136261UL);
+
+private:
+	void buildAdjacency(BG::BondGraph* inBondGraph);
+	void buildInitialLabels(BG::BondGraph* inBondGraph);
+	void refine(unsigned int inMaxIterations);
+
+	bool mExact;
+	unsigned int mNumberOfBonds;
+	std::vector<BG::Component*> mComponents;
+	std::vector<std::string> mInitialLabels;	//!< Component type, and value if requested
+	std::vector< std::vector< std::pair<int,unsigned int> > > mNeighbours; //!< Bond direction and neighbour index for each port
+	std::vector<unsigned long> mLabels;			//!< Refined labels
+};
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ *  CheckpointJournal.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#include "CheckpointJournal.h"
+#include <cstdio>
+#include <cstring>
+
+static const char scMagic[] = "HBGGPCK1";
+static const unsigned int scMagicSize = 8;
+static const unsigned int scHeaderSize = 5;
+
+//! FNV-1a checksum of the payload of a record.
+static unsigned int checksum(const std::string& inBuffer) {
+	unsigned int lChecksum = 2166136261U;
+	for(std::string::size_type i = 0; i < inBuffer.size(); ++i) {
+		lChecksum ^= (unsigned char)inBuffer[i];
+		lChecksum *= 16777619U;
+	}
+	return lChecksum;
+}
+
+/*! \brief Open the journal for writing
+ *  \param  inFilename Journal file.
+ *  \param  inRewrite Start a new journal instead of appending to the existing one.
+ *  \return False if the file can't be opened.
+ */
+bool CheckpointJournal::open(const std::string& inFilename, bool inRewrite) {
+	if(mStream.is_open())
+		mStream.close();
+	mStream.clear();
+	mFilename = inFilename;
+	mRewrite = inRewrite;
+	if(mRewrite) {
+		mStream.open((mFilename+".tmp").c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		mStream.write(scMagic, scMagicSize);
+	} else {
+		mStream.open(mFilename.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+	}
+	return mStream.good();
+}
+
+//! Append a record, the failures are reported by the next commit.
+void CheckpointJournal::write(RecordType inType, unsigned int inDeme, unsigned int inIndex, const std::string& inPayload) {
+	unsigned int lHeader[scHeaderSize] = { inType, inDeme, inIndex, (unsigned int)inPayload.size(), checksum(inPayload) };
+	mStream.write((const char*)lHeader, sizeof(lHeader));
+	mStream.write(inPayload.data(), inPayload.size());
+}
+
+/*! \brief End the checkpoint and flush the journal
+ *  A rewritten journal replaces the previous file, the next checkpoints are appended to it.
+ *  \return False if the journal couldn't be written.
+ */
+bool CheckpointJournal::commit(unsigned int inGeneration, unsigned int inNbDemes) {
+	write(eCommit, inNbDemes, inGeneration, std::string());
+	mStream.flush();
+	if(!mStream.good())
+		return false;
+	if(mRewrite) {
+		mStream.close();
+		if(std::rename((mFilename+".tmp").c_str(), mFilename.c_str()) != 0)
+			return false;
+		return open(mFilename, false);
+	}
+	return true;
+}
+
+//! Read the header of the journal, return false if the stream is not a checkpoint journal.
+bool CheckpointJournal::readHeader(std::istream& ioStream) {
+	char lMagic[scMagicSize];
+	ioStream.read(lMagic, scMagicSize);
+	return ioStream.gcount() == (std::streamsize)scMagicSize && std::memcmp(lMagic, scMagic, scMagicSize) == 0;
+}
+
+//! Read the next record, return false at the end of the journal or at a truncated record.
+bool CheckpointJournal::read(std::istream& ioStream, Record& outRecord) {
+	unsigned int lHeader[scHeaderSize];
+	ioStream.read((char*)lHeader, sizeof(lHeader));
+	if(ioStream.gcount() != (std::streamsize)sizeof(lHeader))
+		return false;
+	outRecord.mType = lHeader[0];
+	outRecord.mDeme = lHeader[1];
+	outRecord.mIndex = lHeader[2];
+	outRecord.mPayload.resize(lHeader[3]);
+	if(lHeader[3] > 0) {
+		ioStream.read(&outRecord.mPayload[0], lHeader[3]);
+		if(ioStream.gcount() != (std::streamsize)lHeader[3])
+			return false;
+	}
+	return checksum(outRecord.mPayload) == lHeader[4];
+}
+
+//! FNV-1a hash used to detect the changes of a serialized object between two checkpoints.
+unsigned long CheckpointJournal::hash(const std::string& inBuffer) {
+	unsigned long lHash = (unsigned long)14695981039346656037ULL;
+	for(std::string::size_type i = 0; i < inBuffer.size(); ++i) {
+		lHash ^= (unsigned char)inBuffer[i];
+		lHash *= (unsigned long)1099511628211ULL;
+	}
+	return lHash;
+}
@@ -0,0 +1,74 @@
+/*
+ *  CheckpointJournal.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef CheckpointJournal_H
+#define CheckpointJournal_H
+
+#include <fstream>
+#include <istream>
+#include <string>
+
+/*! \brief Append-only binary file of checkpoint records
+ *  Each record has a fixed header, its type, deme, index, payload size and payload checksum in
+ *	the byte order of the host, followed by its payload. The records of a checkpoint only count
+ *	once its commit record is written, a journal cut by a crash is read up to its last commit.
+ *	A rewritten journal is written beside the file and renamed over it at its first commit, the
+ *	previous journal stays valid until then.
+ */
+class CheckpointJournal {
+public:
+	enum RecordType {
+		eIndividual = 1,	//!< Individual of a deme slot, serialized
+		eDemeSize,			//!< Number of individuals of a deme, in the index
+		eMigrationBuffer,	//!< Migration buffer of a deme, serialized
+		eRandomizer,		//!< Randomizer of the system, serialized
+		eSpecies,			//!< New species of a deme, serialized with its id in the index
+		eThresholds,		//!< Fitness thresholds of the HFC, serialized
+		eCommit				//!< End of a checkpoint, generation in the index and number of demes
+	};
+
+	struct Record {
+		unsigned int mType;
+		unsigned int mDeme;
+		unsigned int mIndex;
+		std::string mPayload;
+	};
+
+	CheckpointJournal() : mRewrite(false) {}
+	~CheckpointJournal() {}
+
+	bool open(const std::string& inFilename, bool inRewrite);
+	bool isOpen() const { return mStream.is_open(); }
+	void write(RecordType inType, unsigned int inDeme, unsigned int inIndex, const std::string& inPayload);
+	bool commit(unsigned int inGeneration, unsigned int inNbDemes);
+
+	static bool readHeader(std::istream& ioStream);
+	static bool read(std::istream& ioStream, Record& outRecord);
+	static unsigned long hash(const std::string& inBuffer);
+
+private:
+	std::string mFilename;
+	std::ofstream mStream;
+	bool mRewrite;		//!< The journal is written beside the file until the next commit
+};
+
+#endif
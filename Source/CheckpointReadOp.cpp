@@ -0,0 +1,224 @@
+/*
+ *  CheckpointReadOp.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#include "CheckpointReadOp.h"
+#include "CheckpointJournal.h"
+#include "CheckpointWriteOp.h"
+#include "BGSpeciesHolder.h"
+#include "StructuralHierarchicalFairCompetitionOp.h"
+#include "beagle/Beagle.hpp"
+#include <PACC/XML.hpp>
+#include <fstream>
+#include <sstream>
+
+using namespace Beagle;
+
+//! Parse the payload of a record, the document must outlive the returned tag.
+static PACC::XML::ConstIterator parsePayload(const std::string& inPayload, PACC::XML::Document& ioDocument) {
+	std::istringstream lStream(inPayload);
+	ioDocument.parse(lStream);
+	PACC::XML::ConstIterator lNode = ioDocument.getFirstDataTag();
+	if(!lNode)
+		throw Beagle_IOExceptionMessageM("empty record in the checkpoint journal!");
+	return lNode;
+}
+
+//! Read an individual of the journal.
+static Individual::Handle readIndividual(PACC::XML::ConstIterator inIter, Deme& ioDeme, Context& ioContext) {
+	Individual::Handle lIndividual = castHandleT<Individual>(ioDeme.getTypeAlloc()->allocate());
+	lIndividual->readWithContext(inIter, ioContext);
+	return lIndividual;
+}
+
+/*! \brief Read the migration buffer of a deme
+ *  The buffer can hold many individuals, they are parsed and read one at a time by the
+ *	streaming parser instead of building the document of the whole buffer.
+ */
+static void readMigrationBuffer(const std::string& inPayload, Deme& ioDeme, Context& ioContext) {
+	std::istringstream lStream(inPayload);
+	PACC::XML::Parser lParser(lStream);
+	while(lParser.next() != PACC::XML::Parser::eStartTag) {
+		if(lParser.getEvent() == PACC::XML::Parser::eEndOfDocument)
+			throw Beagle_IOExceptionMessageM("empty record in the checkpoint journal!");
+	}
+	for(PACC::XML::Parser::Event lEvent = lParser.next(); lEvent != PACC::XML::Parser::eEndTag; lEvent = lParser.next()) {
+		if(lEvent == PACC::XML::Parser::eEndOfDocument)
+			throw Beagle_IOExceptionMessageM("truncated migration buffer in the checkpoint journal!");
+		if(lEvent == PACC::XML::Parser::eStartTag) {
+			PACC::XML::Subtree lIndividual(lParser.readSubtree());
+			ioDeme.getMigrationBuffer().push_back(readIndividual(lIndividual.getRoot(), ioDeme, ioContext));
+		}
+	}
+}
+
+CheckpointReadOp::CheckpointReadOp(std::string inName) :
+Beagle::Operator(inName), mGeneration(0)
+{ }
+
+void CheckpointReadOp::initialize(Beagle::System& ioSystem) {
+	Beagle_StackTraceBeginM();
+	if(ioSystem.getRegister().isRegistered("ck.restart.file")) {
+		mRestartFile = castHandleT<String>(ioSystem.getRegister()["ck.restart.file"]);
+	} else {
+		mRestartFile = new String("");
+		Register::Description lDescription(
+										   "Checkpoint journal to restart from",
+										   "String",
+										   mRestartFile->serialize(),
+										   "Checkpoint journal written with ck.journal.file to resume the evolution from, empty to start a new evolution."
+										   );
+		ioSystem.getRegister().addEntry("ck.restart.file", mRestartFile, lDescription);
+	}
+	Beagle_StackTraceEndM("void CheckpointReadOp::initialize(Beagle::System& ioSystem)");
+}
+
+/*! \brief Read the journal at the first deme, and set the generation of every deme
+ *  \param  ioDeme Current deme.
+ *  \param  ioContext Evolutionary context.
+ */
+void CheckpointReadOp::operate(Deme& ioDeme, Context& ioContext) {
+	Beagle_StackTraceBeginM();
+	if(mRestartFile->getWrappedValue().empty()) return;
+	if(ioContext.getDemeIndex() == 0)
+		readJournal(ioContext);
+	ioContext.setGeneration(mGeneration);
+	Beagle_StackTraceEndM("void CheckpointReadOp::operate(Deme& ioDeme, Context& ioContext)");
+}
+
+/*! \brief Replay the journal up to its last commit and rebuild the evolution state
+ *  Only the last committed version of a record is parsed.
+ */
+void CheckpointReadOp::readJournal(Context& ioContext) {
+	Beagle_StackTraceBeginM();
+	const std::string& lFilename = mRestartFile->getWrappedValue();
+	std::ifstream lStream(lFilename.c_str(), std::ios::in | std::ios::binary);
+	if(!lStream)
+		throw Beagle_IOExceptionMessageM(std::string("could not open the checkpoint journal ")+lFilename);
+	if(!CheckpointJournal::readHeader(lStream))
+		throw Beagle_IOExceptionMessageM(lFilename+std::string(" is not a checkpoint journal!"));
+
+	//Committed state of the journal
+	std::vector< std::vector<std::string> > lIndividuals;
+	std::vector<std::string> lMigrationBuffers;
+	std::vector<CheckpointJournal::Record> lSpecies;
+	std::string lRandomizer;
+	std::string lThresholds;
+	unsigned int lNbDemes = 0;
+	bool lCommitted = false;
+
+	std::vector<CheckpointJournal::Record> lPending;
+	CheckpointJournal::Record lRecord;
+	while(CheckpointJournal::read(lStream, lRecord)) {
+		if(lRecord.mType != CheckpointJournal::eCommit) {
+			lPending.push_back(lRecord);
+			continue;
+		}
+		lNbDemes = lRecord.mDeme;
+		mGeneration = lRecord.mIndex;
+		lIndividuals.resize(lNbDemes);
+		lMigrationBuffers.resize(lNbDemes);
+		for(unsigned int i = 0; i < lPending.size(); ++i) {
+			CheckpointJournal::Record& lChange = lPending[i];
+			if(lChange.mType != CheckpointJournal::eRandomizer && lChange.mType != CheckpointJournal::eThresholds && lChange.mDeme >= lNbDemes)
+				throw Beagle_IOExceptionMessageM(std::string("corrupted checkpoint journal ")+lFilename);
+			switch(lChange.mType) {
+				case CheckpointJournal::eDemeSize:
+					lIndividuals[lChange.mDeme].resize(lChange.mIndex);
+					break;
+				case CheckpointJournal::eIndividual:
+					if(lChange.mIndex >= lIndividuals[lChange.mDeme].size())
+						throw Beagle_IOExceptionMessageM(std::string("corrupted checkpoint journal ")+lFilename);
+					lIndividuals[lChange.mDeme][lChange.mIndex].swap(lChange.mPayload);
+					break;
+				case CheckpointJournal::eMigrationBuffer:
+					lMigrationBuffers[lChange.mDeme].swap(lChange.mPayload);
+					break;
+				case CheckpointJournal::eRandomizer:
+					lRandomizer.swap(lChange.mPayload);
+					break;
+				case CheckpointJournal::eSpecies:
+					lSpecies.push_back(lChange);
+					break;
+				case CheckpointJournal::eThresholds:
+					lThresholds.swap(lChange.mPayload);
+					break;
+				default:
+					throw Beagle_IOExceptionMessageM(std::string("unknown record in the checkpoint journal ")+lFilename);
+			}
+		}
+		lPending.clear();
+		lCommitted = true;
+	}
+	if(!lCommitted)
+		throw Beagle_IOExceptionMessageM(std::string("no complete checkpoint in the journal ")+lFilename);
+
+	Vivarium& lVivarium = ioContext.getVivarium();
+	if(lNbDemes != lVivarium.size())
+		throw Beagle_RunTimeExceptionM(std::string("The checkpoint journal has ")+uint2str(lNbDemes)+
+									   std::string(" demes, the vivarium has ")+uint2str(lVivarium.size()));
+
+	for(unsigned int i = 0; i < lNbDemes; ++i) {
+		Deme& lDeme = *lVivarium[i];
+		lDeme.clear();
+		for(unsigned int j = 0; j < lIndividuals[i].size(); ++j) {
+			if(lIndividuals[i][j].empty())
+				throw Beagle_IOExceptionMessageM(std::string("missing individual in the checkpoint journal ")+lFilename);
+			PACC::XML::Document lDocument;
+			lDeme.push_back(readIndividual(parsePayload(lIndividuals[i][j], lDocument), lDeme, ioContext));
+		}
+		lIndividuals[i].clear();
+
+		lDeme.getMigrationBuffer().clear();
+		if(!lMigrationBuffers[i].empty())
+			readMigrationBuffer(lMigrationBuffers[i], lDeme, ioContext);
+		lDeme.getStats()->setInvalid();
+	}
+	lVivarium.getStats()->setInvalid();
+
+	if(!lRandomizer.empty()) {
+		PACC::XML::Document lDocument;
+		ioContext.getSystem().getRandomizer().readWithSystem(parsePayload(lRandomizer, lDocument), ioContext.getSystem());
+	}
+
+	Beagle::Component::Handle lHolderComponent = ioContext.getSystem().getComponent("BGSpeciesHolder");
+	if(lHolderComponent != NULL) {
+		BGSpeciesHolder::Handle lSpeciesHolder = castHandleT<BGSpeciesHolder>(lHolderComponent);
+		for(unsigned int i = 0; i < lSpecies.size(); ++i) {
+			PACC::XML::Document lDocument;
+			lSpeciesHolder->insertSpecies(lSpecies[i].mDeme, parsePayload(lSpecies[i].mPayload, lDocument));
+		}
+	}
+
+	StructuralHierarchicalFairCompetitionOp* lHFCOp = CheckpointWriteOp::findHFCOp(ioContext);
+	if(lHFCOp != NULL && !lThresholds.empty() && lVivarium[0]->size() > 0) {
+		PACC::XML::Document lDocument;
+		lHFCOp->readThresholds(parsePayload(lThresholds, lDocument), *(*lVivarium[0])[0]->getFitnessAlloc());
+	}
+
+	Beagle_LogInfoM(
+					ioContext.getSystem().getLogger(),
+					"checkpoint", "CheckpointReadOp",
+					std::string("Evolution resumed at the generation ")+uint2str(mGeneration)+
+					std::string(" from the checkpoint journal ")+lFilename
+					);
+	Beagle_StackTraceEndM("void CheckpointReadOp::readJournal(Context& ioContext)");
+}
@@ -0,0 +1,55 @@
+/*
+ *  CheckpointReadOp.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef CheckpointReadOp_H
+#define CheckpointReadOp_H
+
+#include <string>
+#include <beagle/Operator.hpp>
+#include <beagle/String.hpp>
+
+/*! \brief Resume the evolution from a checkpoint journal
+ *  Used in the bootstrap set in place of MilestoneReadOp. The journal written by CheckpointWriteOp
+ *	is replayed up to its last complete checkpoint, and the vivarium, the randomizer, the species
+ *	and the HFC thresholds are rebuilt from it when the first deme is bootstrapped. The hall-of-fame
+ *	and the statistics are not in the journal, they are computed again by the next generation.
+ */
+class CheckpointReadOp : public Beagle::Operator {
+public:
+	typedef Beagle::AllocatorT<CheckpointReadOp,Beagle::Operator::Alloc> Alloc;
+	typedef Beagle::PointerT<CheckpointReadOp,Beagle::Operator::Handle> Handle;
+	typedef Beagle::ContainerT<CheckpointReadOp,Beagle::Operator::Bag> Bag;
+
+	explicit CheckpointReadOp(std::string inName="CheckpointReadOp");
+	virtual ~CheckpointReadOp() { }
+
+	virtual void initialize(Beagle::System& ioSystem);
+	virtual void operate(Beagle::Deme& ioDeme, Beagle::Context& ioContext);
+
+protected:
+	void readJournal(Beagle::Context& ioContext);
+
+	Beagle::String::Handle mRestartFile;	//!< Journal to resume from, empty to start a new evolution
+	unsigned int mGeneration;				//!< Generation of the checkpoint read
+};
+
+#endif
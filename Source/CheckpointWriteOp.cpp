@@ -0,0 +1,205 @@
+/*
+ *  CheckpointWriteOp.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#include "CheckpointWriteOp.h"
+#include "BGFitness.h"
+#include "BGSpeciesHolder.h"
+#include "StructuralHierarchicalFairCompetitionOp.h"
+#include "beagle/Beagle.hpp"
+#include <sstream>
+
+using namespace Beagle;
+
+CheckpointWriteOp::CheckpointWriteOp(std::string inName) :
+Beagle::Operator(inName), mNbAppended(0), mLastSpeciesId(0)
+{ }
+
+void CheckpointWriteOp::initialize(Beagle::System& ioSystem) {
+	Beagle_StackTraceBeginM();
+	if(ioSystem.getRegister().isRegistered("ck.journal.file")) {
+		mJournalFile = castHandleT<String>(ioSystem.getRegister()["ck.journal.file"]);
+	} else {
+		mJournalFile = new String("");
+		Register::Description lDescription(
+										   "Checkpoint journal",
+										   "String",
+										   mJournalFile->serialize(),
+										   "Binary journal of the incremental checkpoints, empty to disable them. The evolution can be resumed from it with ck.restart.file."
+										   );
+		ioSystem.getRegister().addEntry("ck.journal.file", mJournalFile, lDescription);
+	}
+
+	if(ioSystem.getRegister().isRegistered("ck.journal.interval")) {
+		mInterval = castHandleT<UInt>(ioSystem.getRegister()["ck.journal.interval"]);
+	} else {
+		mInterval = new UInt(1);
+		Register::Description lDescription(
+										   "Checkpoint interval",
+										   "UInt",
+										   mInterval->serialize(),
+										   "Number of generations between two checkpoints."
+										   );
+		ioSystem.getRegister().addEntry("ck.journal.interval", mInterval, lDescription);
+	}
+
+	if(ioSystem.getRegister().isRegistered("ck.journal.compact")) {
+		mCompaction = castHandleT<UInt>(ioSystem.getRegister()["ck.journal.compact"]);
+	} else {
+		mCompaction = new UInt(20);
+		Register::Description lDescription(
+										   "Checkpoints between journal rewrites",
+										   "UInt",
+										   mCompaction->serialize(),
+										   "Number of checkpoints appended to the journal before it is rewritten with the full state of the evolution, 0 to never rewrite it."
+										   );
+		ioSystem.getRegister().addEntry("ck.journal.compact", mCompaction, lDescription);
+	}
+	Beagle_StackTraceEndM("void CheckpointWriteOp::initialize(Beagle::System& ioSystem)");
+}
+
+/*! \brief Append a checkpoint to the journal after the last deme
+ *  \param  ioDeme Current deme.
+ *  \param  ioContext Evolutionary context.
+ */
+void CheckpointWriteOp::operate(Deme& ioDeme, Context& ioContext) {
+	Beagle_StackTraceBeginM();
+	if(mJournalFile->getWrappedValue().empty()) return;
+	if(ioContext.getDemeIndex() != (ioContext.getVivarium().size()-1)) return;
+	if(mInterval->getWrappedValue() == 0) return;
+	if((ioContext.getGeneration() % mInterval->getWrappedValue()) != 0) return;
+
+	bool lRewrite = !mJournal.isOpen() || (mCompaction->getWrappedValue() > 0 && mNbAppended >= mCompaction->getWrappedValue());
+	if(lRewrite) {
+		if(!mJournal.open(mJournalFile->getWrappedValue(), true))
+			throw Beagle_IOExceptionMessageM(std::string("could not open the checkpoint journal ")+mJournalFile->getWrappedValue());
+		mIndividuals.clear();
+		mMigrationBuffers.clear();
+		mThresholds = Signature(0, 0);
+		mLastSpeciesId = 0;
+	}
+
+	//Individuals and migration buffers
+	Vivarium& lVivarium = ioContext.getVivarium();
+	mIndividuals.resize(lVivarium.size());
+	mMigrationBuffers.resize(lVivarium.size(), Signature(0, 0));
+	unsigned int lNbIndividuals = 0;
+	for(unsigned int i = 0; i < lVivarium.size(); ++i) {
+		Deme& lDeme = *lVivarium[i];
+		if(mIndividuals[i].size() != lDeme.size() || lRewrite) {
+			mIndividuals[i].resize(lDeme.size(), 0);
+			mJournal.write(CheckpointJournal::eDemeSize, i, lDeme.size(), std::string());
+		}
+		for(unsigned int j = 0; j < lDeme.size(); ++j) {
+			unsigned long lRevision = 0;
+			if(lDeme[j]->getFitness() != NULL && lDeme[j]->getFitness()->isValid()) {
+				BGFitness* lFitness = dynamic_cast<BGFitness*>(&(*lDeme[j]->getFitness()));
+				if(lFitness != NULL) lRevision = lFitness->getRevision();
+			}
+			if(lRevision != 0 && lRevision == mIndividuals[i][j]) continue;
+			
+			std::ostringstream lStream;
+			PACC::XML::Streamer lStreamer(lStream);
+			lDeme[j]->write(lStreamer, false);
+			mJournal.write(CheckpointJournal::eIndividual, i, j, lStream.str());
+			mIndividuals[i][j] = lRevision;
+			++lNbIndividuals;
+		}
+
+		std::ostringstream lStream;
+		PACC::XML::Streamer lStreamer(lStream);
+		lStreamer.openTag("MigrationBuffer", false);
+		for(unsigned int j = 0; j < lDeme.getMigrationBuffer().size(); ++j) {
+			lDeme.getMigrationBuffer()[j]->write(lStreamer, false);
+		}
+		lStreamer.closeTag();
+		writeChanged(CheckpointJournal::eMigrationBuffer, i, 0, lStream.str(), mMigrationBuffers[i]);
+	}
+
+	//Randomizer, it changes at every generation
+	{
+		std::ostringstream lStream;
+		PACC::XML::Streamer lStreamer(lStream);
+		ioContext.getSystem().getRandomizer().write(lStreamer, false);
+		mJournal.write(CheckpointJournal::eRandomizer, 0, 0, lStream.str());
+	}
+
+	//The species never change once created, only the new ones are written
+	Beagle::Component::Handle lHolderComponent = ioContext.getSystem().getComponent("BGSpeciesHolder");
+	if(lHolderComponent != NULL) {
+		BGSpeciesHolder::Handle lSpeciesHolder = castHandleT<BGSpeciesHolder>(lHolderComponent);
+		for(unsigned int i = 0; i < lSpeciesHolder->size(); ++i) {
+			for(std::map<unsigned int, BGSpecies*>::const_iterator lIterMap=(*lSpeciesHolder)[i].upper_bound(mLastSpeciesId); lIterMap!=(*lSpeciesHolder)[i].end(); ++lIterMap) {
+				std::ostringstream lStream;
+				PACC::XML::Streamer lStreamer(lStream);
+				lIterMap->second->write(lStreamer, false);
+				mJournal.write(CheckpointJournal::eSpecies, i, lIterMap->first, lStream.str());
+			}
+		}
+		mLastSpeciesId = lSpeciesHolder->getIdCounter();
+	}
+
+	StructuralHierarchicalFairCompetitionOp* lHFCOp = findHFCOp(ioContext);
+	if(lHFCOp != NULL) {
+		std::ostringstream lStream;
+		PACC::XML::Streamer lStreamer(lStream);
+		lHFCOp->writeThresholds(lStreamer);
+		writeChanged(CheckpointJournal::eThresholds, 0, 0, lStream.str(), mThresholds);
+	}
+
+	if(!mJournal.commit(ioContext.getGeneration(), lVivarium.size()))
+		throw Beagle_IOExceptionMessageM(std::string("could not write the checkpoint journal ")+mJournalFile->getWrappedValue());
+	mNbAppended = lRewrite ? 0 : mNbAppended+1;
+
+	Beagle_LogDetailedM(
+						ioContext.getSystem().getLogger(),
+						"checkpoint", "CheckpointWriteOp",
+						std::string("Checkpoint of the generation ")+uint2str(ioContext.getGeneration())+
+						(lRewrite ? std::string(" rewritten, ") : std::string(" appended, "))+
+						uint2str(lNbIndividuals)+std::string(" individuals written")
+						);
+	Beagle_StackTraceEndM("void CheckpointWriteOp::operate(Deme& ioDeme, Context& ioContext)");
+}
+
+/*! \brief Write a record if its payload changed since the last checkpoint
+ *  \param  ioSignature Signature of the payload in the journal, updated.
+ *  \return True if the record was written.
+ */
+bool CheckpointWriteOp::writeChanged(CheckpointJournal::RecordType inType, unsigned int inDeme, unsigned int inIndex,
+									 const std::string& inPayload, Signature& ioSignature) {
+	Signature lSignature(CheckpointJournal::hash(inPayload), inPayload.size());
+	if(lSignature == ioSignature)
+		return false;
+	mJournal.write(inType, inDeme, inIndex, inPayload);
+	ioSignature = lSignature;
+	return true;
+}
+
+//! Return the HFC operator of the main loop, NULL if there is none.
+StructuralHierarchicalFairCompetitionOp* CheckpointWriteOp::findHFCOp(Context& ioContext) {
+	Operator::Bag& lMainLoop = ioContext.getEvolver().getMainLoopSet();
+	for(unsigned int i = 0; i < lMainLoop.size(); ++i) {
+		StructuralHierarchicalFairCompetitionOp* lHFCOp = dynamic_cast<StructuralHierarchicalFairCompetitionOp*>(&(*lMainLoop[i]));
+		if(lHFCOp != NULL)
+			return lHFCOp;
+	}
+	return NULL;
+}
@@ -0,0 +1,79 @@
+/*
+ *  CheckpointWriteOp.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef CheckpointWriteOp_H
+#define CheckpointWriteOp_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <beagle/Operator.hpp>
+#include <beagle/UInt.hpp>
+#include <beagle/String.hpp>
+#include "CheckpointJournal.h"
+
+class StructuralHierarchicalFairCompetitionOp;
+
+/*! \brief Write incremental checkpoints of the evolution
+ *  Beside the XML milestones, the state needed to resume the evolution is appended to a binary
+ *	journal after the last deme of a generation: the individuals that changed since the previous
+ *	checkpoint, the randomizer, the new species and the HFC thresholds. An individual is only
+ *	serialized when the revision of its BGFitness changed since it was journaled: its fitness was
+ *	invalidated by breeding and evaluated again, or adjusted. An individual without a valid BGFitness
+ *	is always written. The other records are written when the hash of their serialization changed. The
+ *	journal is rewritten with the full state at the first checkpoint and every ck.journal.compact
+ *	checkpoints, which bounds its size. CheckpointReadOp resumes from it.
+ */
+class CheckpointWriteOp : public Beagle::Operator {
+public:
+	typedef Beagle::AllocatorT<CheckpointWriteOp,Beagle::Operator::Alloc> Alloc;
+	typedef Beagle::PointerT<CheckpointWriteOp,Beagle::Operator::Handle> Handle;
+	typedef Beagle::ContainerT<CheckpointWriteOp,Beagle::Operator::Bag> Bag;
+
+	explicit CheckpointWriteOp(std::string inName="CheckpointWriteOp");
+	virtual ~CheckpointWriteOp() { }
+
+	virtual void initialize(Beagle::System& ioSystem);
+	virtual void operate(Beagle::Deme& ioDeme, Beagle::Context& ioContext);
+
+	static StructuralHierarchicalFairCompetitionOp* findHFCOp(Beagle::Context& ioContext);
+
+protected:
+	//! Hash and size of a serialized object, the size makes the collisions even less likely.
+	typedef std::pair<unsigned long, std::string::size_type> Signature;
+
+	bool writeChanged(CheckpointJournal::RecordType inType, unsigned int inDeme, unsigned int inIndex,
+					  const std::string& inPayload, Signature& ioSignature);
+
+	Beagle::String::Handle mJournalFile;	//!< Journal of the checkpoints, empty to disable them
+	Beagle::UInt::Handle mInterval;			//!< Number of generations between two checkpoints
+	Beagle::UInt::Handle mCompaction;		//!< Number of checkpoints appended before a rewrite
+
+	CheckpointJournal mJournal;
+	unsigned int mNbAppended;				//!< Checkpoints appended since the last rewrite
+	std::vector< std::vector<unsigned long> > mIndividuals;	//!< Fitness revision of the individuals in the journal, 0 if unknown
+	std::vector<Signature> mMigrationBuffers;
+	Signature mThresholds;
+	unsigned int mLastSpeciesId;			//!< Last species id in the journal
+};
+
+#endif
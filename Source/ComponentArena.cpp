@@ -0,0 +1,119 @@
+/*
+ *  ComponentArena.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *  
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#include "ComponentArena.h"
+
+ComponentArena::ComponentArena(std::size_t inChunkSize) :
+mChunkSize(inChunkSize), mCurrent(0), mNbLive(0), mReleased(false)
+{ }
+
+ComponentArena::~ComponentArena() {
+	for(unsigned int i = 0; i < mChunks.size(); ++i) {
+		delete [] mChunks[i]->mData;
+		delete mChunks[i];
+	}
+}
+
+/*! \brief Return an empty chunk of at least inSize bytes
+ *  Must be called with the mutex locked.
+ */
+ComponentArena::Chunk* ComponentArena::getChunk(std::size_t inSize) {
+	for(unsigned int i = 0; i < mFreeChunks.size(); ++i) {
+		if(mFreeChunks[i]->mSize >= inSize) {
+			Chunk* lChunk = mFreeChunks[i];
+			mFreeChunks.erase(mFreeChunks.begin()+i);
+			lChunk->mUsed = 0;
+			return lChunk;
+		}
+	}
+	
+	Chunk* lChunk = new Chunk;
+	lChunk->mArena = this;
+	lChunk->mSize = inSize > mChunkSize ? inSize : mChunkSize;
+	lChunk->mData = new char[lChunk->mSize];
+	lChunk->mUsed = 0;
+	lChunk->mNbLive = 0;
+	mChunks.push_back(lChunk);
+	return lChunk;
+}
+
+void* ComponentArena::allocate(std::size_t inSize) {
+	//Round up to keep the next header aligned
+	std::size_t lSize = ((sizeof(Header) + inSize + sizeof(Header) - 1) / sizeof(Header)) * sizeof(Header);
+	
+	mMutex.lock();
+	if(mCurrent == 0 || mCurrent->mUsed + lSize > mCurrent->mSize) {
+		//The previous chunk is recycled when its last object is deleted
+		if(mCurrent != 0 && mCurrent->mNbLive == 0)
+			mFreeChunks.push_back(mCurrent);
+		mCurrent = getChunk(lSize);
+	}
+	Header* lHeader = (Header*)(mCurrent->mData + mCurrent->mUsed);
+	lHeader->mChunk = mCurrent;
+	mCurrent->mUsed += lSize;
+	++mCurrent->mNbLive;
+	++mNbLive;
+	mMutex.unlock();
+	
+	return lHeader + 1;
+}
+
+void ComponentArena::deallocate(void* inPtr) {
+	if(inPtr == 0)
+		return;
+	
+	Chunk* lChunk = ((Header*)inPtr - 1)->mChunk;
+	ComponentArena* lArena = lChunk->mArena;
+	
+	lArena->mMutex.lock();
+	--lArena->mNbLive;
+	if(--lChunk->mNbLive == 0 && lChunk != lArena->mCurrent)
+		lArena->mFreeChunks.push_back(lChunk);
+	bool lDelete = lArena->mReleased && lArena->mNbLive == 0;
+	lArena->mMutex.unlock();
+	
+	if(lDelete)
+		delete lArena;
+}
+
+/*! \brief Rewind the current chunk if all its objects are deleted
+ *  Called after each individual, the next bond graph reuses the same memory.
+ */
+void ComponentArena::reset() {
+	mMutex.lock();
+	if(mCurrent != 0 && mCurrent->mNbLive == 0)
+		mCurrent->mUsed = 0;
+	mMutex.unlock();
+}
+
+/*! \brief Called by the owner instead of delete
+ *  The arena is deleted now, or with its last live object.
+ */
+void ComponentArena::release() {
+	mMutex.lock();
+	mReleased = true;
+	bool lDelete = (mNbLive == 0);
+	mMutex.unlock();
+	
+	if(lDelete)
+		delete this;
+}
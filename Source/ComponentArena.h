@@ -0,0 +1,143 @@
+/*
+ *  ComponentArena.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *  
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef ComponentArena_H
+#define ComponentArena_H
+
+#include <PACC/Threading.hpp>
+#include <cstddef>
+#include <vector>
+
+/*! \brief Chunk allocator for the bond graph objects built by the tree execution
+ *  The objects are carved one after the other from large chunks. A chunk is reused as a whole
+ *	once all its objects are deleted, so building a bond graph does not go through the heap once
+ *	the arena has grown to the size of a bond graph. The objects can be deleted from any thread
+ *	and after the owner of the arena has released it.
+ *
+ *	With USE_COMPONENT_ARENA, create allocates an ArenaObjectT<T>, which returns its memory to
+ *	the arena when the bond graph deletes it. This requires a virtual destructor in the base
+ *	class, checked at compile time by ArenaDeletableT. Otherwise, create uses the standard new.
+ */
+class ComponentArena {
+public:
+	explicit ComponentArena(std::size_t inChunkSize = 65536);
+	
+	void* allocate(std::size_t inSize);
+	static void deallocate(void* inPtr);
+	
+	void reset();
+	void release();
+	
+	unsigned long getNbLiveObjects() const { return mNbLive; }
+	unsigned int getNbChunks() const { return mChunks.size(); }
+	
+	template <class T> T* create();
+	template <class T, class A> T* create(A inArg);
+	template <class T, class A, class B> T* create(A inArg1, B inArg2);
+	
+private:
+	~ComponentArena();
+	
+	struct Chunk {
+		ComponentArena* mArena;
+		char* mData;
+		std::size_t mSize;
+		std::size_t mUsed;
+		unsigned int mNbLive;	//!< Number of objects of the chunk not yet deleted
+	};
+	//! Placed before each object, the size is a multiple of the largest alignment.
+	union Header {
+		Chunk* mChunk;
+		double mAlignDouble;
+		long double mAlignLongDouble;
+	};
+	
+	Chunk* getChunk(std::size_t inSize);
+	
+	std::size_t mChunkSize;
+	Chunk* mCurrent;					//!< Chunk where the objects are allocated
+	std::vector<Chunk*> mChunks;		//!< All the chunks of the arena
+	std::vector<Chunk*> mFreeChunks;	//!< Chunks without any live object
+	unsigned long mNbLive;
+	bool mReleased;						//!< The owner released the arena, it is deleted with its last object
+	PACC::Threading::Mutex mMutex;
+	
+	// disable copy
+	ComponentArena(const ComponentArena&);
+	void operator=(const ComponentArena&);
+};
+
+/*! \brief Fail to compile unless T has a virtual destructor
+ *  The bond graph deletes the objects of the arena through a pointer to their base class, the
+ *	operator delete of ArenaObjectT is only called if the destructor of that class is virtual.
+ */
+template <class T>
+struct ArenaDeletableT {
+#if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+	typedef char VirtualDestructorRequired[__has_virtual_destructor(T) ? 1 : -1];
+#endif
+};
+
+/*! \brief Object allocated in a component arena
+ *  The class operator delete gives the memory back to the arena, it is also used when the
+ *	object is deleted through a pointer to its base class.
+ */
+template <class T>
+class ArenaObjectT : public T, private ArenaDeletableT<T> {
+public:
+	ArenaObjectT() {}
+	template <class A> explicit ArenaObjectT(A inArg) : T(inArg) {}
+	template <class A, class B> ArenaObjectT(A inArg1, B inArg2) : T(inArg1,inArg2) {}
+	
+	static void* operator new(std::size_t inSize, ComponentArena& ioArena) { return ioArena.allocate(inSize); }
+	static void operator delete(void* inPtr, ComponentArena&) { ComponentArena::deallocate(inPtr); }
+	static void operator delete(void* inPtr) { ComponentArena::deallocate(inPtr); }
+};
+
+template <class T>
+T* ComponentArena::create() {
+#ifdef USE_COMPONENT_ARENA
+	return new(*this) ArenaObjectT<T>();
+#else
+	return new T();
+#endif
+}
+
+template <class T, class A>
+T* ComponentArena::create(A inArg) {
+#ifdef USE_COMPONENT_ARENA
+	return new(*this) ArenaObjectT<T>(inArg);
+#else
+	return new T(inArg);
+#endif
+}
+
+template <class T, class A, class B>
+T* ComponentArena::create(A inArg1, B inArg2) {
+#ifdef USE_COMPONENT_ARENA
+	return new(*this) ArenaObjectT<T>(inArg1,inArg2);
+#else
+	return new T(inArg1,inArg2);
+#endif
+}
+
+#endif
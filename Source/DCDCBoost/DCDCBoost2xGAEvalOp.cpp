@@ -127,13 +127,13 @@ Beagle::Fitness::Handle DCDCBoost2xGAEvalOp::evaluate(Beagle::Individual& inIndi
 						
 						if( mSimulationCases[g].getTime(i) >= mSimulationDuration->getWrappedValue() )
 							throw Beagle_RunTimeExceptionM("DCDCBoostEvalOp : Applying control target later than simulation end");
-						if(mSimulationCases[g].getTargets(i).size() != NBOUTPUTS-1)
+						if(mSimulationCases[g].getNbTargets(i) != NBOUTPUTS-1)
 							throw Beagle_RunTimeExceptionM("DCDCBoostEvalOp : There should be 1 target value for each control time");
-						if(mSimulationCases[g].getParameters(i).size() != NBPARAMETERS)
+						if(mSimulationCases[g].getNbParameters(i) != NBPARAMETERS)
 							throw Beagle_RunTimeExceptionM("DCDCBoostEvalOp : There should be 1 parameter value for each control time");
 						
 						//Assign parameters
-						const vector<double>& lParameters = mSimulationCases[g].getParameters(i);
+						vector<double> lParameters = mSimulationCases[g].getParameters(i);
 						if(!lParameters.empty()) {
 							lBondGraph.clearStateMatrix();
 						}
@@ -60,13 +60,8 @@ void DCDCBoostEmbryo::execute(Beagle::GP::Datum& outDatum, Beagle::GP::Context&
 	DCDCBoostLookaheadController *lController = new DCDCBoostLookaheadController;
 	
 	
-	//Get the parameters
-	Beagle::Component::Handle lHolderComponent = ioContext.getSystem().getComponent("ParametersHolder");
-	if(lHolderComponent==NULL)
-		throw Beagle_RunTimeExceptionM("No CMA holder component found in the system!");
-	ParametersHolder::Handle lHolder = castHandleT<ParametersHolder>(lHolderComponent);
-	if(lHolder==NULL)
-		throw Beagle_RunTimeExceptionM("Component named \"ParameterHolder\" found is not of the good type!");
+	//Get the parameters, the holder belong to the context since individuals can be evaluated concurrently
+	ParametersHolder::Handle lHolder = lContext.getParametersHolder();
 	
 #ifdef SINGLE_OUTPUT
 	//Creating the bond graph embryo
@@ -51,6 +51,17 @@ using namespace BG;
 DCDCBoostEvalOp::DCDCBoostEvalOp(std::string inName) : BondGraphEvalOp(inName)
 { 
 	mIndividualCounter = 0;
+	
+	//Signals used by the error computation and kept in the fitness log
+	mTimeSignal = mSignals.add("time");
+	for(unsigned int k = 0; k < NBOUTPUTS; ++k) {
+		mOutputSignals.push_back(mSignals.add(std::string("Output_")+int2str(k)));
+		mTargetSignals.push_back(mSignals.add(std::string("Target_")+int2str(k)));
+	}
+	const char* lKeptSignals[] = {"Output_0","Output_1","Output_2","Target_0","Target_1","Target_2","State","time","S1"};
+	for(unsigned int k = 0; k < sizeof(lKeptSignals)/sizeof(lKeptSignals[0]); ++k) {
+		mKeptSignals.push_back(mSignals.add(lKeptSignals[k]));
+	}
 }
 
 DCDCBoostEvalOp::~DCDCBoostEvalOp() {
@@ -70,35 +81,33 @@ Beagle::Fitness::Handle DCDCBoostEvalOp::evaluate(Beagle::GP::Individual& inIndi
 	BGFitness *lFitness = new BGFitness(-1);
 	GrowingHybridBondGraph::Handle lBondGraph;
 	TreeSTag::Handle lTree = castHandleT<TreeSTag>(inIndividual[0]);
-	
+	std::string lCacheKey;
 	
 	
 	try {
 		//Get the parameters
-		Beagle::Component::Handle lHolderComponent = ioContext.getSystem().getComponent("ParametersHolder");
-		if(lHolderComponent==NULL)
-			throw Beagle_RunTimeExceptionM("No ParameterHolder holder component found in the system!");
-		ParametersHolder::Handle lHolder = castHandleT<ParametersHolder>(lHolderComponent);
-		if(lHolder==NULL)
-			throw Beagle_RunTimeExceptionM("Component named \"ParameterHolder\" found is not of the good type!");
+		BGContext& lContext = castObjectT<BGContext&>(ioContext);
+		ParametersHolder::Handle lHolder = lContext.getParametersHolder();
 		lHolder->clear();
 		
+		//Release the previous bond graph and reuse its memory for this one
+		lContext.setBondGraph(NULL);
+		lContext.getComponentArena().reset();
+		
 		//Run the individual to create the bond graph.
 		RootReturn lResult;
 		inIndividual.run(lResult, ioContext);
-		BGContext& lContext = castObjectT<BGContext&>(ioContext);
 		lBondGraph = castHandleT<GrowingHybridBondGraph>(lContext.getBondGraph());
 		
-		Beagle_LogDebugM(
+		BondGraph_LogSafeM(Beagle_LogDebugM(
 						 ioContext.getSystem().getLogger(),
 						 "evaluation", "DCDCBoostEvalOp",
 						 std::string("Evaluating bondgrap: ")+
 						 lBondGraph->BondGraph::serialize()
-						 );
+						 ));
 		
-		GrowingHybridBondGraph::Handle lSaveNonSimplifiedBondGraph = new GrowingHybridBondGraph;
-		*lSaveNonSimplifiedBondGraph = *lBondGraph;
-		lFitness->setBondGraph(lSaveNonSimplifiedBondGraph);	
+		//Keep the bond graph before its simplification
+		lFitness->setBondGraphSnapshot(*lBondGraph);
 
 		
 		
@@ -121,12 +130,12 @@ Beagle::Fitness::Handle DCDCBoostEvalOp::evaluate(Beagle::GP::Individual& inIndi
 		/*//////////////////
 		
 		
-		Beagle_LogDebugM(
+		BondGraph_LogSafeM(Beagle_LogDebugM(
 						 ioContext.getSystem().getLogger(),
 						 "evaluation", "DCDCBoostEvalOp",
 						 std::string("Evaluating simplified bondgrap: ")+
 						 lBondGraph->BondGraph::serialize()
-						 );
+						 ));
 #ifdef DEBUG
 		lBondGraph->plotGraph("BondGraph.svg");
 		ofstream lFilestream2("Bondgraph.xml");
@@ -142,6 +151,25 @@ Beagle::Fitness::Handle DCDCBoostEvalOp::evaluate(Beagle::GP::Individual& inIndi
 			return lFitness;
 		}
 		
+		//Reuse the fitness of an identical bond graph already simulated on the same cases
+		if(mFitnessCache.getCapacity() > 0) {
+			std::ostringstream lCases;
+			for(int g = mSimulationCases.size()-1; g >= 0; --g) {
+				if( ((*mGenerationSteps)[0] < 0) || (ioContext.getGeneration() >= (*mGenerationSteps)[g]) )
+					lCases << g << ",";
+			}
+			lCacheKey = getFitnessCacheKey(*lBondGraph, lCases.str());
+			if(mFitnessCache.lookup(lCacheKey, *lFitness)) {
+				BondGraph_LogSafeM(Beagle_LogDebugM(
+								 ioContext.getSystem().getLogger(),
+								 "evaluation", "DCDCBoostEvalOp",
+								 std::string("Fitness found in the cache: ")+
+								 dbl2str(lFitness->getValue())
+								 ));
+				return lFitness;
+			}
+		}
+		
 		//Evaluate the bond graph
 		//Initialize the simulation
 		std::map<std::string, std::vector<double> > &lLogger = lBondGraph->getSimulationLog();
@@ -153,12 +181,27 @@ Beagle::Fitness::Handle DCDCBoostEvalOp::evaluate(Beagle::GP::Individual& inIndi
 		}
 		
 		try {
+			//The other threads can run Beagle code during the simulation, which only uses the
+			//bond graph, the controller and the parameters of this context
+			BeagleLock::Release lBeagleRelease;
 			std::vector<double> lInitialOutput(1,0);
+			double lSourceValue = 0;
 		
 			//Simulate every target prior to this generation
 			vector<double> lFitnessVector;
 			unsigned int lTry = 0;
+			unsigned int lNbCases = 0;
 			for(int g = mSimulationCases.size()-1; g >= 0; --g) {
+				if( ((*mGenerationSteps)[0] < 0) || (ioContext.getGeneration() >= (*mGenerationSteps)[g]) )
+					++lNbCases;
+			}
+			double lFitnessSum = 0;
+			bool lAborted = false;
+			
+			//The signals logged by the previous case are preallocated for the next one
+			std::vector<unsigned int> lLoggedSignals;
+			unsigned int lNbLogRows = (unsigned int)(mSimulationDuration->getWrappedValue()/mContinuousTimeStep->getWrappedValue()) + 2;
+			for(int g = mSimulationCases.size()-1; g >= 0 && !lAborted; --g) {
 				bool lRun = false;
 				if( (*mGenerationSteps)[0] < 0 )
 					lRun = true;
@@ -173,21 +216,22 @@ Beagle::Fitness::Handle DCDCBoostEvalOp::evaluate(Beagle::GP::Individual& inIndi
 						
 						if( mSimulationCases[g].getTime(i) >= mSimulationDuration->getWrappedValue() )
 							throw Beagle_RunTimeExceptionM("DCDCBoostEvalOp : Applying control target later than simulation end");
-						if(mSimulationCases[g].getTargets(i).size() != NBOUTPUTS-1)
+						if(mSimulationCases[g].getNbTargets(i) != NBOUTPUTS-1)
 							throw Beagle_RunTimeExceptionM("DCDCBoostEvalOp : There should be 1 target value for each control time");
-						if(mSimulationCases[g].getParameters(i).size() != NBPARAMETERS)
+						if(mSimulationCases[g].getNbParameters(i) != NBPARAMETERS)
 							throw Beagle_RunTimeExceptionM("DCDCBoostEvalOp : There should be 1 parameter value for each control time");
 		
 						//Assign parameters
-						const vector<double>& lParameters = mSimulationCases[g].getParameters(i);
+						vector<double> lParameters = mSimulationCases[g].getParameters(i);
 						if(!lParameters.empty()) {
 							lBondGraph->clearStateMatrix();
+							lController->clearStateMatrixCache();
 						}
 						assert(lHolder->size() == lParameters.size());
 						for(unsigned int k = 0; k < lParameters.size(); ++k) {
 							(*lHolder)[k]->setValue(lParameters[k]);
 						}
-						mSourceValue = lParameters[0];
+						lSourceValue = lParameters[0];
 						
 						//Compute the current target
 						vector<double> lTargets = mSimulationCases[g].getTargets(i);
@@ -199,22 +243,15 @@ Beagle::Fitness::Handle DCDCBoostEvalOp::evaluate(Beagle::GP::Individual& inIndi
 						lController->setTarget(lTargets);
 
 						if(i == 0) {
-							//Find a valid initial state
-							unsigned int lInitialSwitchState = 0;
-							double lMaxConfiguration = pow(2.0,int(lBondGraph->getSwitches().size()));
-							for(;lInitialSwitchState < lMaxConfiguration; ++lInitialSwitchState) { 
-								try{ 
-									lController->initialize(&(*lBondGraph),lInitialSwitchState);
-								} catch(BG::CausalityException inError) {
-									continue;
-								}
-								break;
-							}
-														
+							//Find a valid initial state, the configurations with a conflicting causality are
+							//remembered by the controller from one case to the other
+							int lInitialSwitchState = lController->findInitialState(&(*lBondGraph));
+							
 							//Check if a valid initial state have been found
-							if(lInitialSwitchState == lMaxConfiguration) {
+							if(lInitialSwitchState < 0) {
 								if(mAllowDifferentialCausality->getWrappedValue() == 2) {
 									lBondGraph->setDifferentialCausalitySupport(true);
+									lController->clearCausalityTable();
 									lInitialSwitchState = 0;
 								} else {
 									lSimulationRan = false;
@@ -225,6 +262,7 @@ Beagle::Fitness::Handle DCDCBoostEvalOp::evaluate(Beagle::GP::Individual& inIndi
 							
 							//Reset the bond graph
 							lLogger.clear();
+							SimulationLog::reserve(lLogger,mSignals,lLoggedSignals,lNbLogRows);
 							lBondGraph->reset();
 							
 //							//Remove transition state when test hand writen individual
@@ -248,27 +286,19 @@ Beagle::Fitness::Handle DCDCBoostEvalOp::evaluate(Beagle::GP::Individual& inIndi
 					
 					//Evaluate the results
 					if(lSimulationRan) {
-						lF = computeError(&(*lBondGraph),lLogger);
-
-						
+						SimulationLog lLogView(lLogger,mSignals);
+						lF = computeError(&(*lBondGraph),lLogView,lSourceValue);
 						
 						//Clean logger
-						for(map<std::string, vector<double> >::iterator lIter = lLogger.begin(); lIter != lLogger.end();) {
-							if(lIter->first != "Output_0" &&
-							   lIter->first != "Output_1" &&
-							   lIter->first != "Output_2" &&
-							   lIter->first != "Target_0" &&
-							   lIter->first != "Target_1" &&
-							   lIter->first != "Target_2" &&
-							   lIter->first != "State" &&
-							   lIter->first != "time" &&
-							   lIter->first != "S1") {
-								lLogger.erase(lIter++);
-							} else {
-								++lIter;		
-							}
+						lLogView.retain(mKeptSignals);
+						lLoggedSignals.clear();
+						for(unsigned int k = 0; k < mKeptSignals.size(); ++k) {
+							if(lLogView.hasColumn(mKeptSignals[k]))
+								lLoggedSignals.push_back(mKeptSignals[k]);
 						}
-						lBondGraph->writeSimulationLog(std::string("DCDCBoost_Lookahead_testcase_")+uint2str(g)+std::string(".csv"));
+						std::string lBuffer;
+						lLogView.writeCSV(lBuffer);
+						mFileWriter->write(std::string("DCDCBoost_Lookahead_testcase_")+uint2str(g)+std::string(".csv"), lBuffer);
 					} else {
 						lF = 0;
 					}
@@ -280,6 +310,19 @@ Beagle::Fitness::Handle DCDCBoostEvalOp::evaluate(Beagle::GP::Individual& inIndi
 						lFitness->addData(lIter->first, lIter->second,lTry);
 					}
 					++lTry;
+					
+					//Stop when the remaining cases can't bring the fitness over the racing threshold
+					lFitnessSum += lF;
+					if(isHopeless(lFitnessSum, lFitnessVector.size(), lNbCases)) {
+						lAborted = true;
+						lCacheKey.clear();
+						BondGraph_LogSafeM(Beagle_LogDebugM(
+										 ioContext.getSystem().getLogger(),
+										 "evaluation", "DCDCBoostEvalOp",
+										 std::string("Evaluation stopped by racing after ")+uint2str(lFitnessVector.size())+
+										 std::string(" of ")+uint2str(lNbCases)+std::string(" cases")
+										 ));
+					}
 				}
 			}
 			
@@ -288,8 +331,11 @@ Beagle::Fitness::Handle DCDCBoostEvalOp::evaluate(Beagle::GP::Individual& inIndi
 			for(unsigned int i = 0; i < lFitnessVector.size(); ++i) {
 				lAvg += lFitnessVector[i];
 			}
-			lAvg = lAvg/lFitnessVector.size();
-			lFitness->setValue(lAvg);
+			//The cases skipped by the racing count as null fitness
+			if(lAborted)
+				lFitness->setValue(getRacingFitness(lAvg, lNbCases));
+			else
+				lFitness->setValue(lAvg/lFitnessVector.size());
 			
 			/*	
 			 //Look at the worst test case
@@ -316,19 +362,24 @@ Beagle::Fitness::Handle DCDCBoostEvalOp::evaluate(Beagle::GP::Individual& inIndi
 		
 	}
 	catch(std::runtime_error inError) {
-		std::cerr << "Error catched while evaluating the bond graph: " << inError.what() << std::endl;
+		lCacheKey.clear();
 		
 		//Save bond graph for debuging
 		std::ostringstream lFilename;
+		mLogMutex.lock();
+		std::cerr << "Error catched while evaluating the bond graph: " << inError.what() << std::endl;
 		lFilename << "bug/bondgraph_bug_" << ioContext.getGeneration() << "_" << mIndividualCounter++;//ioContext.getIndividualIndex();
+		mLogMutex.unlock();
 #ifndef WITHOUT_GRAPHVIZ
 		lBondGraph->plotGraph(lFilename.str()+std::string(".svg"));
 #endif
-		ofstream lFileStream((lFilename.str()+std::string(".xml")).c_str());
+		std::ostringstream lFileStream;
 		PACC::XML::Streamer lStreamer(lFileStream);
 		lBondGraph->write(lStreamer);
 		inIndividual.write(lStreamer);
 		lFileStream << endl;	
+		std::string lBuffer = lFileStream.str();
+		mFileWriter->write(lFilename.str()+std::string(".xml"), lBuffer);
 		//Assign null fitness
 		lFitness->setValue(0);
 		
@@ -337,6 +388,11 @@ Beagle::Fitness::Handle DCDCBoostEvalOp::evaluate(Beagle::GP::Individual& inIndi
 #endif
     }
 	
+	//Keep the fitness for the identical bond graphs to come
+	if(!lCacheKey.empty()) {
+		mFitnessCache.insert(lCacheKey, *lFitness);
+	}
+	
 	
 	
 	//delete lBondGraph;
@@ -344,35 +400,36 @@ Beagle::Fitness::Handle DCDCBoostEvalOp::evaluate(Beagle::GP::Individual& inIndi
 #ifdef NOSIMULATION
 	lFitness->setValue(ioContext.getSystem().getRandomizer().rollUniform(0,0.999));
 #endif
-	Beagle_LogDebugM(
+	BondGraph_LogSafeM(Beagle_LogDebugM(
 					 ioContext.getSystem().getLogger(),
 					 "evaluation", "DCDCBoostEvalOp",
 					 std::string("Result of evaluation: ")+
 					 lFitness->serialize()
-					 );
+					 ));
 	
-	Beagle_LogTraceM(
+	BondGraph_LogSafeM(Beagle_LogTraceM(
 					 ioContext.getSystem().getLogger(),
 					 "evaluation", "DCDCBoostEvalOp",
 					 std::string("Result of evaluation: ")+
 					 dbl2str(lFitness->getValue())
-					 );
+					 ));
 	
 	return lFitness;
 	
 	Beagle_StackTraceEndM("void DCDCBoostEvalOp::evaluate(Beagle::GP::Individual& inIndividual, Beagle::GP::Context& ioContext)");
 }
 
-double DCDCBoostEvalOp::computeError(const BondGraph* inBondGraph, std::map<std::string, std::vector<double> > &inSimulationLog) {
+double DCDCBoostEvalOp::computeError(const BondGraph* inBondGraph, const SimulationLog& inSimulationLog, double inSourceValue) {
 	
 	std::vector<double> lErrors(NBOUTPUTS,0);
 	std::vector<bool> lZeroOutput(NBOUTPUTS,true);
 	std::vector<bool> lSourceOutput(NBOUTPUTS,true);
 	bool lSameOutput = true;
+	const std::vector<double>& lTime = inSimulationLog.getColumn(mTimeSignal);
 	for(unsigned int k = 0; k < NBOUTPUTS; ++k) {
-		const std::vector<double>& lTarget = inSimulationLog[std::string("Target_")+int2str(k)];
-		std::vector<double>& lOutput = inSimulationLog[std::string("Output_")+int2str(k)];
-		const std::vector<double>& lTime = inSimulationLog["time"];
+		const std::vector<double>& lTarget = inSimulationLog.getColumn(mTargetSignals[k]);
+		const std::vector<double>& lOutput = inSimulationLog.getColumn(mOutputSignals[k]);
+		const std::vector<double>& lNextOutput = inSimulationLog.getColumn(mOutputSignals[(k+1) % NBOUTPUTS]);
 		
 		unsigned int lDataSize = lTime.size();
 		assert(lTime.size() == lOutput.size());
@@ -386,11 +443,11 @@ double DCDCBoostEvalOp::computeError(const BondGraph* inBondGraph, std::map<std:
 			if(lOutput[i] != 0) 
 				lZeroOutput[k] = false;
 			
-			if(lOutput[i] != mSourceValue) 
+			if(lOutput[i] != inSourceValue) 
 				lSourceOutput[k] = false;
 			
 			if(lSameOutput && k == 0) {
-				if(inSimulationLog[std::string("Output_")+int2str(k)][i] != inSimulationLog[std::string("Output_")+int2str(k+1)][i]) 
+				if(lOutput[i] != lNextOutput[i]) 
 					lSameOutput = false;
 			}
 /*
@@ -468,11 +525,7 @@ double DCDCBoostEvalOp::computeError(const BondGraph* inBondGraph, std::map<std:
 
 
 void DCDCBoostEvalOp::initialize(Beagle::System& ioSystem) {
-#ifdef USE_MPI
-	Beagle::MPI::EvaluationOp::initialize(ioSystem);
-#else
-	Beagle::EvaluationOp::initialize(ioSystem);
-#endif
+	BondGraphEvalOp::initialize(ioSystem);
 	
 	PACC::XML::Streamer lStreamer(std::cout);
 	ioSystem.getRegister().write(lStreamer,true);
@@ -511,7 +564,7 @@ void DCDCBoostEvalOp::initialize(Beagle::System& ioSystem) {
 										   "Controller target, by pair for each control time",
 										   "String",
 										   mTargetString->serialize(),
-										   "Tank levels target for the controller"
+										   "Tank levels target for the controller, or @filename to read the cases from a binary simulation case file"
 										   );
 		ioSystem.getRegister().addEntry("sim.control.target", mTargetString, lDescription);
 	}
@@ -589,13 +642,7 @@ void DCDCBoostEvalOp::initialize(Beagle::System& ioSystem) {
  */
 void DCDCBoostEvalOp::postInit(Beagle::System& ioSystem)
 {
-#ifdef USE_MPI
-	Beagle::MPI::EvaluationOp::postInit(ioSystem);
-#else
-	Beagle::EvaluationOp::postInit(ioSystem);
-#endif
-	
-	ioSystem.addComponent(new ParametersHolder);
+	BondGraphEvalOp::postInit(ioSystem);
 	
 //	if(*mTargetString == Beagle::String("")) {
 //		SimulationCase lCase;
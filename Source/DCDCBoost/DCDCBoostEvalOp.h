@@ -27,6 +27,7 @@
 #include "BondGraph.h"
 #include "BondGraphEvalOp.h"
 #include "SimulationCase.h"
+#include "SimulationLog.h"
 #include <map>
 #include <vector>
 #include <string>
@@ -48,11 +49,10 @@ public:
 	
 	
 private:
-	double computeError(const BG::BondGraph* inBondGraph, std::map<std::string, std::vector<double> > &lSimulationLog);
+	double computeError(const BG::BondGraph* inBondGraph, const SimulationLog& inSimulationLog, double inSourceValue);
 	static bool mIsInitialized;
 	
 	Beagle::String::Handle mTargetString;
-	std::vector<SimulationCase> mSimulationCases;
 	Beagle::FloatArray::Handle mGenerationSteps;
 	
 	//	Beagle::Float::Handle mTargetTolerances;
@@ -64,8 +64,6 @@ private:
 //	Beagle::FloatArray::Handle mCapacitance;
 //	Beagle::Float::Handle mResistance;
 	
-	double mSourceValue;
-
 	Beagle::Float::Handle mPenaltyFactor;
 	
 	Beagle::Int::Handle mMaxNumberSwitch;
@@ -74,6 +72,12 @@ private:
 	std::vector<Beagle::FloatArray::Handle> mTargetArrays;
 	
 	long int mIndividualCounter;
+	
+	SimulationLog::Signals mSignals;             //!< Identifiers of the logged signals, read concurrently by the evaluations
+	unsigned int mTimeSignal;                    //!< Identifier of the time signal
+	std::vector<unsigned int> mOutputSignals;    //!< Identifiers of the output signals
+	std::vector<unsigned int> mTargetSignals;    //!< Identifiers of the target signals
+	std::vector<unsigned int> mKeptSignals;      //!< Signals kept in the fitness log
 };
 
 
@@ -114,7 +114,7 @@ Fitness::Handle DCDCBoostGAEvalOp::evaluate(Individual& inIndividual, Context& i
 			for(unsigned int i = 0; i < mSimulationCases[g].getSize(); ++i) {
 				if( mSimulationCases[g].getTime(i) >= mSimulationDuration->getWrappedValue() )
 					throw Beagle_RunTimeExceptionM("DCDCBoostGAEvalOp : Applying control target later than simulation end");
-				if(mSimulationCases[g].getTargets(i).size() != 2)
+				if(mSimulationCases[g].getNbTargets(i) != 2)
 					throw Beagle_RunTimeExceptionM("DCDCBoostGAEvalOp : There should be only two target for each control time");
 
 				lController->setTarget(mSimulationCases[g].getTargets(i));
@@ -31,8 +31,8 @@ void DCDCBoostLookaheadController::writeLog() {
 	
 	(*mLogger)["State"].push_back(mCurrentState);
 	for(unsigned int i = 0; i < mTargets.size(); ++i) {
-		(*mLogger)[std::string("Target_")+int2str(i)].push_back(mTargets[i]);
-		(*mLogger)[std::string("Output_")+int2str(i)].push_back(lOutputsVariables[i]);
+		(*mLogger)[getLogColumn(mTargetColumns,"Target_",i)].push_back(mTargets[i]);
+		(*mLogger)[getLogColumn(mOutputColumns,"Output_",i)].push_back(lOutputsVariables[i]);
 	}
 }
 
@@ -0,0 +1,89 @@
+/*
+ *  DataCodec.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *  
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#include "DataCodec.h"
+#include <cstring>
+#include <stdexcept>
+
+typedef unsigned long long DataBits;
+
+static DataBits double2bits(double inValue) {
+	DataBits lBits;
+	std::memcpy(&lBits, &inValue, sizeof(lBits));
+	return lBits;
+}
+
+static double bits2double(DataBits inBits) {
+	double lValue;
+	std::memcpy(&lValue, &inBits, sizeof(lValue));
+	return lValue;
+}
+
+void encodeXorDoubles(const std::vector<double>& inData, std::string& outBytes) {
+	outBytes.clear();
+	outBytes.reserve(inData.size()*3);
+	DataBits lPrevious = 0;
+	for(unsigned int i = 0; i < inData.size(); ++i) {
+		DataBits lBits = double2bits(inData[i]);
+		DataBits lXor = lBits ^ lPrevious;
+		lPrevious = lBits;
+		
+		//Count the leading and trailing zero bytes
+		unsigned int lLeading = 0;
+		while(lLeading < 8 && ((lXor >> (8*(7-lLeading))) & 0xff) == 0)
+			++lLeading;
+		unsigned int lTrailing = 0;
+		if(lLeading < 8) {
+			while(((lXor >> (8*lTrailing)) & 0xff) == 0)
+				++lTrailing;
+		}
+		
+		outBytes += char((lLeading << 4) | lTrailing);
+		for(int b = 7-lLeading; b >= int(lTrailing); --b) {
+			outBytes += char((lXor >> (8*b)) & 0xff);
+		}
+	}
+}
+
+void decodeXorDoubles(const std::string& inBytes, std::vector<double>& outData) {
+	outData.clear();
+	DataBits lPrevious = 0;
+	unsigned int lPos = 0;
+	while(lPos < inBytes.size()) {
+		unsigned char lHeader = inBytes[lPos++];
+		unsigned int lLeading = lHeader >> 4;
+		unsigned int lTrailing = lHeader & 0xf;
+		if(lLeading > 8 || (lLeading < 8 && lLeading + lTrailing > 7))
+			throw std::runtime_error("decodeXorDoubles : corrupted data");
+		
+		DataBits lXor = 0;
+		if(lLeading < 8) {
+			if(lPos + 8 - lLeading - lTrailing > inBytes.size())
+				throw std::runtime_error("decodeXorDoubles : truncated data");
+			for(int b = 7-lLeading; b >= int(lTrailing); --b) {
+				lXor |= DataBits((unsigned char)inBytes[lPos++]) << (8*b);
+			}
+		}
+		lPrevious ^= lXor;
+		outData.push_back(bits2double(lPrevious));
+	}
+}
@@ -0,0 +1,38 @@
+/*
+ *  DataCodec.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *  
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef DataCodec_H
+#define DataCodec_H
+
+#include <string>
+#include <vector>
+
+/*! \brief Binary encoding of a series of doubles
+ *  Each value is XORed with the previous one, as consecutive samples of a simulation share
+ *	most of their sign, exponent and leading mantissa bits. A header byte gives the number of
+ *	leading and trailing zero bytes of the XOR, and only the remaining bytes are written. The
+ *	encoding is exact and independent of the platform byte order.
+ */
+void encodeXorDoubles(const std::vector<double>& inData, std::string& outBytes);
+void decodeXorDoubles(const std::string& inBytes, std::vector<double>& outData);
+
+#endif
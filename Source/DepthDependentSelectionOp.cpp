@@ -22,6 +22,7 @@
 
 #include "DepthDependentSelectionOp.h"
 #include <beagle/GP/Context.hpp>
+#include "TreeSTag.h"
 
 using namespace Beagle;
 
@@ -68,42 +69,27 @@ void DepthDependentSelectionOp::initialize(Beagle::System& ioSystem) {
 //	}
 }
 
-double DepthDependentSelectionOp::computeWeight(const GP::Tree& inTree, unsigned int inNode,Beagle::GP::Context& ioContext) const {
-//	unsigned int lSizeIndividual = 0;
-//	for(unsigned int i=0; i<inIndividual.size(); i++) lSizeIndividual += inIndividual[i]->size();
+/*! \brief Compute the selection weight of every node of a tree
+ *  The weight of a node decreases with its depth and its subtree size. The depth and subtree
+ *	size of all the nodes come from the preorder encoding of the tree, in a single pass.
+ */
+void DepthDependentSelectionOp::computeWeights(const GP::Tree& inTree, std::vector<double>& outWeights) const {
+	const std::vector<TreeSTag::FlatNode>& lNodes = castObjectT<const TreeSTag&>(inTree).getFlatEncoding();
 	
-	//Compute node depth
-	unsigned int lDepth = 0;
-	for(unsigned int lNode = 0; lNode < inNode; ) {
-		if( inTree[lNode].mSubTreeSize + lNode - 1 < inNode ) { 
-			//inNode is not in subtree
-			lNode += inTree[lNode].mSubTreeSize;
-		}else { 
-			//inNode is in subtree, get on step deeper
-			++lNode;
-			++lDepth;
-		}
+	unsigned int lTreeDepth = 0;
+	for(unsigned int i = 0; i < lNodes.size(); ++i) {
+		if(lNodes[i].mDepth > lTreeDepth)
+			lTreeDepth = lNodes[i].mDepth;
 	}
 	
 	double lFactor = mMutDepthFactor->getWrappedValue();
-	double lSubTreeSizeFactor = inTree[inNode].mSubTreeSize/double(inTree.size());
-	double lDepthFactor = lDepth/double(inTree.getTreeDepth());
-	
-	double lWeight = 1 - lFactor*lDepthFactor*lSubTreeSizeFactor;
-//	Beagle_LogDebugM(
-//					   ioContext.getSystem().getLogger(),
-//					   "selection", "DepthDependentSelectionOp::computeWeight",
-//					   std::string("Node depth: ")+uint2str(lDepth)+
-//					   std::string(", sub-tree size: ")+uint2str(inTree[inNode].mSubTreeSize)+
-//					   std::string(", tree size: ")+uint2str(inTree.size())
-//					   );	
-//	Beagle_LogDebugM(
-//					 ioContext.getSystem().getLogger(),
-//					 "selection", "DepthDependentSelectionOp::computeWeight",
-//					 std::string("Computed node weigh of ")+inTree[inNode].mPrimitive->getName()+std::string(" is ")+dbl2str(lWeight)
-//					 );
-	
-	return lWeight;
+	outWeights.resize(lNodes.size());
+	for(unsigned int i = 0; i < lNodes.size(); ++i) {
+		//The root is at depth 0
+		double lSubTreeSizeFactor = lNodes[i].mSubTreeSize/double(lNodes.size());
+		double lDepthFactor = (lNodes[i].mDepth-1)/double(lTreeDepth);
+		outWeights[i] = 1 - lFactor*lDepthFactor*lSubTreeSizeFactor;
+	}
 }
 
 bool DepthDependentSelectionOp::selectNodeToMateWithTypes(unsigned int& outSelectTreeIndex,
@@ -214,14 +200,18 @@ unsigned int DepthDependentSelectionOp::buildRouletteWithTypes(
 	const unsigned int lNbArgs = inTree[inActualIndex].mPrimitive->getNumberArguments();
 	const unsigned int lSubTreeSize = inTree[inActualIndex].mSubTreeSize;
 	const bool lGoodArity = ((inTree.size()==1) || ((lNbArgs==0) != inSelectABranch));
-	ioContext.pushCallStack(inActualIndex);
-	std::vector<const std::type_info*> lNodeTypes = inTree[inActualIndex].mPrimitive->getReturnTypes(ioContext);
 	
-	bool lCompatibleTyping = ((inNodeReturnTypes[0]==NULL) || (lNodeTypes[0]==NULL) );
-	for(unsigned int k = 0; k < lNodeTypes.size() && !lCompatibleTyping; ++k) {
-		lCompatibleTyping = std::find(inNodeReturnTypes.begin(),inNodeReturnTypes.end(),lNodeTypes[k]) != inNodeReturnTypes.end();
+	//The weights of the whole tree are computed when its walk starts, at any node, and whenever
+	//another tree is processed
+	if(ioContext.getCallStackSize() == 0 || mWeightsTree != &inTree || mWeights.size() != inTree.size()) {
+		computeWeights(inTree, mWeights);
+		mWeightsTree = &inTree;
 	}
 	
+	const PrimitiveTypes& lTypes = getPrimitiveTypes(TreeSTag::getPrimitiveID(inTree[inActualIndex].mPrimitive->getName()), *inTree[inActualIndex].mPrimitive, ioContext);
+	ioContext.pushCallStack(inActualIndex);
+	const bool lCompatibleTyping = isCompatibleTyping(inNodeReturnTypes, lTypes, false);
+	
 	unsigned int lChildIndex = inActualIndex+1;
 	unsigned int lMaxDepthDown = 0;
 	for(unsigned int i=0; i<lNbArgs; ++i) {
@@ -243,9 +233,7 @@ unsigned int DepthDependentSelectionOp::buildRouletteWithTypes(
 	   (lMaxDepthDown<=inMaxSubTreeDepth) && (lMaxDepthUp<=inMaxSubTreeDepth)) {
 		std::pair<unsigned int,unsigned int> lPair(ioContext.getGenotypeIndex(), inActualIndex);
 		
-		double lWeight = 1;
-		lWeight = computeWeight(ioContext.getGenotype(),inActualIndex,ioContext);
-		ioRoulette.insert(lPair, lWeight);
+		ioRoulette.insert(lPair, mWeights[inActualIndex]);
 
 	}
 	return lMaxDepthDown;
@@ -298,6 +286,8 @@ void DepthDependentSelectionOp::buildRoulette(
 	} 
 	
 	
+	const GP::Tree* lWeightsTree = 0;
+	std::vector<double> lWeights;
 	for(unsigned int lChoosenNode = lNodeSearchStart; lChoosenNode < lNodeSearchEnd; ++lChoosenNode) {
 		// Get the tree in which the choosen node is. Change the global node index to the tree's index.
 		unsigned int lChoosenTree = 0;
@@ -317,23 +307,21 @@ void DepthDependentSelectionOp::buildRoulette(
 		if(!lGoodArity) continue;
 		
 		//Get compatibility of types
-		std::vector<const std::type_info*> lNodeTypes = lTree[lChoosenNode].mPrimitive->getReturnTypes(ioContext);
-		
-		bool lCompatibleTyping = ((inNodeReturnTypes[0]==NULL) || (lNodeTypes[0]==NULL) );
-		for(unsigned int k = 0; k < lNodeTypes.size() && !lCompatibleTyping; ++k) {
-			if(inIsExclusiveSet)
-				lCompatibleTyping = std::find(inNodeReturnTypes.begin(),inNodeReturnTypes.end(),lNodeTypes[k]) == inNodeReturnTypes.end();
-			else
-				lCompatibleTyping = std::find(inNodeReturnTypes.begin(),inNodeReturnTypes.end(),lNodeTypes[k]) != inNodeReturnTypes.end();
-			
-		}
+		const PrimitiveTypes& lTypes = getPrimitiveTypes(TreeSTag::getPrimitiveID(lTree[lChoosenNode].mPrimitive->getName()), *lTree[lChoosenNode].mPrimitive, ioContext);
+		const bool lCompatibleTyping = isCompatibleTyping(inNodeReturnTypes, lTypes, inIsExclusiveSet);
 		
 		//if all condition are good, add to the roulette
 		if(lGoodArity && lCompatibleTyping) {
 			std::pair<unsigned int,unsigned int> lPair(lChoosenTree, lChoosenNode);
 			double lWeight = 1;
-			if(!inSelectSingleParameterSubTree) 
-				lWeight = computeWeight(lTree,lChoosenNode,ioContext);
+			if(!inSelectSingleParameterSubTree) {
+				//The weights are computed once for each tree
+				if(lWeightsTree != &lTree) {
+					computeWeights(lTree, lWeights);
+					lWeightsTree = &lTree;
+				}
+				lWeight = lWeights[lChoosenNode];
+			}
 			ioRoulette.insert(lPair, lWeight);
 		}
 	}	
@@ -388,6 +376,8 @@ void DepthDependentSelectionOp::buildRoulette(
 	} 
 	
 	
+	const GP::Tree* lWeightsTree = 0;
+	std::vector<double> lWeights;
 	for(unsigned int lChoosenNode = lNodeSearchStart; lChoosenNode < lNodeSearchEnd; ++lChoosenNode) {
 		// Get the tree in which the choosen node is. Change the global node index to the tree's index.
 		unsigned int lChoosenTree = 0;
@@ -402,22 +392,21 @@ void DepthDependentSelectionOp::buildRoulette(
 		GP::Tree& lTree = *inIndiv[lChoosenTree];
 		
 		//Get compatibility of types
-		std::vector<const std::type_info*> lNodeTypes = lTree[lChoosenNode].mPrimitive->getReturnTypes(ioContext);
-		
-		bool lCompatibleTyping = ((inNodeReturnTypes[0]==NULL) || (lNodeTypes[0]==NULL) );
-		for(unsigned int k = 0; k < lNodeTypes.size() && !lCompatibleTyping; ++k) {
-			if(inIsExclusiveSet)
-				lCompatibleTyping = std::find(inNodeReturnTypes.begin(),inNodeReturnTypes.end(),lNodeTypes[k]) == inNodeReturnTypes.end();
-			else
-				lCompatibleTyping = std::find(inNodeReturnTypes.begin(),inNodeReturnTypes.end(),lNodeTypes[k]) != inNodeReturnTypes.end();
-		}
+		const PrimitiveTypes& lTypes = getPrimitiveTypes(TreeSTag::getPrimitiveID(lTree[lChoosenNode].mPrimitive->getName()), *lTree[lChoosenNode].mPrimitive, ioContext);
+		const bool lCompatibleTyping = isCompatibleTyping(inNodeReturnTypes, lTypes, inIsExclusiveSet);
 		
 		//if all condition are good, add to the roulette
 		if(lCompatibleTyping) {
 			std::pair<unsigned int,unsigned int> lPair(lChoosenTree, lChoosenNode);
 			double lWeight = 1;
-			if(!inSelectSingleParameterSubTree) 
-				lWeight = computeWeight(lTree,lChoosenNode,ioContext);
+			if(!inSelectSingleParameterSubTree) {
+				//The weights are computed once for each tree
+				if(lWeightsTree != &lTree) {
+					computeWeights(lTree, lWeights);
+					lWeightsTree = &lTree;
+				}
+				lWeight = lWeights[lChoosenNode];
+			}
 			ioRoulette.insert(lPair, lWeight);
 		}
 	}
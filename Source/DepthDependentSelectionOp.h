@@ -38,9 +38,12 @@ protected:
 	Beagle::Float::Handle mCxDepthFactor;
 //	Beagle::UInt::Handle mMaxTreeDepth;
 	
-	double computeWeight(const Beagle::GP::Tree& inTree, unsigned int inNode, Beagle::GP::Context& ioContext) const;
+	mutable std::vector<double> mWeights;				//!< Node weights of the tree processed by buildRouletteWithTypes
+	mutable const Beagle::GP::Tree* mWeightsTree;	//!< Tree of mWeights
+	
+	void computeWeights(const Beagle::GP::Tree& inTree, std::vector<double>& outWeights) const;
 public:
-	explicit DepthDependentSelectionOp() : SelectiveConstrainedSelectionOp() {}
+	explicit DepthDependentSelectionOp() : SelectiveConstrainedSelectionOp(), mWeightsTree(0) {}
 	~DepthDependentSelectionOp() {}
 	
 	virtual void initialize(Beagle::System& ioSystem);
@@ -0,0 +1,250 @@
+/*
+ *  EvaluationSandbox.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#include "EvaluationSandbox.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+//! Write a complete buffer to a file descriptor, return false on error.
+static bool writeAll(int inDescriptor, const std::string& inBuffer) {
+	std::string::size_type lWritten = 0;
+	while(lWritten < inBuffer.size()) {
+		ssize_t lCount = ::write(inDescriptor, inBuffer.data()+lWritten, inBuffer.size()-lWritten);
+		if(lCount < 0) {
+			if(errno == EINTR) continue;
+			return false;
+		}
+		lWritten += lCount;
+	}
+	return true;
+}
+
+//! Arm the wall-clock timer of the process, 0 disarms it. SIGALRM ends the process.
+static void setTimer(double inSeconds) {
+	struct itimerval lTimer;
+	lTimer.it_interval.tv_sec = 0;
+	lTimer.it_interval.tv_usec = 0;
+	lTimer.it_value.tv_sec = (time_t)inSeconds;
+	lTimer.it_value.tv_usec = (suseconds_t)((inSeconds-(time_t)inSeconds)*1e6);
+	setitimer(ITIMER_REAL, &lTimer, NULL);
+}
+
+/*! \brief Configure the sandbox
+ *  \param  inNbProcesses Number of processes running the jobs at the same time.
+ *  \param  inTimeBudget Wall-clock time allowed to a job in seconds, 0 if unlimited.
+ *  \param  inMemoryBudget Address space allowed to a process in MB, 0 if unlimited.
+ */
+EvaluationSandbox::EvaluationSandbox(unsigned int inNbProcesses, double inTimeBudget, unsigned int inMemoryBudget) :
+mNbProcesses(std::max(inNbProcesses,1U)), mTimeBudget(inTimeBudget), mMemoryBudget(inMemoryBudget)
+{ }
+
+/*! \brief Run the jobs and wait for their results
+ *  \param  inJobs Jobs to run, they are split in contiguous batches.
+ *  Every job gets either receiveResult() or receiveFailure() called before the return.
+ */
+void EvaluationSandbox::run(const std::vector<unsigned int>& inJobs) {
+	unsigned int lNbProcesses = std::min(mNbProcesses, (unsigned int)inJobs.size());
+	std::vector<Process> lProcesses(lNbProcesses);
+	for(unsigned int i = 0; i < lNbProcesses; ++i) {
+		lProcesses[i].mPid = 0;
+		lProcesses[i].mPipe = -1;
+		lProcesses[i].mNextJob = 0;
+		lProcesses[i].mJobs.assign(inJobs.begin()+i*inJobs.size()/lNbProcesses, inJobs.begin()+(i+1)*inJobs.size()/lNbProcesses);
+	}
+
+	try {
+		for(unsigned int i = 0; i < lNbProcesses; ++i) {
+			start(lProcesses[i]);
+		}
+
+		std::vector<struct pollfd> lPolls;
+		std::vector<unsigned int> lPolled;
+		char lBuffer[4096];
+		for(;;) {
+			lPolls.clear();
+			lPolled.clear();
+			for(unsigned int i = 0; i < lNbProcesses; ++i) {
+				if(lProcesses[i].mPipe < 0) continue;
+				struct pollfd lPoll;
+				lPoll.fd = lProcesses[i].mPipe;
+				lPoll.events = POLLIN;
+				lPoll.revents = 0;
+				lPolls.push_back(lPoll);
+				lPolled.push_back(i);
+			}
+			if(lPolls.empty()) break;
+
+			if(poll(&lPolls[0], lPolls.size(), -1) < 0) {
+				if(errno == EINTR) continue;
+				throw std::runtime_error(std::string("EvaluationSandbox: poll failed: ")+strerror(errno));
+			}
+			for(unsigned int j = 0; j < lPolls.size(); ++j) {
+				if(lPolls[j].revents == 0) continue;
+				Process& lProcess = lProcesses[lPolled[j]];
+				ssize_t lCount = ::read(lProcess.mPipe, lBuffer, sizeof(lBuffer));
+				if(lCount > 0) {
+					lProcess.mBuffer.append(lBuffer, lCount);
+					decode(lProcess);
+				} else if(lCount == 0 || errno != EINTR) {
+					finish(lProcess);
+				}
+			}
+		}
+	} catch(...) {
+		for(unsigned int i = 0; i < lNbProcesses; ++i) {
+			if(lProcesses[i].mPipe < 0) continue;
+			kill(lProcesses[i].mPid, SIGKILL);
+			::close(lProcesses[i].mPipe);
+			while(waitpid(lProcesses[i].mPid, NULL, 0) < 0 && errno == EINTR);
+		}
+		throw;
+	}
+}
+
+/*! \brief Fork a process for the remaining jobs of a batch
+ */
+void EvaluationSandbox::start(Process& ioProcess) {
+	//The output buffered before the fork would be written by every child
+	std::cout.flush();
+	std::cerr.flush();
+	fflush(NULL);
+
+	int lPipe[2];
+	if(pipe(lPipe) != 0)
+		throw std::runtime_error(std::string("EvaluationSandbox: pipe failed: ")+strerror(errno));
+	pid_t lPid = fork();
+	if(lPid < 0) {
+		::close(lPipe[0]);
+		::close(lPipe[1]);
+		throw std::runtime_error(std::string("EvaluationSandbox: fork failed: ")+strerror(errno));
+	}
+	if(lPid == 0) {
+		::close(lPipe[0]);
+		runChild(ioProcess, lPipe[1]);
+	}
+	::close(lPipe[1]);
+	ioProcess.mPid = lPid;
+	ioProcess.mPipe = lPipe[0];
+	ioProcess.mBuffer.clear();
+}
+
+/*! \brief Run the jobs of a batch in the child process and exit
+ *  Each result is sent as a "job size" header line followed by the result.
+ */
+void EvaluationSandbox::runChild(const Process& inProcess, int inPipe) {
+	int lExitCode = EXIT_SUCCESS;
+	try {
+		signal(SIGALRM, SIG_DFL);
+		signal(SIGPIPE, SIG_DFL);
+		if(mMemoryBudget > 0) {
+			struct rlimit lLimit;
+			lLimit.rlim_cur = lLimit.rlim_max = (rlim_t)mMemoryBudget*1024*1024;
+			setrlimit(RLIMIT_AS, &lLimit);
+		}
+		prepareChild();
+
+		for(unsigned int i = inProcess.mNextJob; i < inProcess.mJobs.size(); ++i) {
+			if(mTimeBudget > 0) setTimer(mTimeBudget);
+			std::string lResult = runJob(inProcess.mJobs[i]);
+			if(mTimeBudget > 0) setTimer(0);
+
+			std::ostringstream lHeader;
+			lHeader << inProcess.mJobs[i] << " " << lResult.size() << "\n";
+			if(!writeAll(inPipe, lHeader.str()) || !writeAll(inPipe, lResult)) {
+				lExitCode = EXIT_FAILURE;
+				break;
+			}
+		}
+	} catch(std::exception& inError) {
+		std::cerr << "Evaluation sandbox: " << inError.what() << std::endl;
+		lExitCode = EXIT_FAILURE;
+	} catch(...) {
+		std::cerr << "Evaluation sandbox: unknown exception" << std::endl;
+		lExitCode = EXIT_FAILURE;
+	}
+	std::cout.flush();
+	std::cerr.flush();
+	fflush(NULL);
+	//The destructors of the parent objects must not run in the child
+	_exit(lExitCode);
+}
+
+/*! \brief Hand over the complete results received from a process
+ */
+void EvaluationSandbox::decode(Process& ioProcess) {
+	for(;;) {
+		std::string::size_type lEnd = ioProcess.mBuffer.find('\n');
+		if(lEnd == std::string::npos) return;
+
+		std::istringstream lHeader(ioProcess.mBuffer.substr(0, lEnd));
+		unsigned int lJob;
+		std::string::size_type lSize;
+		lHeader >> lJob >> lSize;
+		if(lHeader.fail() || ioProcess.mNextJob >= ioProcess.mJobs.size() || lJob != ioProcess.mJobs[ioProcess.mNextJob])
+			throw std::runtime_error("EvaluationSandbox: corrupted result received from a child process");
+		if(ioProcess.mBuffer.size() < lEnd+1+lSize) return;
+
+		std::string lResult = ioProcess.mBuffer.substr(lEnd+1, lSize);
+		ioProcess.mBuffer.erase(0, lEnd+1+lSize);
+		++ioProcess.mNextJob;
+		receiveResult(lJob, lResult);
+	}
+}
+
+/*! \brief Collect a process that closed its pipe
+ *  If the batch is not complete, the job in progress killed the process. It is reported as
+ *	failed and a new process is forked for the rest of the batch.
+ */
+void EvaluationSandbox::finish(Process& ioProcess) {
+	::close(ioProcess.mPipe);
+	ioProcess.mPipe = -1;
+	int lStatus = 0;
+	while(waitpid(ioProcess.mPid, &lStatus, 0) < 0 && errno == EINTR);
+	if(ioProcess.mNextJob >= ioProcess.mJobs.size()) return;
+
+	std::ostringstream lReason;
+	if(WIFSIGNALED(lStatus)) {
+		if(WTERMSIG(lStatus) == SIGALRM)
+			lReason << "time budget of " << mTimeBudget << " s exceeded";
+		else
+			lReason << "killed by signal " << WTERMSIG(lStatus);
+	} else {
+		lReason << "exited with code " << WEXITSTATUS(lStatus);
+	}
+	unsigned int lJob = ioProcess.mJobs[ioProcess.mNextJob++];
+	receiveFailure(lJob, lReason.str());
+
+	if(ioProcess.mNextJob < ioProcess.mJobs.size())
+		start(ioProcess);
+}
@@ -0,0 +1,74 @@
+/*
+ *  EvaluationSandbox.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef EvaluationSandbox_H
+#define EvaluationSandbox_H
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/*! \brief Run jobs in forked processes
+ *  The jobs are split in batches, each batch is run by a child process which sends the result
+ *	of every job back through a pipe. A job that crashes its process, exceeds the time budget or
+ *	the memory budget is reported as failed, and a new process is forked for the rest of its
+ *	batch. The child processes only have the thread that forked them, a mutex held by another
+ *	thread at the fork would stay locked in the child: the caller must run no other thread.
+ *	prepareChild() can start the threads of the child.
+ */
+class EvaluationSandbox {
+public:
+	EvaluationSandbox(unsigned int inNbProcesses, double inTimeBudget = 0, unsigned int inMemoryBudget = 0);
+	virtual ~EvaluationSandbox() {}
+
+	void run(const std::vector<unsigned int>& inJobs);
+
+protected:
+	//! Prepare the child process after the fork.
+	virtual void prepareChild() {}
+	//! Run a job in the child process and return its serialized result.
+	virtual std::string runJob(unsigned int inJob) = 0;
+	//! Receive the result of a job in the parent process.
+	virtual void receiveResult(unsigned int inJob, const std::string& inResult) = 0;
+	//! Receive the reason why a job killed its process.
+	virtual void receiveFailure(unsigned int inJob, const std::string& inReason) = 0;
+
+private:
+	struct Process {
+		pid_t mPid;
+		int mPipe;						//!< Read end of the result pipe, -1 when the process is done
+		std::vector<unsigned int> mJobs;
+		unsigned int mNextJob;			//!< Next job to receive
+		std::string mBuffer;			//!< Received data not yet decoded
+	};
+
+	void start(Process& ioProcess);
+	void runChild(const Process& inProcess, int inPipe);
+	void decode(Process& ioProcess);
+	void finish(Process& ioProcess);
+
+	unsigned int mNbProcesses;
+	double mTimeBudget;				//!< Wall-clock time allowed to a job in seconds, 0 if unlimited
+	unsigned int mMemoryBudget;		//!< Address space allowed to a process in MB, 0 if unlimited
+};
+
+#endif
@@ -0,0 +1,125 @@
+/*
+ *  EvaluationServer.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#include "EvaluationServer.h"
+#include "BondGraphEvalOp.h"
+#include <PACC/Socket/Cafe.hpp>
+#include <PACC/XML.hpp>
+#include <iostream>
+#include <sstream>
+
+using namespace Beagle;
+
+//! Build the reply of a failed request.
+static std::string writeError(const std::string& inMessage) {
+	std::ostringstream lReply;
+	PACC::XML::Streamer lStreamer(lReply);
+	lStreamer.openTag("Error", false);
+	lStreamer.insertStringContent(inMessage);
+	lStreamer.closeTag();
+	return lReply.str();
+}
+
+/*! \brief Bind the server to its port
+ *  \param  inOp Evaluation operator of the worker.
+ *  \param  ioDeme Deme of the worker, its individual allocator is used to read the requests.
+ *  \param  inContext Evaluation context, it must not be used by anyone else.
+ *  \param  inPort Port to listen to.
+ *  \param  inCompressionLevel Compression level of the replies, 0 to 9.
+ */
+EvaluationServer::EvaluationServer(BondGraphEvalOp& inOp, Deme& ioDeme, BGContext::Handle inContext,
+								   unsigned int inPort, unsigned int inCompressionLevel) :
+PACC::Socket::TCPServer(inPort, 1), mOp(inOp), mDeme(ioDeme), mContext(inContext),
+mCompressionLevel(inCompressionLevel), mNbEvaluations(0), mSetupDone(false)
+{ }
+
+/*! \brief Answer the requests of a master until it closes the connection
+ */
+void EvaluationServer::main(int inDescriptor, const PACC::Socket::ServerThread* inThread) {
+	PACC::Socket::Cafe lSocket(inDescriptor);
+	try {
+		while(!inThread->shouldTerminate()) {
+			std::string lRequest;
+			lSocket.receiveMessage(lRequest);
+			lSocket.sendMessage(evaluate(lRequest), mCompressionLevel);
+		}
+	} catch(const PACC::Socket::Exception& inError) {
+		if(inError.getErrorCode() != PACC::Socket::eConnectionClosed)
+			std::cerr << "Evaluation server: " << inError.getMessage() << std::endl;
+	}
+	//The worker lives as long as its master
+	halt();
+}
+
+/*! \brief Answer a request of the master
+ *  \param  inRequest <Setup> or <Evaluate> message of the master.
+ *  \return Reply message, the fitness or the error raised by the evaluation.
+ */
+std::string EvaluationServer::evaluate(const std::string& inRequest) {
+	try {
+		std::istringstream lStream(inRequest);
+		PACC::XML::Document lDocument(lStream);
+		PACC::XML::ConstIterator lRequest = lDocument.getFirstDataTag();
+		if(lRequest && lRequest->getValue() == "Setup") {
+			mOp.readFarmSetup(lRequest);
+			mSetupDone = true;
+			return "<Ready/>";
+		}
+		if(!lRequest || lRequest->getValue() != "Evaluate")
+			throw Beagle_IOExceptionMessageM("tag <Evaluate> expected!");
+		if(!mSetupDone)
+			throw Beagle_RunTimeExceptionM("EvaluationServer : the master must send its <Setup> before the evaluations");
+
+		PACC::XML::ConstIterator lNode = lRequest->getFirstChild();
+		while(lNode && (lNode->getType() != PACC::XML::eData || lNode->getValue() != "Individual"))
+			lNode = lNode->getNextSibling();
+		if(!lNode)
+			throw Beagle_IOExceptionNodeM(*lRequest, "tag <Individual> expected!");
+
+		unsigned int lIndex = str2uint(lRequest->getAttribute("index"));
+		mContext->setGeneration(str2uint(lRequest->getAttribute("generation")));
+		mContext->setSubGeneration(str2int(lRequest->getAttribute("subgeneration")));
+		mOp.mRacingThreshold = str2dbl(lRequest->getAttribute("racing"));
+
+		Individual::Handle lIndividual = castHandleT<Individual>(mDeme.getTypeAlloc()->allocate());
+		lIndividual->readWithContext(lNode, *mContext);
+		mContext->setIndividualIndex(lIndex);
+		mContext->setIndividualHandle(lIndividual);
+		Fitness::Handle lFitness = mOp.Beagle::GP::EvaluationOp::evaluate(*lIndividual, *mContext);
+		mContext->setIndividualHandle(NULL);
+		++mNbEvaluations;
+
+		std::ostringstream lReply;
+		PACC::XML::Streamer lStreamer(lReply);
+		lStreamer.openTag("Result", false);
+		lStreamer.insertAttribute("index", uint2str(lIndex));
+		lFitness->write(lStreamer, false);
+		lStreamer.closeTag();
+		return lReply.str();
+	} catch(Beagle::Exception& inException) {
+		mContext->setIndividualHandle(NULL);
+		return writeError(inException.getMessage());
+	} catch(std::exception& inException) {
+		mContext->setIndividualHandle(NULL);
+		return writeError(inException.what());
+	}
+}
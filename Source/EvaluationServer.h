@@ -0,0 +1,63 @@
+/*
+ *  EvaluationServer.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef EvaluationServer_H
+#define EvaluationServer_H
+
+#include <string>
+#include <beagle/GP.hpp>
+#include <PACC/Socket/TCPServer.hpp>
+#include "BGContext.h"
+
+class BondGraphEvalOp;
+
+/*! \brief Evaluation server of a worker process of the evaluation farm
+ *  The master first sends its simulation cases, which replace the cases of the worker:
+ *	<Setup>binary cases in base64</Setup>, answered by <Ready/>.
+ *	It then sends one request per individual over the Cafe connection:
+ *	<Evaluate index="" generation="" subgeneration="" racing=""><Individual>...</Individual></Evaluate>
+ *	The server reads the individual in its own context, evaluates it with the evaluation operator
+ *	and replies with <Result index=""><Fitness>...</Fitness></Result>, or <Error>message</Error>
+ *	if the evaluation raised an exception. The server handles one master at a time and stops
+ *	when its master closes the connection.
+ */
+class EvaluationServer : public PACC::Socket::TCPServer {
+public:
+	EvaluationServer(BondGraphEvalOp& inOp, Beagle::Deme& ioDeme, BGContext::Handle inContext,
+					 unsigned int inPort, unsigned int inCompressionLevel = 0);
+	virtual ~EvaluationServer() { wait(); }
+
+	unsigned long getNumberOfEvaluations() const { return mNbEvaluations; }
+
+protected:
+	virtual void main(int inDescriptor, const PACC::Socket::ServerThread* inThread);
+	std::string evaluate(const std::string& inRequest);
+
+	BondGraphEvalOp& mOp;
+	Beagle::Deme& mDeme;				//!< Deme of the worker, used to allocate the individuals
+	BGContext::Handle mContext;			//!< Evaluation context of the worker
+	unsigned int mCompressionLevel;		//!< Compression level of the replies
+	unsigned long mNbEvaluations;
+	bool mSetupDone;					//!< True once the simulation cases of the master are known
+};
+
+#endif
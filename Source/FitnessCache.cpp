@@ -0,0 +1,95 @@
+/*
+ *  FitnessCache.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *  
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#include "FitnessCache.h"
+
+FitnessCache::FitnessCache(unsigned int inCapacity) : mCapacity(inCapacity), mHits(0), mMisses(0) { }
+
+FitnessCache::~FitnessCache() {
+	clear();
+}
+
+/*! \brief Set the maximum number of entries
+ *  \param  inCapacity Maximum number of entries, 0 disable the table.
+ */
+void FitnessCache::setCapacity(unsigned int inCapacity) {
+	mMutex.lock();
+	mCapacity = inCapacity;
+	evict();
+	mMutex.unlock();
+}
+
+/*! \brief Look for a stored fitness
+ *  \param  inKey Key of the evaluated object.
+ *  \param  outFitness Copy of the stored fitness if found.
+ *  \return True if the key was found.
+ */
+bool FitnessCache::lookup(const std::string& inKey, BGFitness& outFitness) {
+	mMutex.lock();
+	std::map<std::string, EntryList::iterator>::iterator lIter = mIndex.find(inKey);
+	bool lFound = (lIter != mIndex.end());
+	if(lFound) {
+		//Move the entry to the front of the list
+		mEntries.splice(mEntries.begin(), mEntries, lIter->second);
+		outFitness = *(lIter->second->second);
+		++mHits;
+	} else {
+		++mMisses;
+	}
+	mMutex.unlock();
+	return lFound;
+}
+
+/*! \brief Store a fitness
+ *  \param  inKey Key of the evaluated object.
+ *  \param  inFitness Fitness to copy in the table.
+ */
+void FitnessCache::insert(const std::string& inKey, const BGFitness& inFitness) {
+	mMutex.lock();
+	if(mCapacity > 0 && mIndex.find(inKey) == mIndex.end()) {
+		BGFitness* lFitness = new BGFitness;
+		*lFitness = inFitness;
+		mEntries.push_front(std::make_pair(inKey, lFitness));
+		mIndex[inKey] = mEntries.begin();
+		evict();
+	}
+	mMutex.unlock();
+}
+
+void FitnessCache::clear() {
+	mMutex.lock();
+	for(EntryList::iterator lIter = mEntries.begin(); lIter != mEntries.end(); ++lIter) {
+		delete lIter->second;
+	}
+	mEntries.clear();
+	mIndex.clear();
+	mMutex.unlock();
+}
+
+//! Drop the least recently used entries over the capacity, the mutex must be locked.
+void FitnessCache::evict() {
+	while(mIndex.size() > mCapacity) {
+		mIndex.erase(mEntries.back().first);
+		delete mEntries.back().second;
+		mEntries.pop_back();
+	}
+}
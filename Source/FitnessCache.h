@@ -0,0 +1,67 @@
+/*
+ *  FitnessCache.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *  
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef FitnessCache_H
+#define FitnessCache_H
+
+#include <string>
+#include <list>
+#include <map>
+#include <PACC/Threading.hpp>
+#include "BGFitness.h"
+
+/*! \brief Bounded memo table of evaluated fitness
+ *  The fitness are stored by key, usually the encoding of the simplified bond graph. When the
+ *	table is full, the least recently used entry is dropped. The bond graphs of the fitness are
+ *	not kept, only the values and the logged data. The table can be used by concurrent evaluations.
+ */
+class FitnessCache {
+public:
+	explicit FitnessCache(unsigned int inCapacity = 0);
+	~FitnessCache();
+	
+	void setCapacity(unsigned int inCapacity);
+	unsigned int getCapacity() const { return mCapacity; }
+	unsigned int size() const { return mIndex.size(); }
+	
+	bool lookup(const std::string& inKey, BGFitness& outFitness);
+	void insert(const std::string& inKey, const BGFitness& inFitness);
+	void clear();
+	
+	unsigned long getHits() const { return mHits; }
+	unsigned long getMisses() const { return mMisses; }
+	void resetCounters() { mHits = 0; mMisses = 0; }
+	
+private:
+	typedef std::list< std::pair<std::string, BGFitness*> > EntryList;
+	
+	void evict();
+	
+	unsigned int mCapacity;
+	EntryList mEntries;		//!< Entries, most recently used first
+	std::map<std::string, EntryList::iterator> mIndex;
+	unsigned long mHits;
+	unsigned long mMisses;
+	PACC::Threading::Mutex mMutex;
+};
+
+#endif
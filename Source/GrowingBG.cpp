@@ -23,11 +23,150 @@
 #include "GrowingBG.h"
 
 #include "Defines.h"
+#include <algorithm>
 
 using namespace BG;
 
+#ifdef USE_COMPONENT_ARENA
+//The bond graph deletes the objects of the arena through these classes
+template struct ArenaDeletableT<Component>;
+template struct ArenaDeletableT<Bond>;
+template struct ArenaDeletableT<Port>;
+#endif
+
 GrowingBG::GrowingBG() : Beagle::Object() { 
 	mValidCausality = false; 
+	mComponentArena = 0;
+}
+
+/*! \brief Find the strong bond of a junction
+ *  The strong bond is the one imposing the effort on a 0-junction, or the flow on a 1-junction.
+ *	Its junction side port is the only one with a different causality. The strong bond can only
+ *	be told apart when the junction has at least three bonds.
+ *  \param  inJunction Junction.
+ *  \param  inIgnoredPort Port of the junction to ignore, can be NULL.
+ *  \return The junction port of the strong bond, or NULL if it can't be determined.
+ */
+Port* GrowingBG::findStrongPort(Junction* inJunction, Port* inIgnoredPort) {
+	std::vector<Port*> lAllPorts = inJunction->getPorts();
+	std::vector<Port*> lPorts;
+	for(unsigned int i = 0; i < lAllPorts.size(); ++i) {
+		if(lAllPorts[i] != inIgnoredPort && lAllPorts[i]->getBond() != 0)
+			lPorts.push_back(lAllPorts[i]);
+	}
+	if(lPorts.size() < 3)
+		return 0;
+	
+	Port* lStrongPort = 0;
+	for(unsigned int i = 0; i < lPorts.size(); ++i) {
+		unsigned int lNbSame = 0;
+		for(unsigned int j = 0; j < lPorts.size(); ++j) {
+			if(i != j && lPorts[i]->getCausality() == lPorts[j]->getCausality())
+				++lNbSame;
+		}
+		if(lNbSame == 0) {
+			if(lStrongPort != 0)
+				return 0;
+			lStrongPort = lPorts[i];
+		} else if(lNbSame != lPorts.size()-2) {
+			return 0;
+		}
+	}
+	return lStrongPort;
+}
+
+/*! \brief Tell if a one-port component accepts the causality imposed by a junction
+ *  A 0-junction imposes the effort on its weak bonds, which suits a resistor, an inductor in
+ *	integral causality and a flow source. A 1-junction imposes the flow, which suits a resistor, a
+ *	capacitor in integral causality and an effort source.
+ */
+bool GrowingBG::acceptsJunctionCausality(Junction* inJunction, Component* inComponent) {
+	bool lZeroJunction = (inJunction->getType() == Junction::eZero);
+	if(Passive* lPassive = dynamic_cast<Passive*>(inComponent)) {
+		switch(lPassive->getType()) {
+			case Passive::eResistor:
+				return true;
+			case Passive::eInductor:
+				return lZeroJunction;
+			case Passive::eCapacitor:
+				return !lZeroJunction;
+			default:
+				return false;
+		}
+	}
+	if(Source* lSource = dynamic_cast<Source*>(inComponent)) {
+		if(lZeroJunction)
+			return lSource->getType() == Source::eFlow;
+		return lSource->getType() == Source::eEffort;
+	}
+	return false;
+}
+
+/*! \brief Assign the causality of a bond newly connected to a junction
+ *  The new bond is given the causality of a weak bond of the junction with the same power
+ *	direction, the causality of the rest of the bond graph is unchanged. It is only possible when
+ *	the causality is valid, the strong bond of the junction is known and the component accepts
+ *	the causality of a weak bond.
+ *  \param  inJunction Junction where the component is connected.
+ *  \param  inComponent New one-port component.
+ *  \param  inBond New bond between the junction and the component.
+ *  \return True if the causality is still valid.
+ */
+bool GrowingBG::extendCausality(Junction* inJunction, Component* inComponent, Bond* inBond) {
+	if(!mValidCausality || inComponent->getPorts().size() != 1)
+		return false;
+	if(!acceptsJunctionCausality(inJunction,inComponent))
+		return false;
+	
+	Port* lJunctionPort = inBond->getFromPort();
+	Port* lComponentPort = inBond->getToPort();
+	if(lJunctionPort->getComponent() != inJunction)
+		std::swap(lJunctionPort,lComponentPort);
+	
+	Port* lStrongPort = findStrongPort(inJunction,lJunctionPort);
+	if(lStrongPort == 0)
+		return false;
+	
+	std::vector<Port*> lPorts = inJunction->getPorts();
+	for(unsigned int i = 0; i < lPorts.size(); ++i) {
+		if(lPorts[i] == lJunctionPort || lPorts[i] == lStrongPort || lPorts[i]->getBond() == 0)
+			continue;
+		if(lPorts[i]->isPowerSide() != lJunctionPort->isPowerSide())
+			continue;
+		
+		Bond* lBond = lPorts[i]->getBond();
+		Port* lOtherPort = (lBond->getFromPort() == lPorts[i]) ? lBond->getToPort() : lBond->getFromPort();
+		lJunctionPort->setCausality(lPorts[i]->getCausality());
+		lComponentPort->setCausality(lOtherPort->getCausality());
+		return true;
+	}
+	return false;
+}
+
+/*! \brief Tell if the causality stays valid when a one-port component is replaced
+ *  The ports of the old component are given to the new one with their causality. The causality
+ *	stays valid when the component is on a weak bond of a junction and the new component
+ *	accepts the causality imposed by the junction.
+ *  \param  inOldComponent Component to be replaced.
+ *  \param  inNewComponent Replacing component.
+ */
+bool GrowingBG::keepsCausality(Component* inOldComponent, Component* inNewComponent) const {
+	if(!mValidCausality)
+		return false;
+	std::vector<Port*> lPorts = inOldComponent->getPorts();
+	if(lPorts.size() != 1 || lPorts[0]->getBond() == 0)
+		return false;
+	
+	Bond* lBond = lPorts[0]->getBond();
+	Port* lOtherPort = (lBond->getFromPort() == lPorts[0]) ? lBond->getToPort() : lBond->getFromPort();
+	Junction* lJunction = dynamic_cast<Junction*>(lOtherPort->getComponent());
+	if(lJunction == 0)
+		return false;
+	
+	Port* lStrongPort = findStrongPort(lJunction,0);
+	if(lStrongPort == 0 || lStrongPort == lOtherPort)
+		return false;
+	return acceptsJunctionCausality(lJunction,inNewComponent);
 }
 
 //void GrowingBG::clearCausality() {
@@ -29,6 +29,7 @@
 #include <beagle/ContainerT.hpp>
 #include <beagle/Matrix.hpp>
 #include <beagle/GA/FloatVector.hpp>
+#include "ComponentArena.h"
 
 class GrowingBG : public Beagle::Object {
 public:
@@ -44,6 +45,7 @@ public:
 	
 	void setCausalityInvalid() { mValidCausality = false; }
 	bool isCausalityValid() const { return mValidCausality; }
+	bool keepsCausality(BG::Component* inOldComponent, BG::Component* inNewComponent) const;
 	
 	virtual void clearCausality() = 0;
 	virtual void assignCausality() = 0;
@@ -60,8 +62,16 @@ public:
 	
 	virtual BG::BondGraph* getBondGraph() = 0;
 	
+	//! Set the arena of the bonds and ports created by the insertions, 0 uses the heap.
+	void setComponentArena(ComponentArena* inArena) { mComponentArena = inArena; }
+	
 protected:
+	bool extendCausality(BG::Junction* inJunction, BG::Component* inComponent, BG::Bond* inBond);
+	static BG::Port* findStrongPort(BG::Junction* inJunction, BG::Port* inIgnoredPort);
+	static bool acceptsJunctionCausality(BG::Junction* inJunction, BG::Component* inComponent);
+	
 	bool mValidCausality;	//!< Indicate that the previously computed causality is still valid.
+	ComponentArena* mComponentArena;	//!< Arena of the context building the bond graph.
 	
 };
 
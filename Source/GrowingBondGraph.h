@@ -48,6 +48,7 @@ public:
 	bool isCausalityValid() const { return mValidCausality; }
 	void clearCausality();
 	void assignCausality();
+	void simplify();
 	
 	void insertJunction(BG::Bond* inBond, BG::Junction* inJunction, BG::Bond*& outBond);
 	void insertComponent(BG::Junction* inJunction, BG::Component* inComponent, BG::Bond*& outBond);
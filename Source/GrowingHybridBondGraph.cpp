@@ -47,6 +47,16 @@ void GrowingHybridBondGraph::assignCausality() {
 	mValidCausality = true;
 }
 
+/*! \brief Simplify the bond graph
+ *  The causality is kept when the simplification leaves the bond graph unchanged.
+ */
+void GrowingHybridBondGraph::simplify() {
+	unsigned int lNbComponents = getComponents().size();
+	BG::HybridBondGraph::simplify();
+	if(getComponents().size() != lNbComponents)
+		mValidCausality = false;
+}
+
 /*! \brief Insert a junction
  *  Insert a junction on a existing bond. If there is a non-jonction component attached to
  *	the bond, the existing bond will be attached to the non-junction component. If the bond
@@ -62,12 +72,12 @@ void GrowingHybridBondGraph::insertJunction(BG::Bond* inBond, BG::Junction* inJu
 	addComponent(inJunction);
 	
 	//Create a new bond
-	outBond = new Bond();
+	outBond = mComponentArena != 0 ? mComponentArena->create<Bond>() : new Bond();
 	addBond(outBond);
 	
 	//Create new ports
-	Port *lNewFromPort  = new Port(false);
-	Port *lNewToPort = new Port(true);
+	Port *lNewFromPort  = mComponentArena != 0 ? mComponentArena->create<Port>(false) : new Port(false);
+	Port *lNewToPort = mComponentArena != 0 ? mComponentArena->create<Port>(true) : new Port(true);
 	
 	//Get existing ports
 	Port *lFromPort  = inBond->getFromPort();
@@ -111,10 +121,18 @@ void GrowingHybridBondGraph::insertSwitch(BG::Junction* inJunction, BG::Switch*
 }
 
 
+/*! \brief Connect a new component to a junction
+ *  The causality of the new bond is assigned locally when possible, otherwise the causality
+ *	of the bond graph is invalidated.
+ *  \param  inJunction Junction where the component is connected.
+ *  \param  inComponent New component.
+ *  \param  outBond New bond created by the insertion.
+ */
 void GrowingHybridBondGraph::insertComponent(BG::Junction* inJunction, BG::Component* inComponent, BG::Bond*& outBond) {
 	addComponent(inComponent);
 	outBond = connect(inJunction,inComponent);
-	mValidCausality = false;
+	if(!extendCausality(inJunction,inComponent,outBond))
+		mValidCausality = false;
 }
 
 
@@ -48,6 +48,7 @@ public:
 	bool isCausalityValid() const { return mValidCausality; }
 	void clearCausality();
 	void assignCausality();
+	void simplify();
 	
 	void insertSwitch(BG::Junction* inJunction, BG::Switch* inComponent, BG::Bond*& outBond);
 	
@@ -46,7 +46,7 @@ void InsertJunction::insert(Beagle::GP::Datum& inBond, BG::Junction::JunctionTyp
 	BondPtr& lInBond = castObjectT<BondPtr&>(inBond);
 	GrowingBG::Handle lGrowingBondGraph = lContext.getBondGraph();
 	
-	BG::Junction* lNewJunction = new BG::Junction(inType);
+	BG::Junction* lNewJunction = lContext.getComponentArena().create<BG::Junction>(inType);
 	BG::Bond* lNewBond = 0;
 
 	lGrowingBondGraph->insertJunction(lInBond.getValue(),lNewJunction,lNewBond);
@@ -34,8 +34,8 @@ void InsertJunctionPair::insert(Beagle::GP::Datum& inBond, BG::Junction::Junctio
 	BondPtr& lInBond = castObjectT<BondPtr&>(inBond);
 	GrowingBG::Handle lGrowingBondGraph = lContext.getBondGraph();
 	
-	BG::Junction* lNewJunction1 = new BG::Junction(inType1);
-	BG::Junction* lNewJunction2 = new BG::Junction(inType2);
+	BG::Junction* lNewJunction1 = lContext.getComponentArena().create<BG::Junction>(inType1);
+	BG::Junction* lNewJunction2 = lContext.getComponentArena().create<BG::Junction>(inType2);
 	
 	BG::Bond* lNewBond1 = 0;
 	BG::Bond* lNewBond2 = 0;
@@ -61,8 +61,8 @@ void InsertJunctionPair::insertAtJunction(Beagle::GP::Datum& inJunction, BG::Jun
 	JunctionPtr& lInJunction = castObjectT<JunctionPtr&>(inJunction);
 	GrowingBG::Handle lGrowingBondGraph = lContext.getBondGraph();
 	
-	BG::Junction* lNewJunction1 = new BG::Junction(inType1);
-	BG::Junction* lNewJunction2 = new BG::Junction(inType2);
+	BG::Junction* lNewJunction1 = lContext.getComponentArena().create<BG::Junction>(inType1);
+	BG::Junction* lNewJunction2 = lContext.getComponentArena().create<BG::Junction>(inType2);
 	
 	BG::Bond* lNewBond1 = 0;
 	BG::Bond* lNewBond2 = 0;
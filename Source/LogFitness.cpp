@@ -25,13 +25,48 @@
 #include <cfloat>
 #include <algorithm>
 #include "stringcompression.h"
+#include "DataCodec.h"
 #include <assert.h>
 
 using namespace Beagle;
 
+LogFitness::DataEncoding LogFitness::smDataEncoding = LogFitness::eXorBase64;
+
 LogFitness::LogFitness() : FitnessSimple() {}
 LogFitness::LogFitness(float inFitness) : FitnessSimple(inFitness) {}
 
+/*! \brief Read a <Data> tag
+ *  The data is kept encoded, it is decoded on request by getData.
+ */
+void LogFitness::readData(PACC::XML::ConstIterator inNode, unsigned int inDataSet) {
+	mVariableName.push_back(inNode->getAttribute("Name"));
+	mVariableDataSet.push_back(inDataSet);
+	mVariableEncoding.push_back(inNode->getAttribute("enc"));
+	mUncompressedSize.push_back( str2uint(inNode->getAttribute("usize")) );
+	if(mUncompressedSize.back() != 0) {
+		PACC::XML::ConstIterator lChild = inNode->getFirstChild();
+		if(!lChild) {
+			throw Beagle_IOExceptionNodeM((*inNode), "needed a CDATA value in the <Path> tag!");
+		}
+		if(lChild->getType() != PACC::XML::eString) {
+			throw Beagle_IOExceptionNodeM((*lChild), "needed a string value in the <Path> tag!");
+		}
+		mVariableData.push_back(lChild->getValue());
+	} else {
+		mVariableData.push_back("");
+	}
+}
+
+void LogFitness::writeData(PACC::XML::Streamer& ioStreamer, unsigned int inIndex) const {
+	ioStreamer.openTag("Data", false);
+	ioStreamer.insertAttribute("Name", mVariableName[inIndex]);
+	if(!mVariableEncoding[inIndex].empty())
+		ioStreamer.insertAttribute("enc", mVariableEncoding[inIndex]);
+	ioStreamer.insertAttribute("usize", uint2str(mUncompressedSize[inIndex]));
+	ioStreamer.insertStringContent(mVariableData[inIndex]);
+	ioStreamer.closeTag();
+}
+
 
 void LogFitness::read(PACC::XML::ConstIterator inIter) {	
 	Beagle_StackTraceBeginM();
@@ -46,10 +81,7 @@ void LogFitness::read(PACC::XML::ConstIterator inIter) {
 		if(lType != "LogFitness")
 			throw Beagle_IOExceptionNodeM((*inIter), "fitness type mismatch!");
 		
-		mUncompressedSize.clear();
-		mVariableData.clear();
-		mVariableName.clear();
-		mInfo.clear();
+		clearData();
 		
 		for(PACC::XML::ConstIterator lChild=inIter->getFirstChild(); lChild; lChild=lChild->getNextSibling()) {
 			if(lChild->getValue() == "Obj") {
@@ -62,20 +94,7 @@ void LogFitness::read(PACC::XML::ConstIterator inIter) {
 
 			}
 			else if(lChild->getValue() == "Data") {
-				mVariableName.push_back(lChild->getAttribute("Name"));
-				mUncompressedSize.push_back( str2uint(lChild->getAttribute("usize")) );
-				if(str2uint(lChild->getAttribute("usize")) != 0) {
-					PACC::XML::ConstIterator lChild2 = lChild->getFirstChild();
-					if(!lChild2) {
-						throw Beagle_IOExceptionNodeM((*lChild), "needed a CDATA value in the <Path> tag!");
-					}
-					if(lChild2->getType() != PACC::XML::eString) {
-						throw Beagle_IOExceptionNodeM((*lChild2), "needed a string value in the <Path> tag!");
-					}
-					mVariableData.push_back(lChild2->getValue());
-				} else {
-					mVariableData.push_back("");
-				}
+				readData(lChild, 0);
 			}
 			else if(lChild->getValue() == "DataSet") {
 				unsigned int lID = str2uint(lChild->getAttribute("ID"));
@@ -89,21 +108,7 @@ void LogFitness::read(PACC::XML::ConstIterator inIter) {
 						lFitness = str2dbl(lChild3->getValue());
 					}
 					else if(lChild2->getValue() == "Data") {
-						mVariableName.push_back(lChild2->getAttribute("Name"));
-						mVariableDataSet.push_back(lID);
-						mUncompressedSize.push_back( str2uint(lChild2->getAttribute("usize")) );
-						if(str2uint(lChild2->getAttribute("usize")) != 0) {
-							PACC::XML::ConstIterator lChild3 = lChild2->getFirstChild();
-							if(!lChild3) {
-								throw Beagle_IOExceptionNodeM((*lChild2), "needed a CDATA value in the <Path> tag!");
-							}
-							if(lChild3->getType() != PACC::XML::eString) {
-								throw Beagle_IOExceptionNodeM((*lChild3), "needed a string value in the <Path> tag!");
-							}
-							mVariableData.push_back(lChild3->getValue());
-						} else {
-							mVariableData.push_back("");
-						}
+						readData(lChild2, lID);
 					}
 				}
 				
@@ -147,11 +152,7 @@ void LogFitness::write(PACC::XML::Streamer& ioStreamer, bool inIndent) const {
 		ioStreamer.closeTag();
 		if(mDataSet.size() == 0) {
 			for(unsigned int i = 0; i < mVariableData.size(); ++i) {
-				ioStreamer.openTag("Data", false);
-				ioStreamer.insertAttribute("Name", mVariableName[i]);
-				ioStreamer.insertAttribute("usize", uint2str(mUncompressedSize[i]));
-				ioStreamer.insertStringContent(mVariableData[i]);
-				ioStreamer.closeTag();
+				writeData(ioStreamer, i);
 			}
 		} else {
 			for(std::map<unsigned int, double>::const_iterator lIter = mDataSet.begin(); lIter != mDataSet.end(); ++lIter) {
@@ -162,11 +163,7 @@ void LogFitness::write(PACC::XML::Streamer& ioStreamer, bool inIndent) const {
 				ioStreamer.closeTag();
 				for(unsigned int i = 0; i < mVariableData.size(); ++i) {
 					if(lIter->first == mVariableDataSet[i]) {
-						ioStreamer.openTag("Data", false);
-						ioStreamer.insertAttribute("Name", mVariableName[i]);
-						ioStreamer.insertAttribute("usize", uint2str(mUncompressedSize[i]));
-						ioStreamer.insertStringContent(mVariableData[i]);
-						ioStreamer.closeTag();
+						writeData(ioStreamer, i);
 					}
 				}
 				ioStreamer.closeTag();
@@ -189,24 +186,60 @@ void LogFitness::write(PACC::XML::Streamer& ioStreamer, bool inIndent) const {
 }
 
 void LogFitness::addData(const std::string &inName, const std::vector<double> &inData, unsigned int inDataSet) {
-	ostringstream lDataStream;
 	assert(inData.size() > 0);
-	for(unsigned int i = 0; i < inData.size() - 1; ++i) {
-		lDataStream << inData[i] << " ";
-	}
-	lDataStream << inData.back();
-	
+	std::string lUncompressedStr;
 	std::string lCompressedStr;
-	compressString(lDataStream.str(), lCompressedStr);
-	string2hex(lCompressedStr);
-	
+	if(smDataEncoding == eXorBase64) {
+		encodeXorDoubles(inData, lUncompressedStr);
+		compressString(lUncompressedStr, lCompressedStr);
+		string2base64(lCompressedStr);
+		mVariableEncoding.push_back("xor");
+	} else {
+		ostringstream lDataStream;
+		for(unsigned int i = 0; i < inData.size() - 1; ++i) {
+			lDataStream << inData[i] << " ";
+		}
+		lDataStream << inData.back();
+		lUncompressedStr = lDataStream.str();
+		compressString(lUncompressedStr, lCompressedStr);
+		string2hex(lCompressedStr);
+		mVariableEncoding.push_back("");
+	}
 	
-	mUncompressedSize.push_back(lDataStream.str().size());
+	mUncompressedSize.push_back(lUncompressedStr.size());
 	mVariableData.push_back(lCompressedStr);
 	mVariableName.push_back(inName);
 	mVariableDataSet.push_back(inDataSet);
 }
 
+/*! \brief Decode the values of a logged variable
+ *  Both the text and the XOR encodings are decoded.
+ *  \return False if the encoding is unknown.
+ */
+bool LogFitness::getData(unsigned int inIndex, std::vector<double> &outData) const {
+	outData.clear();
+	if(mUncompressedSize[inIndex] == 0)
+		return true;
+	
+	std::string lDataStr = mVariableData[inIndex];
+	if(mVariableEncoding[inIndex] == "xor") {
+		base642string(lDataStr);
+		uncompressString(lDataStr, mUncompressedSize[inIndex]);
+		decodeXorDoubles(lDataStr, outData);
+	} else if(mVariableEncoding[inIndex].empty()) {
+		hex2string(lDataStr);
+		uncompressString(lDataStr, mUncompressedSize[inIndex]);
+		std::istringstream lDataStream(lDataStr);
+		double lValue;
+		while(lDataStream >> lValue) {
+			outData.push_back(lValue);
+		}
+	} else {
+		return false;
+	}
+	return true;
+}
+
 void LogFitness::addDataSet(unsigned int inID, float inFitness) {
 	mDataSet[inID] = inFitness;
 }
@@ -220,6 +253,7 @@ LogFitness& LogFitness::operator=(const LogFitness& inRightFitness) {
 	mVariableName = inRightFitness.mVariableName;
 	mVariableDataSet = inRightFitness.mVariableDataSet;
 	mUncompressedSize = inRightFitness.mUncompressedSize;
+	mVariableEncoding = inRightFitness.mVariableEncoding;
 	mDataSet = inRightFitness.mDataSet;
 	mInfo = inRightFitness.mInfo;
 	
@@ -29,16 +29,31 @@
 #include <vector>
 
 class LogFitness : public Beagle::FitnessSimple {
+public:
+	/*! \brief Storage format of the logged variables
+	 *  eTextHex writes the values as compressed text in hexadecimal, as in the former version.
+	 *	eXorBase64 XOR encodes the binary values, compresses the result and writes it in base64.
+	 */
+	enum DataEncoding {eTextHex, eXorBase64};
+	
 protected:
 	std::vector<std::string> mVariableData;
 	std::vector<std::string> mVariableName;
 	std::vector<unsigned int> mVariableDataSet;
 	std::vector<unsigned int> mUncompressedSize;
+	std::vector<std::string> mVariableEncoding; //!< Value of the enc attribute, empty for text in hexadecimal
 	
 	std::map<unsigned int, double> mDataSet;
 	
 	std::map<std::string, std::string> mInfo;
 	
+	static DataEncoding smDataEncoding;
+	
+#ifndef XMLBEAGLE
+	void readData(PACC::XML::ConstIterator inNode, unsigned int inDataSet);
+	void writeData(PACC::XML::Streamer& ioStreamer, unsigned int inIndex) const;
+#endif
+	
 public:
 	//! LogFitness allocator type.
 	typedef Beagle::AllocatorT<LogFitness,Beagle::FitnessSimple::Alloc>
@@ -69,11 +84,15 @@ public:
 	std::vector<std::string> getData() { return mVariableData; }
 	std::vector<std::string> getName() { return mVariableName; }
 	void addData(const std::string &inName, const std::vector<double> &inData, unsigned int inDataSet=0);
+	bool getData(unsigned int inIndex, std::vector<double> &outData) const;
 	void addDataSet(unsigned int inID, float inFitness);
 	
 	void addInfo(const std::string &inName, const std::string &inData);
 	
-	void clearData() { mDataSet.clear(); mVariableDataSet.clear(); mUncompressedSize.clear(); mVariableData.clear(); mVariableName.clear(); mInfo.clear(); }
+	void clearData() { mDataSet.clear(); mVariableDataSet.clear(); mUncompressedSize.clear(); mVariableData.clear(); mVariableEncoding.clear(); mVariableName.clear(); mInfo.clear(); }
+	
+	static void setDataEncoding(DataEncoding inEncoding) { smDataEncoding = inEncoding; }
+	static DataEncoding getDataEncoding() { return smDataEncoding; }
 };
 
 #endif
@@ -25,6 +25,8 @@
 #include "VectorUtil.h"
 #include "stringutil.h"
 #include "BGException.h"
+#include "GrowingHybridBondGraph.h"
+#include <algorithm>
 //#include "SVD.h"
 
 using namespace BG;
@@ -33,26 +35,41 @@ using namespace std;
 void LookaheadController::writeLog() {
 	(*mLogger)["State"].push_back(mCurrentState);
 	for(unsigned int i = 0; i < mTargets.size(); ++i) {
-		(*mLogger)[string("Target_")+int2str(i)].push_back(mTargets[i]);
+		(*mLogger)[getLogColumn(mTargetColumns,"Target_",i)].push_back(mTargets[i]);
 	}
 }
 
+/*! \brief Return the log column name made of a prefix and an index
+ *  writeLog is called at every time step, the names are built at the first call only.
+ */
+const string& LookaheadController::getLogColumn(vector<string>& ioColumns, const char* inPrefix, unsigned int inIndex) {
+	while(ioColumns.size() <= inIndex) {
+		ioColumns.push_back(string(inPrefix)+int2str(ioColumns.size()));
+	}
+	return ioColumns[inIndex];
+}
+
 void LookaheadController::initialize(HybridBondGraph *inBondGraph, unsigned int inInitialSwState) {
 	
 	mExcludedStates.resize(0);
 	
+	if(mBondGraph != inBondGraph) {
+		mStateMatrices.clear();
+		mCausalityTable.clear();
+	}
 	mBondGraph = inBondGraph;
+	mWorkerBondGraphs.clear();
 	
 	setCurrentState(inInitialSwState);
 	
-	vector<bool> lSwState(this->size(),0);
-	for(unsigned int j = 0; j < this->size(); ++j) {
-		lSwState[j] = (*this)[j]->getState();
-	}
+	vector<bool> lSwState;
+	getSwitchState(lSwState);
 	
 	inBondGraph->setInitialSwitchState(lSwState);
 	
 	inBondGraph->setInitialStateVariable(std::vector<double>(inBondGraph->getStateVariables().size(),0));
+	
+	excludeInfeasibleStates();
 }
 
 void LookaheadController::initialize(HybridBondGraph *inBondGraph, unsigned int inInitialSwState, const vector<double> &inOutputValues) {
@@ -60,20 +77,98 @@ void LookaheadController::initialize(HybridBondGraph *inBondGraph, unsigned int
 	
 	vector<double> lStateValue(inOutputValues.size());
 	
+	if(mBondGraph != inBondGraph) {
+		mStateMatrices.clear();
+		mCausalityTable.clear();
+	}
 	mBondGraph = inBondGraph;
+	mWorkerBondGraphs.clear();
 	
 	setCurrentState(inInitialSwState);
 
-	vector<bool> lSwState(this->size(),0);
-	for(unsigned int j = 0; j < this->size(); ++j) {
-		lSwState[j] = (*this)[j]->getState();
-	}
+	vector<bool> lSwState;
+	getSwitchState(lSwState);
 	
 	inBondGraph->setInitialSwitchState(lSwState);
 	
 	mapTarget2State(inOutputValues,lStateValue);
 	
 	inBondGraph->setInitialStateVariable(lStateValue);
+	
+	excludeInfeasibleStates();
+}
+
+/*! \brief Initialize the controller in the first switch configuration with a valid causality
+ *  The configurations already known to have a conflicting causality are skipped, and the
+ *	configurations tried are recorded in the causality table. Once the table is filled by the
+ *	first simulation case of an individual, the following cases initialize at the first try.
+ *  \param  inBondGraph Bond graph to control.
+ *  \return The initial state, or -1 if every switch configuration has a conflicting causality.
+ */
+int LookaheadController::findInitialState(HybridBondGraph *inBondGraph) {
+	unsigned int lNbConfigurations = 1u << this->size();
+	for(unsigned int lState = 0; lState < lNbConfigurations; ++lState) {
+		if(mBondGraph == inBondGraph && getCausality(lState) == eInfeasibleCausality)
+			continue;
+		try {
+			initialize(inBondGraph,lState);
+		} catch(BG::CausalityException inError) {
+			setCausality(lState,eInfeasibleCausality);
+			continue;
+		}
+		setCausality(lState,eFeasibleCausality);
+		return lState;
+	}
+	return -1;
+}
+
+/*! \brief Initialize the controller in the first switch configuration with a valid causality
+ *  \param  inBondGraph Bond graph to control.
+ *  \param  inOutputValues Initial output values of the bond graph.
+ *  \return The initial state, or -1 if every switch configuration has a conflicting causality.
+ *  \see findInitialState(HybridBondGraph*)
+ */
+int LookaheadController::findInitialState(HybridBondGraph *inBondGraph, const vector<double> &inOutputValues) {
+	unsigned int lNbConfigurations = 1u << this->size();
+	for(unsigned int lState = 0; lState < lNbConfigurations; ++lState) {
+		if(mBondGraph == inBondGraph && getCausality(lState) == eInfeasibleCausality)
+			continue;
+		try {
+			initialize(inBondGraph,lState,inOutputValues);
+		} catch(BG::CausalityException inError) {
+			setCausality(lState,eInfeasibleCausality);
+			continue;
+		}
+		setCausality(lState,eFeasibleCausality);
+		return lState;
+	}
+	return -1;
+}
+
+void LookaheadController::setCausality(unsigned int inState, CausalityFeasibility inFeasibility) {
+	unsigned int lConfiguration = getSwitchConfiguration(inState);
+	if(mCausalityTable.size() != (1u << this->size()))
+		mCausalityTable.assign(1u << this->size(), eUnknownCausality);
+	mCausalityTable[lConfiguration] = inFeasibility;
+}
+
+LookaheadController::CausalityFeasibility LookaheadController::getCausality(unsigned int inState) const {
+	unsigned int lConfiguration = getSwitchConfiguration(inState);
+	if(lConfiguration >= mCausalityTable.size())
+		return eUnknownCausality;
+	return CausalityFeasibility(mCausalityTable[lConfiguration]);
+}
+
+/*! \brief Exclude from the lookahead the states known to have a conflicting causality
+ */
+void LookaheadController::excludeInfeasibleStates() {
+	if(mCausalityTable.empty())
+		return;
+	int lNbState = getNbStates();
+	for(int i = 0; i < lNbState; ++i) {
+		if(getCausality(i) == eInfeasibleCausality)
+			mExcludedStates.push_back(i);
+	}
 }
 
 /*! \brief Set the control target
@@ -94,8 +189,12 @@ void LookaheadController::setTarget(const vector<double>& inTargets) {
  *  \param  outStates Bond graph state variable.
  */
 void LookaheadController::mapTarget2State(const vector<double>& inOutputs, vector<double>& outStates) {
-	PACC::Matrix lC,lD,lD2;
-	mBondGraph->getOutputMatrix(lC,lD,lD2);
+	vector<bool> lSwState;
+	getSwitchState(lSwState);
+	const StateMatrixCache::Entry& lMatrices = mStateMatrices.getMatrices(mBondGraph,lSwState);
+	const PACC::Matrix& lC = lMatrices.mC;
+	const PACC::Matrix& lD = lMatrices.mD;
+	const PACC::Matrix& lD2 = lMatrices.mD2;
 	
 	if(lC.getRows() > 0) {
 		PACC::Vector lu = PACC::Vector(mBondGraph->getInputs());
@@ -129,10 +228,223 @@ void LookaheadController::map2Target(const vector<double>& inState, const vector
 	outTarget = inOutputs;
 }
 
+/*! \brief Return the current state of each switch
+ *  \param  outSwitchState State of the switches, in the controller order.
+ */
+void LookaheadController::getSwitchState(vector<bool>& outSwitchState) const {
+	outSwitchState.resize(this->size());
+	for(unsigned int j = 0; j < this->size(); ++j) {
+		outSwitchState[j] = (*this)[j]->getState();
+	}
+}
+
 int LookaheadController::getNbStates() const {
 	return (int( pow(2.0,int(this->size()) ) ));
 }
 
+/*! \brief Copy the bond graph for each lookahead worker
+ *  The copies keep the type of the bond graph, the virtual simulation then runs the same code
+ *	as on the original.
+ *  \param  inBondGraph Bond graph to copy.
+ *  \param  inNbCopies Number of copies.
+ */
+void LookaheadBondGraphs::assign(HybridBondGraph* inBondGraph, unsigned int inNbCopies) {
+	clear();
+	GrowingHybridBondGraph* lGrowingBondGraph = dynamic_cast<GrowingHybridBondGraph*>(inBondGraph);
+	for(unsigned int i = 0; i < inNbCopies; ++i) {
+		if(lGrowingBondGraph != NULL) {
+			GrowingHybridBondGraph* lCopy = new GrowingHybridBondGraph;
+			*lCopy = *lGrowingBondGraph;
+			mBondGraphs.push_back(lCopy);
+		} else {
+			HybridBondGraph* lCopy = new HybridBondGraph;
+			*lCopy = *inBondGraph;
+			mBondGraphs.push_back(lCopy);
+		}
+	}
+}
+
+void LookaheadBondGraphs::clear() {
+	for(unsigned int i = 0; i < mBondGraphs.size(); ++i) {
+		delete mBondGraphs[i];
+	}
+	mBondGraphs.clear();
+}
+
+/*! \brief Bring a copy to the current state of the bond graph
+ *  Only the state variables and the source values set by the controller are copied. The
+ *	parameters can change at the breakpoints of a simulation case, the copies are then made
+ *	again since clearStateMatrixCache() clears them.
+ *  \param  inIndex Index of the copy.
+ *  \param  inBondGraph Bond graph the copy was made from.
+ */
+void LookaheadBondGraphs::update(unsigned int inIndex, HybridBondGraph* inBondGraph) {
+	HybridBondGraph* lCopy = mBondGraphs[inIndex];
+	vector<Source*> lSources = inBondGraph->getSources();
+	vector<Source*> lCopySources = lCopy->getSources();
+	assert(lSources.size() == lCopySources.size());
+	for(unsigned int i = 0; i < lSources.size(); ++i) {
+		lCopySources[i]->setValue(lSources[i]->getValue());
+	}
+	lCopy->setInitialStateVariable(inBondGraph->getStateVariables());
+}
+
+/*! \brief Lookahead of a group of switch states by a thread pool worker
+ *  The worker simulates the states inFirst, inFirst+inStep, ... on its own copy of the bond graph
+ *	since the virtual simulation modify the bond graph. The results are written at the state
+ *	index, so the selection of the best state does not depend on the execution order.
+ */
+class LookaheadTask : public PACC::Threading::Task {
+public:
+	LookaheadTask(LookaheadController& inController, HybridBondGraph* inBondGraph, unsigned int inFirst, unsigned int inStep, bool inWithInitialParameters,
+				  const vector<double>& inCurrentOutput, const vector<char>& inExcluded,
+				  vector< vector<double> >& outTrajectories, vector<double>& outDistances, vector<char>& outCausality, vector<char>& outFailed) :
+	mController(inController), mBondGraph(inBondGraph), mFirst(inFirst), mStep(inStep), mWithInitialParameters(inWithInitialParameters),
+	mCurrentOutput(inCurrentOutput), mExcluded(inExcluded), 
+	mTrajectories(outTrajectories), mDistances(outDistances), mCausality(outCausality), mFailed(outFailed) { }
+	
+	virtual void main() {
+		for(unsigned int i = mFirst; i < mExcluded.size(); i += mStep) {
+			if(mExcluded[i])
+				continue;
+			try {
+				mCausality[i] = mController.simulateState(mBondGraph, i, mWithInitialParameters, mCurrentOutput, mTrajectories[i], mDistances[i]);
+			} catch(...) {
+				//The state is simulated again by the calling thread, which throws the original exception
+				mFailed[i] = 1;
+			}
+		}
+	}
+	
+protected:
+	LookaheadController& mController;
+	HybridBondGraph* mBondGraph;
+	unsigned int mFirst;
+	unsigned int mStep;
+	bool mWithInitialParameters;
+	const vector<double>& mCurrentOutput;
+	const vector<char>& mExcluded;
+	vector< vector<double> >& mTrajectories;
+	vector<double>& mDistances;
+	vector<char>& mCausality;
+	vector<char>& mFailed;
+};
+
+PACC::Threading::ThreadPool* LookaheadController::mThreadPool = NULL;
+
+/*! \brief Set the number of threads used to simulate the switch states
+ *  The thread pool is shared by every lookahead controller. 
+ *  \param  inNumberThreads Number of threads, 1 or less means a serial lookahead.
+ */
+void LookaheadController::setNumberOfThreads(unsigned int inNumberThreads) {
+	if(mThreadPool != NULL && mThreadPool->size() == inNumberThreads)
+		return;
+	delete mThreadPool;
+	mThreadPool = NULL;
+	if(inNumberThreads > 1)
+		mThreadPool = new PACC::Threading::ThreadPool(inNumberThreads);
+}
+
+//! Return true if the lookahead thread pool is running.
+bool LookaheadController::hasThreads() {
+	return mThreadPool != NULL;
+}
+
+/*! \brief Simulate forward a switch state
+ *  \param  inBondGraph Bond graph used for the virtual simulation.
+ *  \param  inState Switch state to simulate.
+ *  \param  inWithInitialParameters Simulate using the initial parameters.
+ *  \param  inCurrentOutput Current output in the target space.
+ *  \param  outTrajectory Output variation in the target space.
+ *  \param  outDistance Distance between the target and the output at the end of the lookahead.
+ *  \return False if the state has a causality conflict.
+ */
+bool LookaheadController::simulateState(HybridBondGraph* inBondGraph, unsigned int inState, bool inWithInitialParameters, const vector<double>& inCurrentOutput, vector<double>& outTrajectory, double& outDistance) {
+	try{
+		vector<bool> lSwState(this->size());
+		unsigned int k = inState;
+		for(unsigned int j = 0; j < lSwState.size(); ++j) {
+			lSwState[j] = (k >> j) & 1;
+		}
+		
+		//Simulation forward at current state
+		vector<double> lResults;
+		vector<double> lStateResults;
+		
+		bool lPropagated = false;
+#ifdef USE_ZOH
+		if(!inWithInitialParameters) {
+			const StateMatrixCache::Entry* lMatrices = mStateMatrices.find(lSwState);
+			if(lMatrices != NULL)
+				lPropagated = propagateLinear(*lMatrices, inBondGraph, lResults, lStateResults);
+		}
+#endif
+		
+		if(lPropagated) {
+			//The mode was propagated exactly
+		} else if(inWithInitialParameters) {
+			inBondGraph->simulateVirtualFixParameters(lSwState,mSimTime, lResults, lStateResults);
+		}
+		else {
+			inBondGraph->simulateVirtual(lSwState,mSimTime, lResults, lStateResults);
+		}
+		
+		outTrajectory.resize(mTargets.size());
+		
+		std::vector<double> lExpectedOutput;
+		map2Target(lStateResults,lResults,lExpectedOutput);
+		
+		for(unsigned int j = 0; j < mTargets.size(); ++j) {
+			outTrajectory[j] = lExpectedOutput[j] - inCurrentOutput[j];
+		}
+		
+		outDistance = norm(mTargets - lExpectedOutput);
+		
+	} catch(BG::CausalityException inError) {
+		return false;
+	}
+	return true;
+}
+
+#ifdef USE_ZOH
+/*! \brief Propagate the bond graph over the lookahead horizon with the discretized mode
+ *  The inputs are held constant over the horizon, as in the virtual simulation.
+ *  \param  inMatrices State equations of the mode, discretized for the horizon.
+ *  \param  inBondGraph Bond graph giving the current state variables and inputs.
+ *  \param  outResults Output variables at the end of the horizon.
+ *  \param  outStateResults State variables at the end of the horizon.
+ *  \return False if the mode can't be propagated exactly, the virtual simulation should be used.
+ */
+bool LookaheadController::propagateLinear(const StateMatrixCache::Entry& inMatrices, HybridBondGraph* inBondGraph, vector<double>& outResults, vector<double>& outStateResults) const {
+	if(!inMatrices.mPropagator.isDiscretized(mSimTime) || inBondGraph->hasDeferentialCausality())
+		return false;
+	
+	const vector<double>& lInputs = inBondGraph->getInputs();
+	if(!inMatrices.mPropagator.step(inBondGraph->getStateVariables(), lInputs, outStateResults))
+		return false;
+	
+	const PACC::Matrix& lC = inMatrices.mC;
+	const PACC::Matrix& lD = inMatrices.mD;
+	if(lC.getRows() == 0 || lC.getCols() != outStateResults.size() || (lD.getRows() > 0 && lD.getCols() != lInputs.size()))
+		return false;
+	
+	outResults.assign(lC.getRows(),0);
+	for(unsigned int i = 0; i < lC.getRows(); ++i) {
+		double lValue = 0;
+		for(unsigned int j = 0; j < lC.getCols(); ++j) {
+			lValue += lC(i,j)*outStateResults[j];
+		}
+		if(lD.getRows() > 0) {
+			for(unsigned int j = 0; j < lD.getCols(); ++j) {
+				lValue += lD(i,j)*lInputs[j];
+			}
+		}
+		outResults[i] = lValue;
+	}
+	return true;
+}
+#endif
+
 //Version working the output variables
 void LookaheadController::updateSwitchState(double inTime, const vector<double>& inInputs, bool inWithInitialParameters) {
 	const vector<double>& lStateVariables = mBondGraph->getStateVariables();
@@ -159,47 +471,72 @@ void LookaheadController::updateSwitchState(double inTime, const vector<double>&
 	
 	int lNbState = getNbStates();
 	
+#ifdef USE_ZOH
+	//Keep the discretized equations of the current mode for the next lookahead
+	if(!mBondGraph->hasDeferentialCausality()) {
+		vector<bool> lSwState;
+		getSwitchState(lSwState);
+		try {
+			StateMatrixCache::Entry& lMatrices = mStateMatrices.getMatrices(mBondGraph,lSwState);
+			if(!lMatrices.mPropagator.isDiscretized(mSimTime) && mSimTime > 0)
+				lMatrices.mPropagator.discretize(lMatrices.mA,lMatrices.mB,mSimTime);
+		} catch(BG::CausalityException inError) {
+			//The mode will be simulated
+		}
+	}
+#endif
+	
 	//Get the direction of each state
 	vector<double> lDistance2Target(lNbState);
 	vector< vector<double> > lTrajetories(lNbState);
-	for(unsigned int i = 0; i < lNbState; ++i) {
-		if(find(mExcludedStates.begin(),mExcludedStates.end(),i) != mExcludedStates.end())
-			continue;
-		
-		try{
-			vector<bool> lSwState(this->size());
-			unsigned int k = i;
-			for(unsigned int j = 0; j < lSwState.size(); ++j) {
-				lSwState[j] = (k >> j) & 1;
-			}
+	vector<char> lExcluded(lNbState,0);
+	for(unsigned int i = 0; i < mExcludedStates.size(); ++i) {
+		if(mExcludedStates[i] >= 0 && mExcludedStates[i] < lNbState)
+			lExcluded[mExcludedStates[i]] = 1;
+	}
 	
-			//Simulation forward at current state
-			vector<double> lResults;
-			vector<double> lStateResults;
-			
-			
-			if(inWithInitialParameters) {
-				mBondGraph->simulateVirtualFixParameters(lSwState,mSimTime, lResults, lStateResults);
-			}
-			else {
-				mBondGraph->simulateVirtual(lSwState,mSimTime, lResults, lStateResults);
-			}
-			
-			lTrajetories[i].resize(mTargets.size());
-
-			std::vector<double> lExpectedOutput;
-			map2Target(lStateResults,lResults,lExpectedOutput);
+	if(mThreadPool != NULL && lNbState > 1) {
+		//Simulate the states concurrently, each worker on its own copy of the bond graph
+		vector<char> lCausality(lNbState,1);
+		vector<char> lFailed(lNbState,0);
+		unsigned int lNbTasks = std::min((unsigned int)mThreadPool->size(), (unsigned int)lNbState);
+		if(mWorkerBondGraphs.size() != lNbTasks)
+			mWorkerBondGraphs.assign(mBondGraph,lNbTasks);
+		vector<LookaheadTask*> lTasks(lNbTasks);
+		for(unsigned int t = 0; t < lNbTasks; ++t) {
+			mWorkerBondGraphs.update(t,mBondGraph);
+			lTasks[t] = new LookaheadTask(*this, mWorkerBondGraphs[t], t, lNbTasks, inWithInitialParameters, lCurrentOutput, lExcluded,
+										  lTrajetories, lDistance2Target, lCausality, lFailed);
+		}
+		for(unsigned int t = 0; t < lNbTasks; ++t) {
+			mThreadPool->push(*lTasks[t]);
+		}
+		for(unsigned int t = 0; t < lNbTasks; ++t) {
+			lTasks[t]->wait();
+			delete lTasks[t];
+		}
 		
-			for(unsigned int j = 0; j < mTargets.size(); ++j) {
-				lTrajetories[i][j] = lExpectedOutput[j] - lCurrentOutput[j];
+		//Reduce in the state order, as the serial lookahead
+		for(unsigned int i = 0; i < lNbState; ++i) {
+			if(lExcluded[i])
+				continue;
+			if(lFailed[i])
+				lCausality[i] = simulateState(mBondGraph, i, inWithInitialParameters, lCurrentOutput, lTrajetories[i], lDistance2Target[i]);
+			if(!lCausality[i]) {
+				mExcludedStates.push_back(i);
+				setCausality(i,eInfeasibleCausality);
 			}
+		}
+	} else {
+		for(unsigned int i = 0; i < lNbState; ++i) {
+			if(lExcluded[i])
+				continue;
 			
-			lDistance2Target[i] = norm(mTargets - lExpectedOutput);
-			
-		} catch(BG::CausalityException inError) {
-			mExcludedStates.push_back(i);
-			continue;
-		} 
+			if(!simulateState(mBondGraph, i, inWithInitialParameters, lCurrentOutput, lTrajetories[i], lDistance2Target[i])) {
+				mExcludedStates.push_back(i);
+				setCausality(i,eInfeasibleCausality);
+			}
+		}
 	}
 	
 	if(mExcludedStates.size() == lNbState) //All state has differential causality
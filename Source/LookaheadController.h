@@ -26,6 +26,30 @@
 #include <assert.h>
 #include "HybridBondGraph.h"
 #include "SwitchController.h"
+#include "StateMatrixCache.h"
+#include <PACC/Threading.hpp>
+
+/*! \brief Copies of the controlled bond graph simulated by the lookahead workers
+ *  The copies are made once per simulation case, and only the state variables and the source
+ *	values are updated before each lookahead. A copied controller starts without copies.
+ */
+class LookaheadBondGraphs {
+public:
+	LookaheadBondGraphs() {}
+	LookaheadBondGraphs(const LookaheadBondGraphs&) {}
+	~LookaheadBondGraphs() { clear(); }
+	LookaheadBondGraphs& operator=(const LookaheadBondGraphs&) { clear(); return *this; }
+	
+	void assign(BG::HybridBondGraph* inBondGraph, unsigned int inNbCopies);
+	void clear();
+	void update(unsigned int inIndex, BG::HybridBondGraph* inBondGraph);
+	
+	unsigned int size() const { return mBondGraphs.size(); }
+	BG::HybridBondGraph* operator[](unsigned int inIndex) const { return mBondGraphs[inIndex]; }
+	
+private:
+	std::vector<BG::HybridBondGraph*> mBondGraphs;
+};
 
 class LookaheadController : public BG::SwitchController {
 protected:
@@ -46,8 +70,34 @@ protected:
 	
 	std::vector<int> mExcludedStates;
 	
+	StateMatrixCache mStateMatrices;	//!< State equations of the visited switch configurations, used by the lookahead only
+	
+	//! Causality of a switch configuration
+	enum CausalityFeasibility {eUnknownCausality=0, eFeasibleCausality, eInfeasibleCausality};
+	std::vector<char> mCausalityTable;	//!< Causality feasibility of each switch configuration, indexed by the switches bits
+	
+	unsigned int getSwitchConfiguration(unsigned int inState) const { return inState & ((1u << this->size()) - 1); }
+	void setCausality(unsigned int inState, CausalityFeasibility inFeasibility);
+	CausalityFeasibility getCausality(unsigned int inState) const;
+	void excludeInfeasibleStates();
+	
+	void getSwitchState(std::vector<bool>& outSwitchState) const;
+#ifdef USE_ZOH
+	bool propagateLinear(const StateMatrixCache::Entry& inMatrices, BG::HybridBondGraph* inBondGraph, std::vector<double>& outResults, std::vector<double>& outStateResults) const;
+#endif
+	bool simulateState(BG::HybridBondGraph* inBondGraph, unsigned int inState, bool inWithInitialParameters, const std::vector<double>& inCurrentOutput, std::vector<double>& outTrajectory, double& outDistance);
+	
+	const std::string& getLogColumn(std::vector<std::string>& ioColumns, const char* inPrefix, unsigned int inIndex);
+	std::vector<std::string> mTargetColumns;	//!< Names of the logged targets, built once
+	std::vector<std::string> mOutputColumns;	//!< Names of the logged outputs, built once
+	
+	static PACC::Threading::ThreadPool* mThreadPool;	//!< Thread pool shared by the controllers for the lookahead
+	LookaheadBondGraphs mWorkerBondGraphs;	//!< Bond graph of each lookahead worker, cleared by initialize() and clearStateMatrixCache()
+	
+	friend class LookaheadTask;
+	
 public:	
-	LookaheadController(double inSimTime) : mSimTime(inSimTime) {}
+	LookaheadController(double inSimTime) : mSimTime(inSimTime), mBondGraph(0) {}
 	
 	virtual void initialize() {}
 	
@@ -58,7 +108,19 @@ public:
 	
 	virtual void setTarget(const std::vector<double>& inTargets);
 	
+	int findInitialState(BG::HybridBondGraph *inBondGraph);
+	int findInitialState(BG::HybridBondGraph *inBondGraph, const std::vector<double> &inOutputValues);
+	//! Forget the causality of the switch configurations, should be called when the causality rules change.
+	void clearCausalityTable() { mCausalityTable.clear(); }
+	
+	//! Clear the cached state equations and the worker copies, should be called when the bond graph parameters change.
+	void clearStateMatrixCache() { mStateMatrices.clear(); mWorkerBondGraphs.clear(); }
+	const StateMatrixCache& getStateMatrixCache() const { return mStateMatrices; }
+	
 	void createBondGraph(BG::HybridBondGraph &ioBondGraph) {}
+	
+	static void setNumberOfThreads(unsigned int inNumberThreads);
+	static bool hasThreads();
 };
 
 #endif
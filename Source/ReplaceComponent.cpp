@@ -76,7 +76,6 @@ void ReplaceComponent::replace(Beagle::GP::Datum& inComponent, BG::Passive::Pass
 	BGContext& lContext = castObjectT<BGContext&>(ioContext);
 	ComponentPtr& lInComponent = castObjectT<ComponentPtr&>(inComponent);
 	GrowingHybridBondGraph::Handle lGrowingBondGraph = castHandleT<GrowingHybridBondGraph>(lContext.getBondGraph());
-	lGrowingBondGraph->setCausalityInvalid();
 	
 	Beagle::Double lValue;
 	getArgument(0,lValue,ioContext);
@@ -85,7 +84,11 @@ void ReplaceComponent::replace(Beagle::GP::Datum& inComponent, BG::Passive::Pass
 	lValue = fabs(lValue)*inFactor;
 	
 	//Create the new component
-	BG::Passive* lPassive = new BG::Passive(inNewType,lValue);
+	BG::Passive* lPassive = lContext.getComponentArena().create<BG::Passive>(inNewType,lValue);
+	
+	//The new component takes the ports of the old one with their causality
+	if(!lGrowingBondGraph->keepsCausality(lInComponent.getValue(),lPassive))
+		lGrowingBondGraph->setCausalityInvalid();
 	
 	//Replace component
 	lGrowingBondGraph->replaceComponent(lInComponent.getValue(),(BG::Component*&)lPassive);
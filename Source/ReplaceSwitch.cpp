@@ -50,7 +50,7 @@ void ReplaceSwitch::execute(Beagle::GP::Datum& inComponent, Beagle::GP::Context&
 	lGrowingBondGraph->setCausalityInvalid();
 	
 	//Create the new component
-	BG::Switch *lSw = new BG::Switch;
+	BG::Switch *lSw = lContext.getComponentArena().create<BG::Switch>();
 	
 	//Replace component
 	lGrowingBondGraph->replaceComponent(lInComponent.getValue(),(BG::Component*&)lSw);
@@ -24,6 +24,7 @@
 #include <beagle/GP/Context.hpp>
 #include <beagle/RunTimeException.hpp>
 #include "ArgType.h"
+#include "TreeSTag.h"
 
 using namespace Beagle;
 
@@ -55,34 +56,87 @@ void SelectiveConstrainedSelectionOp::initialize(Beagle::System& ioSystem) {
 	}
 }
 
+/*! \brief Return the types of a primitive
+ *  The return and argument types are asked to the primitive the first time it is met. An
+ *	argument type which depends on the parent of the node cannot be found with an empty call
+ *	stack, it is marked as context dependent and asked again for each node.
+ *  \param  inPrimitiveID Identifier of the primitive name, see TreeSTag::getPrimitiveID.
+ */
+const SelectiveConstrainedSelectionOp::PrimitiveTypes& SelectiveConstrainedSelectionOp::getPrimitiveTypes(unsigned int inPrimitiveID, GP::Primitive& inPrimitive, GP::Context& ioContext) const {
+	if(inPrimitiveID >= mPrimitiveTypes.size())
+		mPrimitiveTypes.resize(inPrimitiveID+1);
+	PrimitiveTypes& lTypes = mPrimitiveTypes[inPrimitiveID];
+	if(lTypes.mInitialized)
+		return lTypes;
+	
+	lTypes.mReturnTypes = inPrimitive.getReturnTypes(ioContext);
+	lTypes.mReturnsParameter = find(lTypes.mReturnTypes.begin(), lTypes.mReturnTypes.end(), ArgEph) != lTypes.mReturnTypes.end();
+	
+	//Save the call stack
+	std::vector<unsigned int> lCallStack;
+	for(unsigned int i = 0; i < ioContext.getCallStackSize(); ++i)
+		lCallStack.push_back(ioContext.getCallStackElement(i));
+	ioContext.emptyCallStack();
+	
+	lTypes.mParameterArgs.resize(inPrimitive.getNumberArguments(), PrimitiveTypes::eNotParameter);
+	for(unsigned int j = 0; j < lTypes.mParameterArgs.size(); ++j) {
+		try {
+			std::vector<const std::type_info*> lArgType = inPrimitive.getArgTypes(j,ioContext);
+			if( find(lArgType.begin(), lArgType.end(), ArgEph) != lArgType.end() )
+				lTypes.mParameterArgs[j] = PrimitiveTypes::eParameter;
+		}
+		catch(Beagle::RunTimeException inError) {
+			lTypes.mParameterArgs[j] = PrimitiveTypes::eContextDependent;
+		}
+	}
+	
+	for(unsigned int i = 0; i < lCallStack.size(); ++i)
+		ioContext.pushCallStack(lCallStack[i]);
+	
+	lTypes.mInitialized = true;
+	return lTypes;
+}
+
+/*! \brief Check if the return types of a primitive match the desired ones
+ */
+bool SelectiveConstrainedSelectionOp::isCompatibleTyping(const std::vector<const std::type_info*>& inNodeReturnTypes, const PrimitiveTypes& inTypes, bool inIsExclusiveSet) const {
+	const std::vector<const std::type_info*>& lNodeTypes = inTypes.mReturnTypes;
+	bool lCompatibleTyping = ((inNodeReturnTypes[0]==NULL) || (lNodeTypes[0]==NULL) );
+	for(unsigned int k = 0; k < lNodeTypes.size() && !lCompatibleTyping; ++k) {
+		if(inIsExclusiveSet)
+			lCompatibleTyping = std::find(inNodeReturnTypes.begin(),inNodeReturnTypes.end(),lNodeTypes[k]) == inNodeReturnTypes.end();
+		else
+			lCompatibleTyping = std::find(inNodeReturnTypes.begin(),inNodeReturnTypes.end(),lNodeTypes[k]) != inNodeReturnTypes.end();
+	}
+	return lCompatibleTyping;
+}
+
 void SelectiveConstrainedSelectionOp::findParameterSubTreeRoots(Beagle::GP::Individual& inIndiv, Beagle::GP::Context& ioContext, std::vector< std::pair<unsigned int,unsigned int> > &outNodes) const {
 	Beagle_StackTraceBeginM();
 	
 	//Go throught all nodes
 	for(unsigned int t = 0; t < inIndiv.size(); ++t) {
 		GP::Tree& lTree = *inIndiv[t];
+		const std::vector<TreeSTag::FlatNode>& lNodes = castObjectT<const TreeSTag&>(lTree).getFlatEncoding();
 		for(unsigned int i = 0; i < lTree.size(); ++i) {
-			std::vector<const std::type_info*> lNodeTypes = lTree[i].mPrimitive->getReturnTypes(ioContext);
+			const PrimitiveTypes& lTypes = getPrimitiveTypes(lNodes[i].mPrimitiveID, *lTree[i].mPrimitive, ioContext);
 			//If the node is not returning a double, then one of it arguments might be the root of the parameter tree
-			if( find(lNodeTypes.begin(), lNodeTypes.end(), ArgEph) == lNodeTypes.end() ) {
-				for(unsigned int j = 0; j < lTree[i].mPrimitive->getNumberArguments(); ++j) {
-					try{
-						std::vector<const std::type_info*> lArgType = lTree[i].mPrimitive->getArgTypes(j,ioContext);
-						if( find(lArgType.begin(), lArgType.end(), ArgEph) != lArgType.end() ) {
-							//The argument is the root a parameter tree, add to the return nodes
-							
-							//Get argument index
-							unsigned int lArgIndex = i+1;
-							for(unsigned int k = 0; k < j; ++k) lArgIndex += lTree[lArgIndex].mSubTreeSize;
-							
-							//Add to the return node list
-							outNodes.push_back( make_pair(t,lArgIndex) );
-							
-							//Could break here if it's assumed that primitive has only one double arguments.
+			if( !lTypes.mReturnsParameter ) {
+				unsigned int lArgIndex = i+1;
+				for(unsigned int j = 0; j < lTypes.mParameterArgs.size(); ++j) {
+					bool lIsParameterRoot = (lTypes.mParameterArgs[j] == PrimitiveTypes::eParameter);
+					if(lTypes.mParameterArgs[j] == PrimitiveTypes::eContextDependent) {
+						try{
+							std::vector<const std::type_info*> lArgType = lTree[i].mPrimitive->getArgTypes(j,ioContext);
+							lIsParameterRoot = find(lArgType.begin(), lArgType.end(), ArgEph) != lArgType.end();
 						}
+						catch(Beagle::RunTimeException inError) {} //Catch the exeption when trying to access parent time with empty call stack
 					}
-					catch(Beagle::RunTimeException inError) {} //Catch the exeption when trying to access parent time with empty call stack
-					//Could do a better job handling the callstack
+					
+					//The argument is the root a parameter tree, add to the return nodes
+					if(lIsParameterRoot)
+						outNodes.push_back( make_pair(t,lArgIndex) );
+					lArgIndex += lNodes[lArgIndex].mSubTreeSize;
 				}
 			}		
 		}
@@ -212,13 +266,9 @@ unsigned int SelectiveConstrainedSelectionOp::buildRouletteWithTypes(
 	const unsigned int lNbArgs = inTree[inActualIndex].mPrimitive->getNumberArguments();
 	const unsigned int lSubTreeSize = inTree[inActualIndex].mSubTreeSize;
 	const bool lGoodArity = ((inTree.size()==1) || ((lNbArgs==0) != inSelectABranch));
+	const PrimitiveTypes& lTypes = getPrimitiveTypes(TreeSTag::getPrimitiveID(inTree[inActualIndex].mPrimitive->getName()), *inTree[inActualIndex].mPrimitive, ioContext);
 	ioContext.pushCallStack(inActualIndex);
-	std::vector<const std::type_info*> lNodeTypes = inTree[inActualIndex].mPrimitive->getReturnTypes(ioContext);
-	
-	bool lCompatibleTyping = ((inNodeReturnTypes[0]==NULL) || (lNodeTypes[0]==NULL) );
-	for(unsigned int k = 0; k < lNodeTypes.size() && !lCompatibleTyping; ++k) {
-		lCompatibleTyping = std::find(inNodeReturnTypes.begin(),inNodeReturnTypes.end(),lNodeTypes[k]) != inNodeReturnTypes.end();
-	}
+	const bool lCompatibleTyping = isCompatibleTyping(inNodeReturnTypes, lTypes, false);
 	
 	unsigned int lChildIndex = inActualIndex+1;
 	unsigned int lMaxDepthDown = 0;
@@ -311,16 +361,8 @@ void SelectiveConstrainedSelectionOp::buildRoulette(
 		if(!lGoodArity) continue;
 		
 		//Get compatibility of types
-		std::vector<const std::type_info*> lNodeTypes = lTree[lChoosenNode].mPrimitive->getReturnTypes(ioContext);
-		
-		bool lCompatibleTyping = ((inNodeReturnTypes[0]==NULL) || (lNodeTypes[0]==NULL) );
-		for(unsigned int k = 0; k < lNodeTypes.size() && !lCompatibleTyping; ++k) {
-			if(inIsExclusiveSet)
-				lCompatibleTyping = std::find(inNodeReturnTypes.begin(),inNodeReturnTypes.end(),lNodeTypes[k]) == inNodeReturnTypes.end();
-			else
-				lCompatibleTyping = std::find(inNodeReturnTypes.begin(),inNodeReturnTypes.end(),lNodeTypes[k]) != inNodeReturnTypes.end();
-			
-		}
+		const PrimitiveTypes& lTypes = getPrimitiveTypes(TreeSTag::getPrimitiveID(lTree[lChoosenNode].mPrimitive->getName()), *lTree[lChoosenNode].mPrimitive, ioContext);
+		const bool lCompatibleTyping = isCompatibleTyping(inNodeReturnTypes, lTypes, inIsExclusiveSet);
 		
 		//if all condition are good, add to the roulette
 		if(lGoodArity && lCompatibleTyping) {
@@ -390,15 +432,8 @@ void SelectiveConstrainedSelectionOp::buildRoulette(Beagle::RouletteT< std::pair
 		GP::Tree& lTree = *inIndiv[lChoosenTree];
 		
 		//Get compatibility of types
-		std::vector<const std::type_info*> lNodeTypes = lTree[lChoosenNode].mPrimitive->getReturnTypes(ioContext);
-		
-		bool lCompatibleTyping = ((inNodeReturnTypes[0]==NULL) || (lNodeTypes[0]==NULL) );
-		for(unsigned int k = 0; k < lNodeTypes.size() && !lCompatibleTyping; ++k) {
-			if(inIsExclusiveSet)
-				lCompatibleTyping = std::find(inNodeReturnTypes.begin(),inNodeReturnTypes.end(),lNodeTypes[k]) == inNodeReturnTypes.end();
-			else
-				lCompatibleTyping = std::find(inNodeReturnTypes.begin(),inNodeReturnTypes.end(),lNodeTypes[k]) != inNodeReturnTypes.end();
-		}
+		const PrimitiveTypes& lTypes = getPrimitiveTypes(TreeSTag::getPrimitiveID(lTree[lChoosenNode].mPrimitive->getName()), *lTree[lChoosenNode].mPrimitive, ioContext);
+		const bool lCompatibleTyping = isCompatibleTyping(inNodeReturnTypes, lTypes, inIsExclusiveSet);
 		
 		//if all condition are good, add to the roulette
 		if(lCompatibleTyping) {
@@ -435,19 +470,11 @@ bool SelectiveConstrainedSelectionOp::hasOutputTypes(std::vector<const std::type
 	//Find at least one node with inNodeReturnTypes
 	for(unsigned int i=0; i<inIndiv.size(); i++) {
 		GP::Tree& lTree = *inIndiv[i];
+		const std::vector<TreeSTag::FlatNode>& lNodes = castObjectT<const TreeSTag&>(lTree).getFlatEncoding();
 		for(unsigned int j=0; j<lTree.size(); j++) {
 			//Get compatibility of types
-			std::vector<const std::type_info*> lNodeTypes = lTree[j].mPrimitive->getReturnTypes(ioContext);
-			
-			bool lCompatibleTyping = ((inNodeReturnTypes[0]==NULL) || (lNodeTypes[0]==NULL) );
-			for(unsigned int k = 0; k < lNodeTypes.size() && !lCompatibleTyping; ++k) {
-				if(inIsExclusiveSet)
-					lCompatibleTyping = std::find(inNodeReturnTypes.begin(),inNodeReturnTypes.end(),lNodeTypes[k]) == inNodeReturnTypes.end();
-				else
-					lCompatibleTyping = std::find(inNodeReturnTypes.begin(),inNodeReturnTypes.end(),lNodeTypes[k]) != inNodeReturnTypes.end();
-			}
-			
-			if(lCompatibleTyping) {
+			const PrimitiveTypes& lTypes = getPrimitiveTypes(lNodes[j].mPrimitiveID, *lTree[j].mPrimitive, ioContext);
+			if(isCompatibleTyping(inNodeReturnTypes, lTypes, inIsExclusiveSet)) {
 				return true;
 			}
 		}
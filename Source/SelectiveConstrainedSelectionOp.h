@@ -32,11 +32,28 @@
 #include "beagle/UInt.hpp"
 #include "beagle/Float.hpp"
 #include "beagle/Bool.hpp"
+#include <vector>
 
 class SelectiveConstrainedSelectionOp {
 protected:
+	//! Types of a primitive, found once for all the nodes using it.
+	struct PrimitiveTypes {
+		enum ArgKind {eNotParameter, eParameter, eContextDependent};
+		
+		PrimitiveTypes() : mInitialized(false), mReturnsParameter(false) {}
+		
+		bool mInitialized;
+		std::vector<const std::type_info*> mReturnTypes;
+		bool mReturnsParameter;				//!< The primitive returns an ephemeral constant
+		std::vector<char> mParameterArgs;	//!< For each argument, if it is the root of a parameter tree
+	};
+	
 	Beagle::Float::Handle mMutParameterPb;
 	Beagle::Float::Handle mCxParameterPb;
+	mutable std::vector<PrimitiveTypes> mPrimitiveTypes;	//!< Indexed by the primitive identifier of TreeSTag
+	
+	const PrimitiveTypes& getPrimitiveTypes(unsigned int inPrimitiveID, Beagle::GP::Primitive& inPrimitive, Beagle::GP::Context& ioContext) const;
+	bool isCompatibleTyping(const std::vector<const std::type_info*>& inNodeReturnTypes, const PrimitiveTypes& inTypes, bool inIsExclusiveSet) const;
 	
 	void findParameterSubTreeRoots(Beagle::GP::Individual& inIndiv, Beagle::GP::Context& ioContext, std::vector< std::pair<unsigned int,unsigned int> > &outNodes) const;
 	
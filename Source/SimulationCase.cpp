@@ -22,24 +22,180 @@
 
 #include "SimulationCase.h"
 #include <sstream>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <cstring>
 #include <Util.hpp>
+#include <PACC/Threading.hpp>
 #include "VectorUtil.h"
 
+static const char gCaseFileTag[8] = {'H','B','G','C','A','S','E','1'};
+
 void SimulationCase::write(ostream &inStream) const {
 	for(unsigned int i = 0; i < mTimes.size(); ++i) {
 		inStream << mTimes[i];
 		
-		if(mParameters.size() > 0 && !mParameters[i].empty()) {
-			inStream << "[" << mParameters[i] << "]";
+		if(getNbParameters(i) > 0) {
+			inStream << "[" << getParameters(i) << "]";
 		}
-		inStream << "(" << mTargets[i] << ")";
+		inStream << "(" << getTargets(i) << ")";
 		
 		if(i != mTimes.size()-1)
 			inStream << ",";
 	}
 }
 
+/*! \brief Check that the case can be simulated
+ *  The case must have at least one breakpoint and its times must be increasing.
+ */
+void SimulationCase::validate() const {
+	if(mTimes.empty())
+		throw std::runtime_error("SimulationCase : empty simulation case");
+	for(unsigned int i = 1; i < mTimes.size(); ++i) {
+		if(mTimes[i] <= mTimes[i-1]) {
+			std::ostringstream lMessage;
+			lMessage << "SimulationCase : the breakpoint times must be increasing, " << mTimes[i] << " follows " << mTimes[i-1];
+			throw std::runtime_error(lMessage.str());
+		}
+	}
+}
+
+/*! \brief Write the case in binary
+ *  The values are written in the byte order of the machine.
+ */
+void SimulationCase::writeBinary(ostream &outStream) const {
+	unsigned int lSizes[3];
+	lSizes[0] = mTimes.size();
+	lSizes[1] = mTargetValues.size();
+	lSizes[2] = mParameterValues.size();
+	outStream.write((const char*)lSizes, sizeof(lSizes));
+	if(!mTimes.empty())
+		outStream.write((const char*)&mTimes[0], mTimes.size()*sizeof(double));
+	outStream.write((const char*)&mTargetOffsets[0], mTargetOffsets.size()*sizeof(unsigned int));
+	if(!mTargetValues.empty())
+		outStream.write((const char*)&mTargetValues[0], mTargetValues.size()*sizeof(double));
+	outStream.write((const char*)&mParameterOffsets[0], mParameterOffsets.size()*sizeof(unsigned int));
+	if(!mParameterValues.empty())
+		outStream.write((const char*)&mParameterValues[0], mParameterValues.size()*sizeof(double));
+}
+
+void SimulationCase::readBinary(istream &inStream) {
+	unsigned int lSizes[3];
+	if(!inStream.read((char*)lSizes, sizeof(lSizes)))
+		throw std::runtime_error("SimulationCase : truncated simulation case file");
+	mTimes.resize(lSizes[0]);
+	mTargetOffsets.resize(lSizes[0]+1);
+	mTargetValues.resize(lSizes[1]);
+	mParameterOffsets.resize(lSizes[0]+1);
+	mParameterValues.resize(lSizes[2]);
+	
+	if(!mTimes.empty())
+		inStream.read((char*)&mTimes[0], mTimes.size()*sizeof(double));
+	inStream.read((char*)&mTargetOffsets[0], mTargetOffsets.size()*sizeof(unsigned int));
+	if(!mTargetValues.empty())
+		inStream.read((char*)&mTargetValues[0], mTargetValues.size()*sizeof(double));
+	inStream.read((char*)&mParameterOffsets[0], mParameterOffsets.size()*sizeof(unsigned int));
+	if(!mParameterValues.empty())
+		inStream.read((char*)&mParameterValues[0], mParameterValues.size()*sizeof(double));
+	if(!inStream)
+		throw std::runtime_error("SimulationCase : truncated simulation case file");
+	
+	for(unsigned int i = 0; i < mTimes.size(); ++i) {
+		if(mTargetOffsets[i] > mTargetOffsets[i+1] || mParameterOffsets[i] > mParameterOffsets[i+1])
+			throw std::runtime_error("SimulationCase : corrupted simulation case file");
+	}
+	if(mTargetOffsets.front() != 0 || mTargetOffsets.back() != mTargetValues.size() ||
+	   mParameterOffsets.front() != 0 || mParameterOffsets.back() != mParameterValues.size())
+		throw std::runtime_error("SimulationCase : corrupted simulation case file");
+}
+
+/*! \brief Read cases written by writeSimulationCases
+ *  \param  inStream Binary stream.
+ *  \param  outCases Cases read.
+ */
+void readSimulationCases(istream &inStream, vector<SimulationCase> &outCases) {
+	outCases.clear();
+	char lTag[sizeof(gCaseFileTag)];
+	unsigned int lNbCases = 0;
+	inStream.read(lTag, sizeof(lTag));
+	inStream.read((char*)&lNbCases, sizeof(lNbCases));
+	if(!inStream || memcmp(lTag, gCaseFileTag, sizeof(lTag)) != 0)
+		throw std::runtime_error("SimulationCase : not a simulation case stream");
+	
+	outCases.resize(lNbCases);
+	for(unsigned int i = 0; i < lNbCases; ++i) {
+		outCases[i].readBinary(inStream);
+	}
+}
+
+/*! \brief Write the cases in binary, with a tag and the number of cases
+ *  \param  outStream Binary stream.
+ *  \param  inCases Cases to write.
+ */
+void writeSimulationCases(ostream &outStream, const vector<SimulationCase> &inCases) {
+	unsigned int lNbCases = inCases.size();
+	outStream.write(gCaseFileTag, sizeof(gCaseFileTag));
+	outStream.write((const char*)&lNbCases, sizeof(lNbCases));
+	for(unsigned int i = 0; i < lNbCases; ++i) {
+		inCases[i].writeBinary(outStream);
+	}
+}
+
+void readSimulationCaseFile(const string& inFilename, vector<SimulationCase> &outCases) {
+	outCases.clear();
+	ifstream lStream(inFilename.c_str(), ios::in | ios::binary);
+	if(!lStream)
+		throw std::runtime_error(string("Unable to open the simulation case file ")+inFilename);
+	try {
+		readSimulationCases(lStream, outCases);
+	} catch(std::runtime_error&) {
+		throw std::runtime_error(inFilename+string(" is not a valid simulation case file"));
+	}
+}
+
+void writeSimulationCaseFile(const string& inFilename, const vector<SimulationCase> &inCases) {
+	ofstream lStream(inFilename.c_str(), ios::out | ios::binary);
+	if(!lStream)
+		throw std::runtime_error(string("Unable to write the simulation case file ")+inFilename);
+	writeSimulationCases(lStream, inCases);
+}
+
+static void parseSimulationCase(const string& inString, vector<SimulationCase> &outCases);
+
+/*! \brief Return the simulation cases described by a string
+ *  The string is either a list of cases in the text format, or the name of a binary case file
+ *	preceded by '@'. The cases are parsed and validated once, the following calls with the same
+ *	string copy the already parsed cases.
+ */
 void readSimulationCase(string inString, vector<SimulationCase> &outCases) {
+	static std::map< string, vector<SimulationCase> > lParsedCases;
+	static PACC::Threading::Mutex lMutex;
+	
+	lMutex.lock();
+	std::map< string, vector<SimulationCase> >::const_iterator lIter = lParsedCases.find(inString);
+	if(lIter != lParsedCases.end()) {
+		outCases = lIter->second;
+		lMutex.unlock();
+		return;
+	}
+	lMutex.unlock();
+	
+	if(!inString.empty() && inString[0] == '@')
+		readSimulationCaseFile(inString.substr(1), outCases);
+	else
+		parseSimulationCase(inString, outCases);
+	
+	for(unsigned int i = 0; i < outCases.size(); ++i) {
+		outCases[i].validate();
+	}
+	
+	lMutex.lock();
+	lParsedCases[inString] = outCases;
+	lMutex.unlock();
+}
+
+static void parseSimulationCase(const string& inString, vector<SimulationCase> &outCases) {
 	//Parse the targets of the form T0(t1,t2,...),T1(t1,t2,...),T2(t1,t2,...); T0(t1,t2,...), ...
 	// or
 	//Parse the targets of the form T0[p1,p2,..](t1,t2,...),T1[p1,p2,..](t1,t2,...),T2[p1,p2,..](t1,t2,...); T0(t1,t2,...)(p1,p2,..), ...
@@ -29,40 +29,69 @@
 
 using namespace std;
 
+/*! \brief Breakpoints of a simulation case
+ *  The times, targets and parameters of all the breakpoints are stored in flat arrays, the
+ *	targets and parameters of breakpoint i are in [offset[i], offset[i+1]).
+ */
 class SimulationCase {
 public:
-	SimulationCase() {}
+	SimulationCase() { clear(); }
 	~SimulationCase() {}
 	
-	void clear() { mTimes.clear(); mTargets.clear(); }
+	void clear() {
+		mTimes.clear();
+		mTargetValues.clear(); mTargetOffsets.assign(1,0);
+		mParameterValues.clear(); mParameterOffsets.assign(1,0);
+	}
 
 	void addTargets(double inTime, const vector<double> &inTargets, const vector<double> &inParameters) {
-		mTargets.push_back(inTargets);
-		mParameters.push_back(inParameters);
 		mTimes.push_back(inTime); 
+		mTargetValues.insert(mTargetValues.end(), inTargets.begin(), inTargets.end());
+		mTargetOffsets.push_back(mTargetValues.size());
+		mParameterValues.insert(mParameterValues.end(), inParameters.begin(), inParameters.end());
+		mParameterOffsets.push_back(mParameterValues.size());
 	}
 	
 	void addTargets(double inTime, const vector<double> &inTargets) {
-		mTargets.push_back(inTargets);
-		mTimes.push_back(inTime); 
+		addTargets(inTime, inTargets, vector<double>());
 	}
 	
 	unsigned int getSize() const { return mTimes.size(); }
 	
 	double getTime(unsigned int inIndex) const { return mTimes[inIndex]; }
-	const vector<double>& getTargets(unsigned int inIndex) const { return mTargets[inIndex]; }
-	const vector<double>& getParameters(unsigned int inIndex) const { return mParameters[inIndex]; }
-				
+	
+	unsigned int getNbTargets(unsigned int inIndex) const { return mTargetOffsets[inIndex+1] - mTargetOffsets[inIndex]; }
+	double getTarget(unsigned int inIndex, unsigned int inTarget) const { return mTargetValues[mTargetOffsets[inIndex]+inTarget]; }
+	vector<double> getTargets(unsigned int inIndex) const {
+		return vector<double>(mTargetValues.begin()+mTargetOffsets[inIndex], mTargetValues.begin()+mTargetOffsets[inIndex+1]);
+	}
+	
+	unsigned int getNbParameters(unsigned int inIndex) const { return mParameterOffsets[inIndex+1] - mParameterOffsets[inIndex]; }
+	double getParameter(unsigned int inIndex, unsigned int inParameter) const { return mParameterValues[mParameterOffsets[inIndex]+inParameter]; }
+	vector<double> getParameters(unsigned int inIndex) const {
+		return vector<double>(mParameterValues.begin()+mParameterOffsets[inIndex], mParameterValues.begin()+mParameterOffsets[inIndex+1]);
+	}
+	
+	void validate() const;
+	
 	void write(ostream &inStream) const;
+	void writeBinary(ostream &outStream) const;
+	void readBinary(istream &inStream);
 	
 	void createRandomCase(PACC::Randomizer *inRadomizer, unsigned int inNumberOfTarget, vector<double> inLimits, vector<double> inTimes);
 	
 private:
 	vector<double> mTimes;
-	vector< vector<double> > mTargets;
-	vector< vector<double> > mParameters;
+	vector<double> mTargetValues;
+	vector<unsigned int> mTargetOffsets;		//!< Start of the targets of each breakpoint, and end of the last one
+	vector<double> mParameterValues;
+	vector<unsigned int> mParameterOffsets;		//!< Start of the parameters of each breakpoint, and end of the last one
 };
 
 void readSimulationCase(std::string inString, std::vector<SimulationCase> &outCases);
+void readSimulationCaseFile(const std::string& inFilename, std::vector<SimulationCase> &outCases);
+void writeSimulationCaseFile(const std::string& inFilename, const std::vector<SimulationCase> &inCases);
+void readSimulationCases(std::istream &inStream, std::vector<SimulationCase> &outCases);
+void writeSimulationCases(std::ostream &outStream, const std::vector<SimulationCase> &inCases);
 
 #endif
@@ -0,0 +1,141 @@
+/*
+ *  SimulationLog.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *  
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#include "SimulationLog.h"
+#include <algorithm>
+#include <sstream>
+
+/*! \brief Return the identifier of a signal name, a new one is created if needed
+ *  The table must not be read by an evaluation while a name is added.
+ */
+unsigned int SimulationLog::Signals::add(const std::string& inName) {
+	std::map<std::string, unsigned int>::const_iterator lIter = mIDs.find(inName);
+	if(lIter != mIDs.end())
+		return lIter->second;
+	unsigned int lID = mNames.size();
+	mIDs[inName] = lID;
+	mNames.push_back(inName);
+	return lID;
+}
+
+/*! \brief Index the columns of a simulation log
+ *  The log and the signal table are both sorted by name, they are matched in a single merge.
+ *	The columns of the signals unknown to the table are not indexed. The view points to the
+ *	vectors of the log, it is invalidated when the log is modified.
+ *  \param  inLog Simulation log.
+ *  \param  inSignals Identifiers of the signals.
+ */
+void SimulationLog::attach(LogMap& inLog, const Signals& inSignals) {
+	mLog = &inLog;
+	mColumns.assign(inSignals.size(), 0);
+	mEntryIDs.assign(inLog.size(), -1);
+	std::map<std::string, unsigned int>::const_iterator lSignal = inSignals.mIDs.begin();
+	unsigned int lEntry = 0;
+	for(LogMap::iterator lIter = inLog.begin(); lIter != inLog.end(); ++lIter, ++lEntry) {
+		while(lSignal != inSignals.mIDs.end() && lSignal->first < lIter->first)
+			++lSignal;
+		if(lSignal == inSignals.mIDs.end())
+			break;
+		if(lSignal->first == lIter->first) {
+			mColumns[lSignal->second] = &(lIter->second);
+			mEntryIDs[lEntry] = lSignal->second;
+		}
+	}
+}
+
+/*! \brief Return a column of the log, an empty column if the signal was not logged
+ */
+const std::vector<double>& SimulationLog::getColumn(unsigned int inID) const {
+	static const std::vector<double> lEmpty;
+	if(!hasColumn(inID))
+		return lEmpty;
+	return *mColumns[inID];
+}
+
+/*! \brief Remove from the attached log every signal not in the list, and the empty columns
+ *  \param  inIDs Identifiers of the signals to keep.
+ */
+void SimulationLog::retain(const std::vector<unsigned int>& inIDs) {
+	if(mLog == 0)
+		return;
+	std::vector<char> lKept(mColumns.size(),0);
+	for(unsigned int i = 0; i < inIDs.size(); ++i) {
+		if(inIDs[i] < lKept.size())
+			lKept[inIDs[i]] = 1;
+	}
+	unsigned int lNbKept = 0;
+	std::vector<int>::const_iterator lEntryID = mEntryIDs.begin();
+	for(LogMap::iterator lIter = mLog->begin(); lIter != mLog->end(); ++lEntryID) {
+		int lID = *lEntryID;
+		if(lID >= 0 && lKept[lID] && !lIter->second.empty()) {
+			mEntryIDs[lNbKept++] = lID;
+			++lIter;
+		} else {
+			if(lID >= 0)
+				mColumns[lID] = 0;
+			mLog->erase(lIter++);
+		}
+	}
+	mEntryIDs.resize(lNbKept);
+}
+
+/*! \brief Preallocate the columns of the signals about to be logged
+ *  \param  ioLog Simulation log, usually empty.
+ *  \param  inSignals Signal table of the identifiers.
+ *  \param  inIDs Identifiers of the signals.
+ *  \param  inNbRows Expected number of logged values.
+ */
+void SimulationLog::reserve(LogMap& ioLog, const Signals& inSignals, const std::vector<unsigned int>& inIDs, unsigned int inNbRows) {
+	for(unsigned int i = 0; i < inIDs.size(); ++i) {
+		ioLog[inSignals.getName(inIDs[i])].reserve(inNbRows);
+	}
+}
+
+/*! \brief Format the attached log as CSV
+ *  The first line holds the signal names, then one line per logged value. The buffer can be
+ *	handed to a writer thread, the log is not needed once it is formatted.
+ */
+void SimulationLog::writeCSV(std::string& outBuffer) const {
+	std::ostringstream lStream;
+	lStream.precision(10);
+	if(mLog == 0) {
+		outBuffer.clear();
+		return;
+	}
+	
+	unsigned int lNbRows = 0;
+	for(LogMap::const_iterator lIter = mLog->begin(); lIter != mLog->end(); ++lIter) {
+		lStream << (lIter == mLog->begin() ? "" : ",") << lIter->first;
+		lNbRows = std::max(lNbRows, (unsigned int)lIter->second.size());
+	}
+	lStream << "\n";
+	for(unsigned int i = 0; i < lNbRows; ++i) {
+		for(LogMap::const_iterator lIter = mLog->begin(); lIter != mLog->end(); ++lIter) {
+			if(lIter != mLog->begin())
+				lStream << ",";
+			if(i < lIter->second.size())
+				lStream << lIter->second[i];
+		}
+		lStream << "\n";
+	}
+	outBuffer = lStream.str();
+}
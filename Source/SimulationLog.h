@@ -0,0 +1,75 @@
+/*
+ *  SimulationLog.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *  
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef SimulationLog_H
+#define SimulationLog_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+/*! \brief Columnar view of a bond graph simulation log
+ *  The signal names are resolved once into integer identifiers by a signal table. Attaching a
+ *	view to the log returned by BondGraph::getSimulationLog indexes its columns by identifier
+ *	without copying them, so the error computation reads contiguous columns without name lookups.
+ */
+class SimulationLog {
+public:
+	typedef std::map<std::string, std::vector<double> > LogMap;
+	
+	/*! \brief Identifiers of the signal names
+	 *  The table is filled when the evaluation operator is built, the evaluations only read it
+	 *	and can share it without locking.
+	 */
+	class Signals {
+	public:
+		unsigned int add(const std::string& inName);
+		unsigned int size() const { return mNames.size(); }
+		const std::string& getName(unsigned int inID) const { return mNames[inID]; }
+		
+	private:
+		friend class SimulationLog;
+		std::map<std::string, unsigned int> mIDs;
+		std::vector<std::string> mNames;
+	};
+	
+	SimulationLog() : mLog(0) {}
+	SimulationLog(LogMap& inLog, const Signals& inSignals) : mLog(0) { attach(inLog, inSignals); }
+	~SimulationLog() {}
+	
+	void attach(LogMap& inLog, const Signals& inSignals);
+	
+	bool hasColumn(unsigned int inID) const { return inID < mColumns.size() && mColumns[inID] != 0; }
+	const std::vector<double>& getColumn(unsigned int inID) const;
+	
+	void retain(const std::vector<unsigned int>& inIDs);
+	static void reserve(LogMap& ioLog, const Signals& inSignals, const std::vector<unsigned int>& inIDs, unsigned int inNbRows);
+	
+	void writeCSV(std::string& outBuffer) const;
+	
+private:
+	LogMap* mLog;
+	std::vector< std::vector<double>* > mColumns;	//!< Columns of the attached log, indexed by signal identifier
+	std::vector<int> mEntryIDs;						//!< Identifier of each column of the log in its order, -1 if unknown
+};
+
+#endif
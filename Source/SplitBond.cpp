@@ -33,9 +33,11 @@ void SplitBond::insert(Beagle::GP::Datum& inBond, BG::Junction::JunctionType inT
 	BondPtr& lInBond = castObjectT<BondPtr&>(inBond);
 	GrowingBG::Handle lGrowingBondGraph = lContext.getBondGraph();
 	BG::BondGraph* lBondGraph = lGrowingBondGraph->getBondGraph();
+	//The new bonds are connected without a causality
+	lGrowingBondGraph->setCausalityInvalid();
 	
-	BG::Junction* lNewJunction1 = new BG::Junction(inType1);
-	BG::Junction* lNewJunction2 = new BG::Junction(inType2);
+	BG::Junction* lNewJunction1 = lContext.getComponentArena().create<BG::Junction>(inType1);
+	BG::Junction* lNewJunction2 = lContext.getComponentArena().create<BG::Junction>(inType2);
 	
 	BG::Bond* lNewBond0 = 0;
 	BG::Bond* lNewBond1 = 0;
@@ -34,9 +34,11 @@ void SplitBondSame::insert(Beagle::GP::Datum& inBond, BG::Junction::JunctionType
 	BondPtr& lInBond = castObjectT<BondPtr&>(inBond);
 	GrowingBG::Handle lGrowingBondGraph = lContext.getBondGraph();
 	BG::BondGraph* lBondGraph = lGrowingBondGraph->getBondGraph();
+	//The new bonds are connected without a causality
+	lGrowingBondGraph->setCausalityInvalid();
 
-	BG::Junction* lNewJunction1 = new BG::Junction(inType1); //Split
-	BG::Junction* lNewJunction2 = new BG::Junction(inType2); //Paralelle
+	BG::Junction* lNewJunction1 = lContext.getComponentArena().create<BG::Junction>(inType1); //Split
+	BG::Junction* lNewJunction2 = lContext.getComponentArena().create<BG::Junction>(inType2); //Paralelle
 	
 	BG::Bond* lNewBond0 = 0;
 	BG::Bond* lNewBond1 = 0;
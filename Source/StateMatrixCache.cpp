@@ -0,0 +1,59 @@
+/*
+ *  StateMatrixCache.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *  
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#include "StateMatrixCache.h"
+
+using namespace BG;
+
+/*! \brief Return the matrices of a switch configuration
+ *  On the first request of a configuration, the state equations are computed from the bond
+ *	graph, which should be in the requested switch configuration.
+ *  \param  inBondGraph Bond graph in the switch configuration inSwitchState.
+ *  \param  inSwitchState State of each switch.
+ *  \return Matrices of the state and output equations.
+ */
+StateMatrixCache::Entry& StateMatrixCache::getMatrices(HybridBondGraph* inBondGraph, const std::vector<bool>& inSwitchState) {
+	std::map< std::vector<bool>, Entry >::iterator lIter = mEntries.find(inSwitchState);
+	if(lIter != mEntries.end()) {
+		++mHits;
+		return lIter->second;
+	}
+	++mMisses;
+	
+	Entry lEntry;
+	inBondGraph->computeStateEquation();
+	inBondGraph->getStateMatrix(lEntry.mA,lEntry.mB,lEntry.mB2);
+	inBondGraph->getOutputMatrix(lEntry.mC,lEntry.mD,lEntry.mD2);
+	return mEntries.insert(std::make_pair(inSwitchState,lEntry)).first->second;
+}
+
+/*! \brief Return the matrices of a switch configuration if they are already computed
+ *  The method doesn't modify the cache, it can be used concurrently by several readers.
+ *  \param  inSwitchState State of each switch.
+ *  \return Matrices of the configuration, or NULL if the configuration is not in the cache.
+ */
+const StateMatrixCache::Entry* StateMatrixCache::find(const std::vector<bool>& inSwitchState) const {
+	std::map< std::vector<bool>, Entry >::const_iterator lIter = mEntries.find(inSwitchState);
+	if(lIter == mEntries.end())
+		return NULL;
+	return &lIter->second;
+}
@@ -0,0 +1,69 @@
+/*
+ *  StateMatrixCache.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *  
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef StateMatrixCache_H
+#define StateMatrixCache_H
+
+#include <map>
+#include <vector>
+#include <PACC/Math.hpp>
+#include <HybridBondGraph.h>
+#include "ZOHPropagator.h"
+
+/*! \brief State and output matrices of a hybrid bond graph for each switch configuration
+ *  The matrices of a mode are derived once from the bond graph and reused each time the
+ *	switches come back to the same configuration. The matrices depend on the component
+ *	values, the cache should be cleared when the parameters of the bond graph change.
+ *
+ *	The cache serves the lookahead controller: the mapping of the targets to the initial state
+ *	and the propagation of the candidate modes with USE_ZOH. HybridBondGraph::simulate() and
+ *	simulateVirtual() change the mode and derive its equations inside libBondGraph, which takes
+ *	no external matrices, so the main integration loop doesn't use this cache.
+ */
+class StateMatrixCache {
+public:
+	//! Matrices of the state equations for one switch configuration
+	struct Entry {
+		PACC::Matrix mA, mB, mB2;
+		PACC::Matrix mC, mD, mD2;
+		ZOHPropagator mPropagator;	//!< Discretization of the mode, computed on request
+	};
+	
+	StateMatrixCache() : mHits(0), mMisses(0) {}
+	~StateMatrixCache() {}
+	
+	Entry& getMatrices(BG::HybridBondGraph* inBondGraph, const std::vector<bool>& inSwitchState);
+	const Entry* find(const std::vector<bool>& inSwitchState) const;
+	bool contains(const std::vector<bool>& inSwitchState) const { return mEntries.find(inSwitchState) != mEntries.end(); }
+	void clear() { mEntries.clear(); }
+	unsigned int size() const { return mEntries.size(); }
+	
+	unsigned long getHits() const { return mHits; }
+	unsigned long getMisses() const { return mMisses; }
+	
+private:
+	std::map< std::vector<bool>, Entry > mEntries;
+	unsigned long mHits;
+	unsigned long mMisses;
+};
+
+#endif
@@ -90,8 +90,9 @@ void StructuralHierarchicalFairCompetitionOp::operate(Deme& ioDeme, Context& ioC
 	// Migrating individual out of this deme.
 	if((ioContext.getDemeIndex() != (mPopSize->size()-1)) &&
 	   (mFitnessThresholds[ioContext.getDemeIndex()] != NULL)) {
+		// The migrants not yet taken by the next deme stay in the buffer, with asynchronous
+		// islands the next deme may be late.
 		Individual::Bag& lOutMigBuffer = ioDeme.getMigrationBuffer();
-		lOutMigBuffer.resize(0);
 		Fitness::Handle lThreshold = mFitnessThresholds[ioContext.getDemeIndex()];
 		std::make_heap(ioDeme.begin(), ioDeme.end(), IsLessPointerPredicate());
 		while(ioDeme.size() > 0) {
@@ -101,6 +102,23 @@ void StructuralHierarchicalFairCompetitionOp::operate(Deme& ioDeme, Context& ioC
 			ioDeme.pop_back();
 			lChanged = true;
 		}
+		
+		// The next deme can't take more migrants than its size, the worst ones are dropped
+		// when it is late.
+		const unsigned int lBufferSize = (*mPopSize)[ioContext.getDemeIndex()+1];
+		if(lOutMigBuffer.size() > lBufferSize) {
+			std::make_heap(lOutMigBuffer.begin(), lOutMigBuffer.end(), IsMorePointerPredicate());
+			while(lOutMigBuffer.size() > lBufferSize) {
+				std::pop_heap(lOutMigBuffer.begin(), lOutMigBuffer.end(), IsMorePointerPredicate());
+				Beagle_LogDebugM(
+								 ioContext.getSystem().getLogger(),
+								 "migration", "Beagle::HierarchicalFairCompetitionOp",
+								 std::string("Migrant dropped from the buffer of the ")+uint2ordinal(ioContext.getDemeIndex())+
+								 std::string(" deme: ")+lOutMigBuffer.back()->serialize()
+								 );
+				lOutMigBuffer.pop_back();
+			}
+		}
 	}
 	
 	// Fill the population with randomly generated individuals, if the population is too small.
@@ -135,3 +153,43 @@ void StructuralHierarchicalFairCompetitionOp::operate(Deme& ioDeme, Context& ioC
 	}
 	Beagle_StackTraceEndM("void HierarchicalFairCompetitionOp::operate(Deme& ioDeme, Context& ioContext)");
 }
+
+/*! \brief Read the fitness thresholds of the demes, written by writeThresholds
+ *  \param  inIter <FitnessThresholds> tag
+ *  \param  inFitnessAlloc Allocator of the fitness of the individuals
+ */
+void StructuralHierarchicalFairCompetitionOp::readThresholds(PACC::XML::ConstIterator inIter, Fitness::Alloc& inFitnessAlloc)
+{
+	Beagle_StackTraceBeginM();
+	if((inIter->getType()!=PACC::XML::eData) || (inIter->getValue()!="FitnessThresholds"))
+		throw Beagle_IOExceptionNodeM(*inIter, "tag <FitnessThresholds> expected!");
+	mFitnessThresholds.clear();
+	for(PACC::XML::ConstIterator lChild=inIter->getFirstChild(); lChild; ++lChild) {
+		if((lChild->getType()!=PACC::XML::eData) || (lChild->getValue()!="Threshold"))
+			continue;
+		Fitness::Handle lThreshold;
+		PACC::XML::ConstIterator lFitnessTag = lChild->getFirstChild();
+		if(lFitnessTag) {
+			lThreshold = castHandleT<Fitness>(inFitnessAlloc.allocate());
+			lThreshold->read(lFitnessTag);
+		}
+		mFitnessThresholds.push_back(lThreshold);
+	}
+	Beagle_StackTraceEndM("void StructuralHierarchicalFairCompetitionOp::readThresholds(PACC::XML::ConstIterator inIter, Fitness::Alloc& inFitnessAlloc)");
+}
+
+/*! \brief Write the fitness thresholds of the demes, a deme without threshold yet gets an empty tag
+ */
+void StructuralHierarchicalFairCompetitionOp::writeThresholds(PACC::XML::Streamer& ioStreamer) const
+{
+	Beagle_StackTraceBeginM();
+	ioStreamer.openTag("FitnessThresholds", false);
+	for(unsigned int i = 0; i < mFitnessThresholds.size(); ++i) {
+		ioStreamer.openTag("Threshold", false);
+		if(mFitnessThresholds[i] != NULL)
+			mFitnessThresholds[i]->write(ioStreamer, false);
+		ioStreamer.closeTag();
+	}
+	ioStreamer.closeTag();
+	Beagle_StackTraceEndM("void StructuralHierarchicalFairCompetitionOp::writeThresholds(PACC::XML::Streamer& ioStreamer) const");
+}
@@ -29,6 +29,9 @@
 /*! \brief Hierachical Fair Competition for structure flagged tree
  *	This operator redefine the  Beagle::HierarchicalFairCompetitionOp operate method
  *	so that the valid structure flag is set to invalid when the individual is migrated.
+ *	The migration buffer of a deme is emptied only by the next deme, it can then be used
+ *	by the asynchronous islands of AsyncIslandEvolver. The buffer keeps at most as many
+ *	migrants as the size of the next deme, the best ones.
  */
 class StructuralHierarchicalFairCompetitionOp : public Beagle::HierarchicalFairCompetitionOp {
 public:
@@ -40,6 +43,9 @@ public:
 	virtual ~StructuralHierarchicalFairCompetitionOp() { }
 	
 	virtual void operate(Beagle::Deme& ioDeme, Beagle::Context& ioContext);
+	
+	void readThresholds(PACC::XML::ConstIterator inIter, Beagle::Fitness::Alloc& inFitnessAlloc);
+	void writeThresholds(PACC::XML::Streamer& ioStreamer) const;
 };
 
 
@@ -0,0 +1,76 @@
+/*
+ *  CausalityBenchmark.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+/*
+ *  Time the growth and the causality assignment of random bond graphs, with the causality
+ *  assigned once grown, as before, and with the causality of the embryo extended by the
+ *  insertions, assignCausality() being only called when an insertion invalidated it.
+ *
+ *  Usage: CausalityBenchmark [sequences] [insertions]
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <PACC/Util/Timer.hpp>
+#include "RandomGrowth.h"
+
+using namespace std;
+
+/*! \brief Grow the bond graphs and assign their causality
+ *  \param  inNbSequences Number of bond graphs.
+ *  \param  inNbInsertions Number of insertions of each bond graph.
+ *  \param  inIncremental Extend the causality of the embryo.
+ *  \param  outNbAssigned Number of bond graphs that needed assignCausality() once grown.
+ *  \return Time in seconds.
+ */
+static double run(unsigned int inNbSequences, unsigned int inNbInsertions, bool inIncremental, unsigned int& outNbAssigned) {
+	outNbAssigned = 0;
+	double lTime = 0;
+	for(unsigned int s = 0; s < inNbSequences; ++s) {
+		GrowingHybridBondGraph lBondGraph;
+		RandomGrowth lGrowth(s+1);
+		PACC::Timer lTimer;
+		lGrowth.buildEmbryo(lBondGraph,inIncremental);
+		lGrowth.grow(lBondGraph,inNbInsertions);
+		try {
+			if(!lBondGraph.isCausalityValid()) {
+				lBondGraph.assignCausality();
+				++outNbAssigned;
+			}
+		} catch(BG::CausalityException inError) { }
+		lTime += lTimer.getValue();
+	}
+	return lTime;
+}
+
+int main(int argc, char** argv) {
+	unsigned int lNbSequences = argc > 1 ? atoi(argv[1]) : 10000;
+	unsigned int lNbInsertions = argc > 2 ? atoi(argv[2]) : 20;
+
+	unsigned int lNbAssigned;
+	double lFullTime = run(lNbSequences,lNbInsertions,false,lNbAssigned);
+	cout << "Assigned once grown: " << lFullTime*1e6/lNbSequences << " us per bond graph" << endl;
+	double lIncrementalTime = run(lNbSequences,lNbInsertions,true,lNbAssigned);
+	cout << "Extended by the insertions: " << lIncrementalTime*1e6/lNbSequences << " us per bond graph, "
+		 << lNbAssigned << " of " << lNbSequences << " reassigned once grown" << endl;
+	return EXIT_SUCCESS;
+}
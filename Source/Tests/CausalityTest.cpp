@@ -0,0 +1,91 @@
+/*
+ *  CausalityTest.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+/*
+ *  Check that the causality extended by the insertions gives the same state equations as the
+ *  causality assigned from scratch. Each random growth sequence is applied to two bond graphs:
+ *  the first has the causality of its embryo assigned and extended by the insertions, the
+ *  second is assigned by assignCausality() once grown.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include "RandomGrowth.h"
+
+using namespace std;
+
+static bool equalMatrices(const PACC::Matrix& inLeft, const PACC::Matrix& inRight) {
+	if(inLeft.getRows() != inRight.getRows() || inLeft.getCols() != inRight.getCols())
+		return false;
+	for(unsigned int i = 0; i < inLeft.size(); ++i) {
+		if(fabs(inLeft[i]-inRight[i]) > 1e-9*(1+fabs(inRight[i])))
+			return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	unsigned int lNbSequences = argc > 1 ? atoi(argv[1]) : 1000;
+	unsigned int lNbInsertions = argc > 2 ? atoi(argv[2]) : 20;
+	unsigned int lNbKept = 0;
+	unsigned int lNbConflicts = 0;
+	unsigned int lNbMismatches = 0;
+
+	for(unsigned int s = 0; s < lNbSequences; ++s) {
+		GrowingHybridBondGraph lIncremental;
+		RandomGrowth lGrowth1(s+1);
+		lGrowth1.buildEmbryo(lIncremental,true);
+		lGrowth1.grow(lIncremental,lNbInsertions);
+		if(!lIncremental.isCausalityValid())
+			continue;
+		++lNbKept;
+
+		GrowingHybridBondGraph lReference;
+		RandomGrowth lGrowth2(s+1);
+		lGrowth2.buildEmbryo(lReference,false);
+		lGrowth2.grow(lReference,lNbInsertions);
+		try {
+			lReference.clearCausality();
+			lReference.assignCausality();
+		} catch(BG::CausalityException inError) {
+			//The incremental causality is only kept when it is conflict free
+			++lNbConflicts;
+			cerr << "Sequence " << s+1 << ": the causality was kept, but assignCausality failed" << endl;
+			continue;
+		}
+
+		lIncremental.computeStateEquation();
+		lReference.computeStateEquation();
+		PACC::Matrix lA1,lB1,lB21,lA2,lB2,lB22;
+		lIncremental.getStateMatrix(lA1,lB1,lB21);
+		lReference.getStateMatrix(lA2,lB2,lB22);
+		if(!equalMatrices(lA1,lA2) || !equalMatrices(lB1,lB2) || !equalMatrices(lB21,lB22)) {
+			++lNbMismatches;
+			cerr << "Sequence " << s+1 << ": the state equations differ" << endl;
+		}
+	}
+
+	cout << lNbSequences << " sequences of " << lNbInsertions << " insertions, the causality was kept by "
+		 << lNbKept << ", " << lNbMismatches << " mismatches, " << lNbConflicts << " conflicts" << endl;
+	return (lNbMismatches == 0 && lNbConflicts == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,208 @@
+/*
+ *  CheckpointJournalTest.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+/*
+ *  Check the replay of the checkpoint journal. Checkpoints are written and the journal is
+ *  replayed as by CheckpointReadOp, the records of a checkpoint only being applied at its
+ *  commit. The journal is then cut at every byte and corrupted: the replay must give the state
+ *  of the last complete checkpoint. A rewritten journal must leave the previous file valid up
+ *  to its first commit.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+#include "CheckpointJournal.h"
+
+using namespace std;
+
+//! State rebuilt by the replay of a journal.
+struct JournalState {
+	JournalState() : mGeneration(0), mNbDemes(0), mNbCommits(0) {}
+	bool operator==(const JournalState& inRight) const {
+		return mGeneration == inRight.mGeneration && mNbDemes == inRight.mNbDemes &&
+			   mNbCommits == inRight.mNbCommits && mRecords == inRight.mRecords;
+	}
+	bool operator!=(const JournalState& inRight) const { return !(*this == inRight); }
+
+	unsigned int mGeneration;
+	unsigned int mNbDemes;
+	unsigned int mNbCommits;
+	map<string, string> mRecords;	//!< Last committed payload of each type, deme and index
+};
+
+static string makeKey(unsigned int inType, unsigned int inDeme, unsigned int inIndex) {
+	ostringstream lKey;
+	lKey << inType << "/" << inDeme << "/" << inIndex;
+	return lKey.str();
+}
+
+//! Replay the journal up to its last commit, return false if it is not a journal.
+static bool replay(const string& inBytes, JournalState& outState) {
+	outState = JournalState();
+	istringstream lStream(inBytes);
+	if(!CheckpointJournal::readHeader(lStream))
+		return false;
+	vector<CheckpointJournal::Record> lPending;
+	CheckpointJournal::Record lRecord;
+	while(CheckpointJournal::read(lStream, lRecord)) {
+		if(lRecord.mType != CheckpointJournal::eCommit) {
+			lPending.push_back(lRecord);
+			continue;
+		}
+		for(unsigned int i = 0; i < lPending.size(); ++i)
+			outState.mRecords[makeKey(lPending[i].mType, lPending[i].mDeme, lPending[i].mIndex)].swap(lPending[i].mPayload);
+		lPending.clear();
+		outState.mNbDemes = lRecord.mDeme;
+		outState.mGeneration = lRecord.mIndex;
+		++outState.mNbCommits;
+	}
+	return true;
+}
+
+static string readFile(const string& inFilename) {
+	ifstream lStream(inFilename.c_str(), ios::in | ios::binary);
+	ostringstream lBytes;
+	lBytes << lStream.rdbuf();
+	return lBytes.str();
+}
+
+static const unsigned int scNbDemes = 3;
+
+/*! \brief Write the records of a checkpoint and apply them to the expected state
+ *  \param  ioJournal Open journal.
+ *  \param  ioExpected State expected once the checkpoint is committed.
+ *  \param  inGeneration Generation of the checkpoint, it also varies the payloads.
+ */
+static void writeCheckpoint(CheckpointJournal& ioJournal, JournalState& ioExpected, unsigned int inGeneration) {
+	for(unsigned int d = 0; d < scNbDemes; ++d) {
+		unsigned int lDemeSize = 4 + (inGeneration+d)%3;
+		ioJournal.write(CheckpointJournal::eDemeSize, d, lDemeSize, string());
+		ioExpected.mRecords[makeKey(CheckpointJournal::eDemeSize, d, lDemeSize)] = string();
+		//Only some of the individuals changed since the previous checkpoint
+		for(unsigned int i = inGeneration%2; i < lDemeSize; i += 2) {
+			ostringstream lPayload;
+			lPayload << "<Individual generation=\"" << inGeneration << "\" deme=\"" << d << "\" index=\"" << i << "\"/>";
+			ioJournal.write(CheckpointJournal::eIndividual, d, i, lPayload.str());
+			ioExpected.mRecords[makeKey(CheckpointJournal::eIndividual, d, i)] = lPayload.str();
+		}
+	}
+	string lRandomizer(1 + inGeneration%7, char('a'+inGeneration%26));
+	ioJournal.write(CheckpointJournal::eRandomizer, 0, 0, lRandomizer);
+	ioExpected.mRecords[makeKey(CheckpointJournal::eRandomizer, 0, 0)] = lRandomizer;
+}
+
+//! Commit the checkpoint and update the expected state.
+static void commitCheckpoint(CheckpointJournal& ioJournal, JournalState& ioExpected, unsigned int inGeneration) {
+	ioJournal.commit(inGeneration, scNbDemes);
+	ioExpected.mGeneration = inGeneration;
+	ioExpected.mNbDemes = scNbDemes;
+	++ioExpected.mNbCommits;
+}
+
+int main() {
+	const string lFilename = "CheckpointJournalTest.journal";
+	unsigned int lNbFailures = 0;
+	JournalState lState;
+
+	//States after each commit, and journal size at each commit
+	vector<JournalState> lCommitted(1);
+	vector<string::size_type> lCommitEnds(1, 8);
+	{
+		CheckpointJournal lJournal;
+		lJournal.open(lFilename, true);
+		for(unsigned int g = 1; g <= 5; ++g) {
+			//Some of the records are written twice, the last one counts
+			JournalState lExpected = lCommitted.back();
+			writeCheckpoint(lJournal, lExpected, g+100);
+			writeCheckpoint(lJournal, lExpected, g);
+			commitCheckpoint(lJournal, lExpected, g);
+			lCommitted.push_back(lExpected);
+			lCommitEnds.push_back(readFile(lFilename).size());
+		}
+		//Checkpoint interrupted before its commit, the journal is flushed when closed
+		JournalState lUncommitted = lCommitted.back();
+		writeCheckpoint(lJournal, lUncommitted, 6);
+	}
+
+	string lBytes = readFile(lFilename);
+	if(!replay(lBytes, lState) || lState != lCommitted.back()) {
+		cerr << "The replay of the journal doesn't give its last checkpoint" << endl;
+		++lNbFailures;
+	}
+
+	//A journal cut anywhere is replayed up to its last complete commit
+	unsigned int lCommit = 0;
+	for(string::size_type lEnd = 8; lEnd <= lBytes.size(); ++lEnd) {
+		while(lCommit+1 < lCommitEnds.size() && lCommitEnds[lCommit+1] <= lEnd)
+			++lCommit;
+		if(!replay(lBytes.substr(0, lEnd), lState) || lState != lCommitted[lCommit]) {
+			cerr << "The journal cut at " << lEnd << " of " << lBytes.size() << " bytes is not replayed up to its commit "
+				 << lCommit << endl;
+			++lNbFailures;
+			break;
+		}
+	}
+
+	//A corrupted payload stops the replay at the previous commit, the last payload before a
+	//commit is the randomizer, followed by the commit record of 20 bytes
+	string lCorrupted = lBytes;
+	lCorrupted[lCommitEnds[3]-21] ^= 0x20;
+	if(!replay(lCorrupted, lState) || lState != lCommitted[2]) {
+		cerr << "The corrupted journal is not replayed up to the commit before the corruption" << endl;
+		++lNbFailures;
+	}
+
+	//A rewritten journal replaces the file at its first commit only
+	JournalState lRewritten;
+	CheckpointJournal lJournal;
+	lJournal.open(lFilename, true);
+	writeCheckpoint(lJournal, lRewritten, 7);
+	if(!replay(readFile(lFilename), lState) || lState != lCommitted.back()) {
+		cerr << "The journal was replaced before the commit of its rewrite" << endl;
+		++lNbFailures;
+	}
+	commitCheckpoint(lJournal, lRewritten, 7);
+	if(!replay(readFile(lFilename), lState) || lState != lRewritten) {
+		cerr << "The rewritten journal doesn't give its checkpoint" << endl;
+		++lNbFailures;
+	}
+	writeCheckpoint(lJournal, lRewritten, 8);
+	commitCheckpoint(lJournal, lRewritten, 8);
+	if(!replay(readFile(lFilename), lState) || lState != lRewritten) {
+		cerr << "The checkpoint appended to the rewritten journal is not replayed" << endl;
+		++lNbFailures;
+	}
+	remove(lFilename.c_str());
+
+	if(replay("<?xml version=\"1.0\"?>", lState)) {
+		cerr << "A file which is not a journal was replayed" << endl;
+		++lNbFailures;
+	}
+
+	cout << lBytes.size() << " bytes of journal, " << (lNbFailures == 0 ? "all the replays match" : "some replays don't match") << endl;
+	return lNbFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,137 @@
+/*
+ *  DataCodecTest.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+/*
+ *  Check that the XOR encoding of the logged data gives back the same bits: smooth signals as
+ *  logged by the simulations, random bits, and the special values (signed zeros, infinities,
+ *  NaN with payloads, denormals). The truncated and corrupted encodings must be rejected.
+ */
+
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include "DataCodec.h"
+
+using namespace std;
+
+static double bits2double(unsigned long long inBits) {
+	double lValue;
+	memcpy(&lValue, &inBits, sizeof(lValue));
+	return lValue;
+}
+
+//! Encode and decode the series, return true if the bits are unchanged.
+static bool roundTrip(const char* inName, const vector<double>& inData) {
+	string lBytes;
+	vector<double> lDecoded;
+	encodeXorDoubles(inData, lBytes);
+	decodeXorDoubles(lBytes, lDecoded);
+	if(lDecoded.size() != inData.size()) {
+		cerr << inName << ": " << lDecoded.size() << " values decoded instead of " << inData.size() << endl;
+		return false;
+	}
+	for(unsigned int i = 0; i < inData.size(); ++i) {
+		if(memcmp(&lDecoded[i], &inData[i], sizeof(double)) != 0) {
+			cerr << inName << ": value " << i << " decoded as " << lDecoded[i] << " instead of " << inData[i] << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+//! Return true if decodeXorDoubles rejects the bytes.
+static bool isRejected(const string& inBytes) {
+	vector<double> lDecoded;
+	try {
+		decodeXorDoubles(inBytes, lDecoded);
+	} catch(std::runtime_error&) {
+		return true;
+	}
+	return false;
+}
+
+int main() {
+	unsigned int lNbFailures = 0;
+
+	lNbFailures += !roundTrip("empty", vector<double>());
+	lNbFailures += !roundTrip("single", vector<double>(1, 3.25));
+
+	vector<double> lConstant(1000, -1.5);
+	lNbFailures += !roundTrip("constant", lConstant);
+	string lBytes, lFirst;
+	encodeXorDoubles(lConstant, lBytes);
+	encodeXorDoubles(vector<double>(1, lConstant[0]), lFirst);
+	if(lBytes.size() != lFirst.size() + lConstant.size()-1) {
+		cerr << "constant: " << lBytes.size() << " bytes, a repeated value must take a single byte" << endl;
+		++lNbFailures;
+	}
+
+	vector<double> lSmooth;
+	for(unsigned int i = 0; i < 10000; ++i)
+		lSmooth.push_back(2.5*sin(i*1e-3) + 0.1*i);
+	lNbFailures += !roundTrip("smooth", lSmooth);
+
+	vector<double> lRandom;
+	unsigned long long lState = 1;
+	for(unsigned int i = 0; i < 10000; ++i) {
+		lState = lState*6364136223846793005ULL + 1442695040888963407ULL;
+		lRandom.push_back(bits2double(lState));
+	}
+	lNbFailures += !roundTrip("random bits", lRandom);
+
+	vector<double> lSpecial;
+	lSpecial.push_back(0.0);
+	lSpecial.push_back(-0.0);
+	lSpecial.push_back(0.0);
+	lSpecial.push_back(numeric_limits<double>::infinity());
+	lSpecial.push_back(-numeric_limits<double>::infinity());
+	lSpecial.push_back(bits2double(0x7ff8000000000001ULL));
+	lSpecial.push_back(bits2double(0xfff4000000000123ULL));
+	lSpecial.push_back(numeric_limits<double>::denorm_min());
+	lSpecial.push_back(-DBL_MIN/3);
+	lSpecial.push_back(DBL_MAX);
+	lSpecial.push_back(-DBL_MAX);
+	lSpecial.push_back(DBL_EPSILON);
+	lNbFailures += !roundTrip("special values", lSpecial);
+
+	//A value can't be cut, its header gives the number of bytes that follow
+	encodeXorDoubles(lSmooth, lBytes);
+	string lPrefix;
+	encodeXorDoubles(vector<double>(lSmooth.begin(), lSmooth.end()-1), lPrefix);
+	for(unsigned int lEnd = lPrefix.size()+1; lEnd < lBytes.size(); ++lEnd) {
+		if(!isRejected(lBytes.substr(0, lEnd))) {
+			cerr << "The encoding cut at " << lEnd << " of " << lBytes.size() << " bytes was accepted" << endl;
+			++lNbFailures;
+		}
+	}
+	if(!isRejected(string(1, char(0x90))) || !isRejected(string(1, char(0x44)))) {
+		cerr << "An invalid header was accepted" << endl;
+		++lNbFailures;
+	}
+
+	cout << (lNbFailures == 0 ? "All the series round trip" : "Some series don't round trip") << endl;
+	return lNbFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,166 @@
+/*
+ *  EvaluationSandboxTest.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+/*
+ *  Check that the sandbox isolates the jobs that kill their process. Some jobs of the batches
+ *  dereference a null pointer, hang, allocate more than the memory budget or throw. Each of
+ *  them must be reported as failed with the reason, and every other job, including the ones
+ *  after a failed job in its batch, must give its result.
+ */
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "EvaluationSandbox.h"
+
+using namespace std;
+
+//! Kind of the test jobs, given by their number.
+enum JobKind {eNormalJob, eSegfaultJob, eHangJob, eMemoryJob, eThrowJob};
+
+static JobKind getKind(unsigned int inJob) {
+	switch(inJob) {
+		case 3: return eSegfaultJob;
+		case 8: return eHangJob;
+		case 9: return eMemoryJob;
+		case 14: return eThrowJob;
+		case 15: return eSegfaultJob;
+		default: return eNormalJob;
+	}
+}
+
+static string getExpectedResult(unsigned int inJob) {
+	ostringstream lResult;
+	lResult << "job " << inJob << " squared " << inJob*inJob;
+	return lResult.str();
+}
+
+//! Sandbox running the test jobs and keeping what it receives.
+class TestSandbox : public EvaluationSandbox {
+public:
+	TestSandbox(unsigned int inNbProcesses, double inTimeBudget, unsigned int inMemoryBudget) :
+	EvaluationSandbox(inNbProcesses, inTimeBudget, inMemoryBudget), mNbDuplicates(0), mNull(0) {}
+
+	map<unsigned int, string> mResults;
+	map<unsigned int, string> mFailures;
+	unsigned int mNbDuplicates;	//!< Jobs received more than once
+
+protected:
+	virtual void prepareChild() {
+		//The crashed jobs must not leave core files behind
+		struct rlimit lLimit;
+		lLimit.rlim_cur = lLimit.rlim_max = 0;
+		setrlimit(RLIMIT_CORE, &lLimit);
+	}
+
+	virtual string runJob(unsigned int inJob) {
+		switch(getKind(inJob)) {
+			case eSegfaultJob:
+				*mNull = 1;
+				break;
+			case eHangJob:
+				for(;;) pause();
+			case eMemoryJob: {
+				//Twice the memory budget, touched so that it can't stay virtual
+				char* lBlock = new char[512*1024*1024];
+				for(unsigned int i = 0; i < 512*1024*1024; i += 4096)
+					lBlock[i] = char(i);
+				delete[] lBlock;
+				break;
+			}
+			case eThrowJob:
+				throw runtime_error("job thrown on purpose");
+			default:
+				break;
+		}
+		return getExpectedResult(inJob);
+	}
+
+	virtual void receiveResult(unsigned int inJob, const string& inResult) {
+		mNbDuplicates += mResults.count(inJob) + mFailures.count(inJob);
+		mResults[inJob] = inResult;
+	}
+
+	virtual void receiveFailure(unsigned int inJob, const string& inReason) {
+		mNbDuplicates += mResults.count(inJob) + mFailures.count(inJob);
+		mFailures[inJob] = inReason;
+	}
+
+private:
+	volatile int* mNull;	//!< Dereferenced by the jobs that crash
+};
+
+int main() {
+	const unsigned int lNbJobs = 20;
+	unsigned int lNbFailures = 0;
+
+	vector<unsigned int> lJobs;
+	for(unsigned int i = 0; i < lNbJobs; ++i)
+		lJobs.push_back(i);
+	TestSandbox lSandbox(4, 0.5, 256);
+	lSandbox.run(lJobs);
+
+	if(lSandbox.mNbDuplicates != 0) {
+		cerr << lSandbox.mNbDuplicates << " jobs were received more than once" << endl;
+		++lNbFailures;
+	}
+	for(unsigned int i = 0; i < lNbJobs; ++i) {
+		map<unsigned int, string>::const_iterator lResult = lSandbox.mResults.find(i);
+		map<unsigned int, string>::const_iterator lFailure = lSandbox.mFailures.find(i);
+		JobKind lKind = getKind(i);
+		if(lKind == eNormalJob) {
+			if(lResult == lSandbox.mResults.end() || lResult->second != getExpectedResult(i)) {
+				cerr << "Job " << i << ": " << (lFailure != lSandbox.mFailures.end() ? lFailure->second : string("wrong or missing result")) << endl;
+				++lNbFailures;
+			}
+			continue;
+		}
+		if(lFailure == lSandbox.mFailures.end()) {
+			cerr << "Job " << i << " was not reported as failed" << endl;
+			++lNbFailures;
+			continue;
+		}
+		//The jobs that throw or exceed the memory budget end their process with an error code
+		string lExpected = "exited with code";
+		if(lKind == eSegfaultJob) {
+			ostringstream lSignal;
+			lSignal << "killed by signal " << SIGSEGV;
+			lExpected = lSignal.str();
+		} else if(lKind == eHangJob) {
+			lExpected = "time budget";
+		}
+		if(lFailure->second.find(lExpected) == string::npos) {
+			cerr << "Job " << i << " failed with \"" << lFailure->second << "\" instead of \"" << lExpected << "\"" << endl;
+			++lNbFailures;
+		}
+	}
+
+	cout << lSandbox.mResults.size() << " results, " << lSandbox.mFailures.size() << " failed jobs, "
+		 << (lNbFailures == 0 ? "all as expected" : "some are not as expected") << endl;
+	return lNbFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
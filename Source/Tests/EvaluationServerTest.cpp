@@ -0,0 +1,342 @@
+/*
+ *  EvaluationServerTest.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+/*
+ *  Check the evaluation farm over the loopback interface. A master evaluates a deme with a
+ *  worker process listening on 127.0.0.1, the generation tells the worker what to do:
+ *	 0: every individual is evaluated by the worker, on the simulation cases sent by the setup.
+ *	 1: the worker raises an exception, the master must report it.
+ *	 2: the worker crashes, its individual gets a null fitness and the master evaluates the rest.
+ *	 3: a new worker hangs, the master must give up after eval.farm.timeout.
+ *  The fitness of an individual tells which process evaluated it and on how many cases.
+ *
+ *  Usage: EvaluationServerTest [port]
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <beagle/GP.hpp>
+#include "BondGraphEvalOp.h"
+#include "BGContext.h"
+#include "EvaluationServer.h"
+#include "SimulationCase.h"
+
+using namespace std;
+using namespace Beagle;
+
+static const unsigned int scNbIndividuals = 6;
+static const unsigned int scNbCases = 3;
+static const unsigned int scErrorIndex = 1;
+static const unsigned int scCrashIndex = 3;
+static const unsigned int scHangIndex = 2;
+static const char* scErrorMessage = "evaluation failed on purpose";
+
+//! Fitness expected for an individual, the worker adds 100 to the value computed by the master.
+static float getExpectedFitness(unsigned int inIndex, bool inByWorker) {
+	return float((inByWorker ? 100 : 0) + 1000*scNbCases + inIndex);
+}
+
+//! Terminal of the test trees, the trees are never interpreted.
+class TestTerminal : public GP::Primitive {
+public:
+	TestTerminal() : GP::Primitive(0, "T") {}
+	virtual void execute(GP::Datum& outDatum, GP::Context& ioContext) {}
+};
+
+/*! \brief Evaluation operator of the test
+ *  The fitness is computed from the index of the individual, the number of simulation cases
+ *	and the process: a worker of the farm adds 100. The worker fails as told by the generation.
+ */
+class TestEvalOp : public BondGraphEvalOp {
+public:
+	typedef AllocatorT<TestEvalOp,BondGraphEvalOp::Alloc> Alloc;
+	typedef PointerT<TestEvalOp,BondGraphEvalOp::Handle> Handle;
+	typedef ContainerT<TestEvalOp,BondGraphEvalOp::Bag> Bag;
+
+	TestEvalOp() : BondGraphEvalOp("TestEvalOp") {}
+
+	virtual Fitness::Handle evaluate(GP::Individual& inIndividual, GP::Context& ioContext) {
+		unsigned int lIndex = ioContext.getIndividualIndex();
+		if(isFarmWorker()) {
+			if(ioContext.getGeneration() == 1 && lIndex == scErrorIndex)
+				throw std::runtime_error(scErrorMessage);
+			if(ioContext.getGeneration() == 2 && lIndex == scCrashIndex)
+				_exit(EXIT_FAILURE);
+			if(ioContext.getGeneration() == 3 && lIndex == scHangIndex)
+				for(;;) pause();
+		}
+		return new FitnessSimple((isFarmWorker() ? 100 : 0) + 1000*mSimulationCases.size() + lIndex);
+	}
+
+	//! Use the simulation cases, which the master sends to its workers.
+	void setSimulationCases(const std::vector<SimulationCase>& inCases) { mSimulationCases = inCases; }
+
+	//! Wait for the file writer, the crashed individuals are written in the background.
+	void flushFiles() { mFileWriter->flush(); }
+
+	/*! \brief Serve the evaluations of a master, as serveEvaluations does
+	 *  \param  ioDeme Deme of the worker.
+	 *  \param  ioContext Evolutionary context.
+	 *  \param  inReady Pipe written once the server listens to its port.
+	 */
+	void serve(Deme& ioDeme, Context& ioContext, int inReady) {
+		EvaluationServer lServer(*this, ioDeme, createTaskContext(ioContext), mFarmPort->getWrappedValue());
+		char lByte = 'R';
+		if(::write(inReady, &lByte, 1) != 1)
+			throw std::runtime_error("the ready pipe is closed");
+		lServer.run(1);
+		lServer.wait();
+	}
+};
+
+//! System, evolver and deme of a process, configured by a command line option.
+struct TestSystem {
+	explicit TestSystem(std::string inOption) {
+		GP::PrimitiveSet::Handle lSet = new GP::PrimitiveSet;
+		mTerminal = new TestTerminal;
+		lSet->insert(mTerminal);
+		BGContext::Alloc::Handle lContextAlloc = new BGContext::Alloc;
+		mSystem = new GP::System(lSet, lContextAlloc);
+		mEvalOp = new TestEvalOp;
+		GP::Tree::Alloc::Handle lTreeAlloc = new GP::Tree::Alloc;
+		FitnessSimple::Alloc::Handle lFitAlloc = new FitnessSimple::Alloc;
+		mVivarium = new GP::Vivarium(lTreeAlloc, lFitAlloc);
+		mEvolver = new GP::Evolver(mEvalOp);
+
+		std::string lProgram = "EvaluationServerTest";
+		char* lArgv[] = {&lProgram[0], &inOption[0], NULL};
+		int lArgc = 2;
+		mEvolver->initialize(mSystem, lArgc, lArgv);
+
+		mVivarium->resize(1);
+		mContext = castHandleT<BGContext>(mSystem->getContextAllocator().allocate());
+		mContext->setSystemHandle(mSystem);
+		mContext->setEvolverHandle(mEvolver);
+		mContext->setVivariumHandle(mVivarium);
+		mContext->setDemeIndex(0);
+		mContext->setDemeHandle((*mVivarium)[0]);
+		mContext->setGeneration(0);
+	}
+
+	Deme& getDeme() { return *(*mVivarium)[0]; }
+
+	GP::Primitive::Handle mTerminal;
+	GP::System::Handle mSystem;
+	TestEvalOp::Handle mEvalOp;
+	GP::Evolver::Handle mEvolver;
+	GP::Vivarium::Handle mVivarium;
+	BGContext::Handle mContext;
+};
+
+//! Worker process, it builds its system once the parent writes to its start pipe.
+struct WorkerProcess {
+	pid_t mPid;
+	int mStart;		//!< Write end of the start pipe
+	int mReady;		//!< Read end of the ready pipe
+};
+
+/*! \brief Fork a worker before the master starts its threads
+ *  The worker waits for its start, serves a master on inPort and exits when the master closes
+ *	the connection.
+ */
+static WorkerProcess forkWorker(unsigned int inPort) {
+	int lStart[2], lReady[2];
+	if(pipe(lStart) != 0 || pipe(lReady) != 0)
+		throw std::runtime_error("pipe failed");
+	WorkerProcess lWorker;
+	lWorker.mPid = fork();
+	if(lWorker.mPid < 0)
+		throw std::runtime_error("fork failed");
+	if(lWorker.mPid == 0) {
+		::close(lStart[1]);
+		::close(lReady[0]);
+		char lByte;
+		if(::read(lStart[0], &lByte, 1) != 1)
+			_exit(EXIT_SUCCESS);
+		try {
+			TestSystem lWorkerSystem(std::string("-OBeval.farm.port=")+uint2str(inPort));
+			lWorkerSystem.mEvalOp->serve(lWorkerSystem.getDeme(), *lWorkerSystem.mContext, lReady[1]);
+		} catch(Beagle::Exception& inError) {
+			cerr << "Worker: " << inError.getMessage() << endl;
+			_exit(EXIT_FAILURE);
+		} catch(std::exception& inError) {
+			cerr << "Worker: " << inError.what() << endl;
+			_exit(EXIT_FAILURE);
+		}
+		_exit(EXIT_SUCCESS);
+	}
+	::close(lStart[0]);
+	::close(lReady[1]);
+	lWorker.mStart = lStart[1];
+	lWorker.mReady = lReady[0];
+	return lWorker;
+}
+
+//! Start a forked worker and wait until it listens, return false if it failed.
+static bool startWorker(WorkerProcess& ioWorker) {
+	char lByte = 'S';
+	if(::write(ioWorker.mStart, &lByte, 1) != 1)
+		return false;
+	ssize_t lCount;
+	while((lCount = ::read(ioWorker.mReady, &lByte, 1)) < 0 && errno == EINTR);
+	return lCount == 1;
+}
+
+//! Kill a worker if it still runs and collect it, return its wait status.
+static int stopWorker(WorkerProcess& ioWorker, bool inKill) {
+	::close(ioWorker.mStart);
+	::close(ioWorker.mReady);
+	if(inKill) kill(ioWorker.mPid, SIGKILL);
+	int lStatus = 0;
+	while(waitpid(ioWorker.mPid, &lStatus, 0) < 0 && errno == EINTR);
+	return lStatus;
+}
+
+/*! \brief Evaluate the deme of the master for a generation
+ *  \return Error raised by the evaluation, empty if none.
+ */
+static std::string evaluateGeneration(TestSystem& ioMaster, unsigned int inGeneration) {
+	Deme& lDeme = ioMaster.getDeme();
+	for(unsigned int i = 0; i < lDeme.size(); ++i) {
+		if(lDeme[i]->getFitness() != NULL)
+			lDeme[i]->getFitness()->setInvalid();
+	}
+	ioMaster.mContext->setGeneration(inGeneration);
+	try {
+		ioMaster.mEvalOp->operate(lDeme, *ioMaster.mContext);
+	} catch(Beagle::Exception& inError) {
+		return inError.getMessage();
+	}
+	return std::string();
+}
+
+//! Return the number of individuals whose fitness differs from the one computed by inWorkerEnd.
+static unsigned int checkFitness(TestSystem& inMaster, unsigned int inGeneration, unsigned int inWorkerEnd, int inNullIndex) {
+	unsigned int lNbWrong = 0;
+	Deme& lDeme = inMaster.getDeme();
+	for(unsigned int i = 0; i < lDeme.size(); ++i) {
+		float lExpected = int(i) == inNullIndex ? 0 : getExpectedFitness(i, i < inWorkerEnd);
+		float lValue = castHandleT<FitnessSimple>(lDeme[i]->getFitness())->getValue();
+		if(lValue != lExpected) {
+			cerr << "Generation " << inGeneration << ", individual " << i << ": fitness " << lValue << " instead of " << lExpected << endl;
+			++lNbWrong;
+		}
+	}
+	return lNbWrong;
+}
+
+int main(int argc, char** argv) {
+	unsigned int lPort = argc > 1 ? atoi(argv[1]) : 20000 + getpid()%20000;
+	unsigned int lNbFailures = 0;
+
+	//The workers are forked before the master runs any thread
+	WorkerProcess lFirstWorker = forkWorker(lPort);
+	WorkerProcess lSecondWorker = forkWorker(lPort);
+	try {
+		mkdir("bug", 0755);
+		TestSystem lMaster(std::string("-OBeval.farm.workers=127.0.0.1:")+uint2str(lPort)+",eval.farm.timeout=1");
+		std::vector<SimulationCase> lCases(scNbCases);
+		for(unsigned int c = 0; c < scNbCases; ++c)
+			lCases[c].addTargets(0, std::vector<double>(1, c+0.5));
+		lMaster.mEvalOp->setSimulationCases(lCases);
+
+		Deme& lDeme = lMaster.getDeme();
+		lDeme.resize(scNbIndividuals);
+		for(unsigned int i = 0; i < scNbIndividuals; ++i) {
+			GP::Individual::Handle lIndividual = castHandleT<GP::Individual>(lDeme[i]);
+			lIndividual->resize(1);
+			(*lIndividual)[0]->push_back(GP::Node(lMaster.mTerminal, 1));
+		}
+
+		//Setup and evaluation
+		if(!startWorker(lFirstWorker)) {
+			cerr << "The first worker didn't start" << endl;
+			return EXIT_FAILURE;
+		}
+		std::string lError = evaluateGeneration(lMaster, 0);
+		if(!lError.empty()) {
+			cerr << "Generation 0: " << lError << endl;
+			++lNbFailures;
+		} else {
+			lNbFailures += checkFitness(lMaster, 0, scNbIndividuals, -1);
+		}
+
+		//The exception of the worker is reported, the worker keeps serving
+		lError = evaluateGeneration(lMaster, 1);
+		if(lError.find(scErrorMessage) == std::string::npos) {
+			cerr << "Generation 1: the error of the worker was not reported" << endl;
+			++lNbFailures;
+		}
+
+		//Lost worker
+		lError = evaluateGeneration(lMaster, 2);
+		if(!lError.empty()) {
+			cerr << "Generation 2: " << lError << endl;
+			++lNbFailures;
+		} else {
+			lNbFailures += checkFitness(lMaster, 2, scCrashIndex, scCrashIndex);
+		}
+		int lStatus = stopWorker(lFirstWorker, false);
+		if(!WIFEXITED(lStatus) || WEXITSTATUS(lStatus) != EXIT_FAILURE) {
+			cerr << "The first worker didn't crash as expected" << endl;
+			++lNbFailures;
+		}
+		lMaster.mEvalOp->flushFiles();
+		std::string lCrashFile = std::string("bug/individual_crash_2_")+uint2str(scCrashIndex)+".xml";
+		if(remove(lCrashFile.c_str()) != 0) {
+			cerr << "The crashed individual was not written to " << lCrashFile << endl;
+			++lNbFailures;
+		}
+
+		//Request timeout, the master reconnects to the port at the next generation
+		if(!startWorker(lSecondWorker)) {
+			cerr << "The second worker didn't start" << endl;
+			return EXIT_FAILURE;
+		}
+		lError = evaluateGeneration(lMaster, 3);
+		if(!lError.empty()) {
+			cerr << "Generation 3: " << lError << endl;
+			++lNbFailures;
+		} else {
+			lNbFailures += checkFitness(lMaster, 3, scHangIndex, scHangIndex);
+		}
+		stopWorker(lSecondWorker, true);
+		lMaster.mEvalOp->flushFiles();
+		remove((std::string("bug/individual_crash_3_")+uint2str(scHangIndex)+".xml").c_str());
+	} catch(Beagle::Exception& inError) {
+		cerr << inError.getMessage() << endl;
+		++lNbFailures;
+	} catch(std::exception& inError) {
+		cerr << inError.what() << endl;
+		++lNbFailures;
+	}
+
+	cout << "Evaluation farm on port " << lPort << ", " << (lNbFailures == 0 ? "all the generations as expected" : "some generations are not as expected") << endl;
+	return lNbFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
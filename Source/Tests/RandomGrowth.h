@@ -0,0 +1,127 @@
+/*
+ *  RandomGrowth.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef RandomGrowth_H
+#define RandomGrowth_H
+
+#include <vector>
+#include "GrowingHybridBondGraph.h"
+
+/*! \brief Grow a bond graph with a random sequence of insertions
+ *  The same seed always gives the same bond graph, the growth can thus be repeated on two bond
+ *	graphs to compare the causality of each. The insertions are the ones done by the GP
+ *	primitives: junctions inserted on a bond and one-port components connected to a junction.
+ */
+class RandomGrowth {
+public:
+	explicit RandomGrowth(unsigned long inSeed) : mState(inSeed) { }
+
+	/*! \brief Build the embryo: an effort source driving an RLC circuit.
+	 *  \param  ioBondGraph Empty bond graph.
+	 *  \param  inAssignCausality Assign the causality of the embryo, the insertions then extend it.
+	 */
+	void buildEmbryo(GrowingHybridBondGraph& ioBondGraph, bool inAssignCausality) {
+		BG::Source* lSe = new BG::Source(BG::Source::eEffort);
+		lSe->setValue(1);
+		ioBondGraph.addComponent(lSe);
+		BG::Junction* lJ1 = new BG::Junction(BG::Junction::eOne);
+		ioBondGraph.addComponent(lJ1);
+		BG::Junction* lJ0 = new BG::Junction(BG::Junction::eZero);
+		ioBondGraph.addComponent(lJ0);
+		BG::Passive* lR1 = createPassive(BG::Passive::eResistor);
+		ioBondGraph.addComponent(lR1);
+		BG::Passive* lI = createPassive(BG::Passive::eInductor);
+		ioBondGraph.addComponent(lI);
+		BG::Passive* lC = createPassive(BG::Passive::eCapacitor);
+		ioBondGraph.addComponent(lC);
+		BG::Passive* lR2 = createPassive(BG::Passive::eResistor);
+		ioBondGraph.addComponent(lR2);
+
+		mJunctions.clear();
+		mBonds.clear();
+		mJunctions.push_back(lJ1);
+		mJunctions.push_back(lJ0);
+		mBonds.push_back(ioBondGraph.connect(lSe,lJ1));
+		mBonds.push_back(ioBondGraph.connect(lJ1,lR1));
+		mBonds.push_back(ioBondGraph.connect(lJ1,lI));
+		mBonds.push_back(ioBondGraph.connect(lJ1,lJ0));
+		mBonds.push_back(ioBondGraph.connect(lJ0,lC));
+		mBonds.push_back(ioBondGraph.connect(lJ0,lR2));
+
+		std::vector<BG::Bond*> lOutputBonds(1,mBonds[4]);
+		ioBondGraph.setOutputBonds(lOutputBonds,std::vector<BG::Bond*>(0));
+		ioBondGraph.postConnectionInitialization();
+		if(inAssignCausality)
+			ioBondGraph.assignCausality();
+	}
+
+	/*! \brief Apply random insertions to the bond graph
+	 *  \param  ioBondGraph Bond graph built by buildEmbryo.
+	 *  \param  inNbInsertions Number of insertions.
+	 */
+	void grow(GrowingHybridBondGraph& ioBondGraph, unsigned int inNbInsertions) {
+		for(unsigned int i = 0; i < inNbInsertions; ++i) {
+			BG::Bond* lNewBond = 0;
+			if(roll(3) == 0) {
+				BG::Junction* lJunction = new BG::Junction(roll(2) == 0 ? BG::Junction::eZero : BG::Junction::eOne);
+				ioBondGraph.insertJunction(mBonds[roll(mBonds.size())],lJunction,lNewBond);
+				mJunctions.push_back(lJunction);
+			} else {
+				BG::Component* lComponent = 0;
+				switch(roll(5)) {
+					case 0: lComponent = createPassive(BG::Passive::eResistor); break;
+					case 1: lComponent = createPassive(BG::Passive::eCapacitor); break;
+					case 2: lComponent = createPassive(BG::Passive::eInductor); break;
+					case 3: lComponent = createSource(true); break;
+					default: lComponent = createSource(false); break;
+				}
+				ioBondGraph.insertComponent(mJunctions[roll(mJunctions.size())],lComponent,lNewBond);
+			}
+			mBonds.push_back(lNewBond);
+		}
+	}
+
+protected:
+	//! Return a pseudo-random integer in [0,inMax[, the sequence only depends on the seed.
+	unsigned int roll(unsigned int inMax) {
+		mState = mState*1103515245UL + 12345UL;
+		return (unsigned int)((mState >> 16) % inMax);
+	}
+
+	BG::Passive* createPassive(BG::Passive::PassiveType inType) {
+		BG::Passive* lPassive = new BG::Passive(inType);
+		lPassive->setValue(1+roll(100));
+		return lPassive;
+	}
+
+	BG::Source* createSource(bool inEffort) {
+		BG::Source* lSource = new BG::Source(inEffort ? BG::Source::eEffort : BG::Source::eFlow);
+		lSource->setValue(1+roll(10));
+		return lSource;
+	}
+
+	unsigned long mState;					//!< State of the pseudo-random generator
+	std::vector<BG::Junction*> mJunctions;	//!< Junctions where the components can be connected
+	std::vector<BG::Bond*> mBonds;			//!< Bonds where the junctions can be inserted
+};
+
+#endif
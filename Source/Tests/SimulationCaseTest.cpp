@@ -0,0 +1,174 @@
+/*
+ *  SimulationCaseTest.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+/*
+ *  Check the binary simulation case files. Random cases, with and without parameters and with
+ *  breakpoints of different sizes, are written and read back, through a stream and through a
+ *  file read by readSimulationCase. The cases read must be identical, and the truncated or
+ *  foreign streams must be rejected.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include "SimulationCase.h"
+
+using namespace std;
+
+//! Pseudo-random generator, the sequence only depends on the seed.
+class CaseGenerator {
+public:
+	explicit CaseGenerator(unsigned long inSeed) : mState(inSeed) { }
+
+	//! Return an integer in [0,inMax[.
+	unsigned int roll(unsigned int inMax) {
+		mState = mState*1103515245UL + 12345UL;
+		return (unsigned int)((mState >> 16) % inMax);
+	}
+
+	//! Return a value in [inLow,inHigh[, with all the bits of the mantissa used.
+	double getValue(double inLow, double inHigh) {
+		double lValue = 0;
+		for(unsigned int i = 0; i < 4; ++i)
+			lValue = (lValue + roll(65536))/65536.;
+		return inLow + lValue*(inHigh-inLow);
+	}
+
+private:
+	unsigned long mState;
+};
+
+//! Return a case of inNbBreakpoints breakpoints, the sizes and values only depend on the seed.
+static SimulationCase makeCase(unsigned long inSeed, unsigned int inNbBreakpoints) {
+	CaseGenerator lGenerator(inSeed);
+	SimulationCase lCase;
+	double lTime = 0;
+	for(unsigned int i = 0; i < inNbBreakpoints; ++i) {
+		vector<double> lTargets(1+lGenerator.roll(4));
+		for(unsigned int j = 0; j < lTargets.size(); ++j)
+			lTargets[j] = lGenerator.getValue(-100, 100);
+		vector<double> lParameters(inSeed % 2 ? lGenerator.roll(4) : 0);
+		for(unsigned int j = 0; j < lParameters.size(); ++j)
+			lParameters[j] = lGenerator.getValue(0, 1);
+		lCase.addTargets(lTime, lTargets, lParameters);
+		lTime += lGenerator.getValue(0.001, 10);
+	}
+	return lCase;
+}
+
+//! Return true if the two cases have the same breakpoints, targets and parameters.
+static bool equalCases(const SimulationCase& inLeft, const SimulationCase& inRight) {
+	if(inLeft.getSize() != inRight.getSize())
+		return false;
+	for(unsigned int i = 0; i < inLeft.getSize(); ++i) {
+		if(inLeft.getTime(i) != inRight.getTime(i) ||
+		   inLeft.getTargets(i) != inRight.getTargets(i) ||
+		   inLeft.getParameters(i) != inRight.getParameters(i))
+			return false;
+	}
+	return true;
+}
+
+static bool equalCases(const vector<SimulationCase>& inLeft, const vector<SimulationCase>& inRight) {
+	if(inLeft.size() != inRight.size())
+		return false;
+	for(unsigned int i = 0; i < inLeft.size(); ++i) {
+		if(!equalCases(inLeft[i], inRight[i])) {
+			cerr << "Case " << i << " differs" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+//! Return true if readSimulationCases rejects the bytes.
+static bool isRejected(const string& inBytes) {
+	istringstream lStream(inBytes);
+	vector<SimulationCase> lCases;
+	try {
+		readSimulationCases(lStream, lCases);
+	} catch(std::runtime_error&) {
+		return true;
+	}
+	return false;
+}
+
+int main(int argc, char** argv) {
+	unsigned int lNbCases = argc > 1 ? atoi(argv[1]) : 100;
+	unsigned int lNbFailures = 0;
+
+	vector<SimulationCase> lCases;
+	for(unsigned int i = 0; i < lNbCases; ++i)
+		lCases.push_back(makeCase(i+1, 1+i%50));
+
+	ostringstream lOutput;
+	writeSimulationCases(lOutput, lCases);
+	string lBytes = lOutput.str();
+	istringstream lInput(lBytes);
+	vector<SimulationCase> lRead;
+	readSimulationCases(lInput, lRead);
+	if(!equalCases(lCases, lRead)) {
+		cerr << "The cases read from the stream differ from the cases written" << endl;
+		++lNbFailures;
+	}
+
+	//A case without breakpoint is written, it is only rejected by the validation
+	vector<SimulationCase> lEmpty(1);
+	ostringstream lEmptyOutput;
+	writeSimulationCases(lEmptyOutput, lEmpty);
+	istringstream lEmptyInput(lEmptyOutput.str());
+	readSimulationCases(lEmptyInput, lRead);
+	if(!equalCases(lEmpty, lRead)) {
+		cerr << "The empty case differs once read" << endl;
+		++lNbFailures;
+	}
+
+	const char* lFilename = "SimulationCaseTest.cases";
+	writeSimulationCaseFile(lFilename, lCases);
+	readSimulationCase(string("@")+lFilename, lRead);
+	remove(lFilename);
+	if(!equalCases(lCases, lRead)) {
+		cerr << "The cases read from the file differ from the cases written" << endl;
+		++lNbFailures;
+	}
+
+	for(unsigned int lEnd = 0; lEnd < lBytes.size(); lEnd += 1 + lEnd/8) {
+		if(!isRejected(lBytes.substr(0, lEnd))) {
+			cerr << "The stream cut at " << lEnd << " of " << lBytes.size() << " bytes was accepted" << endl;
+			++lNbFailures;
+			break;
+		}
+	}
+	string lForeign = lBytes;
+	lForeign[0] = 'X';
+	if(!isRejected(lForeign)) {
+		cerr << "A stream without the tag was accepted" << endl;
+		++lNbFailures;
+	}
+
+	cout << lNbCases << " cases, " << lBytes.size() << " bytes, "
+		 << (lNbFailures == 0 ? "all read back" : "some were not read back") << endl;
+	return lNbFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
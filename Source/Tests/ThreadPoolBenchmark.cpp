@@ -0,0 +1,212 @@
+/*
+ *  ThreadPoolBenchmark.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+/*
+ *  Compare PACC::Threading::ThreadPool, where each slave has its own queue and steals from the
+ *  others, with the previous pool where every slave takes its tasks from one shared queue under
+ *  the pool lock. The previous pool is reproduced below as SharedQueuePool. Each run pushes the
+ *  same tasks, short ones to measure the queue contention and ones whose cost spreads over four
+ *  orders of magnitude as the evaluations, and waits for all of them.
+ *
+ *  Usage: ThreadPoolBenchmark [tasks] [max threads]
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <queue>
+#include <vector>
+#include <PACC/Threading.hpp>
+#include <PACC/Util/Timer.hpp>
+
+using namespace std;
+
+//! Busy work of a task, the result is kept so the loop isn't optimized out.
+static double work(unsigned int inIterations) {
+	double lValue = 0;
+	for(unsigned int i = 0; i < inIterations; ++i)
+		lValue += 1.0/(1.0+i);
+	return lValue;
+}
+
+class SharedQueuePool;
+
+/*! \brief Task of the shared queue pool
+ *  Same flags and signaling as PACC::Threading::Task, whose flags can only be set by the
+ *	slaves of PACC::Threading::ThreadPool.
+ */
+class SharedQueueTask : public PACC::Threading::Condition {
+public:
+	SharedQueueTask() : mRunning(false), mCompleted(false), mResult(0), mIterations(0) {}
+	void reset() { lock(); mRunning = mCompleted = false; unlock(); }
+	void wait() { lock(); while(!mCompleted) PACC::Threading::Condition::wait(); unlock(); }
+	void main() { mResult = work(mIterations); }
+
+	bool mRunning;
+	bool mCompleted;
+	double mResult;
+	unsigned int mIterations;
+};
+
+//! Slave of the shared queue pool, as PACC::Threading::SlaveThread before the per-slave queues.
+class SharedQueueSlave : public PACC::Threading::Thread {
+public:
+	SharedQueueSlave(SharedQueuePool* inPool) : mPool(inPool) { run(); }
+	~SharedQueueSlave() { wait(true); }
+protected:
+	virtual void main();
+	SharedQueuePool* mPool;
+};
+
+//! Thread pool with one task queue under the pool lock, as PACC::Threading::ThreadPool before the per-slave queues.
+class SharedQueuePool : public std::vector<SharedQueueSlave*>, public PACC::Threading::Condition {
+public:
+	SharedQueuePool(unsigned int inSlaves) {
+		for(unsigned int i = 0; i < inSlaves; ++i)
+			push_back(new SharedQueueSlave(this));
+	}
+	~SharedQueuePool() {
+		lock();
+		while(!mTasks.empty()) {
+			SharedQueueTask* lTask = mTasks.back();
+			lTask->lock();
+			unlock();
+			while(!lTask->mRunning && !lTask->mCompleted) lTask->PACC::Threading::Condition::wait();
+			lTask->unlock();
+			lock();
+		}
+		for(unsigned int i = 0; i < size(); ++i) (*this)[i]->cancel();
+		broadcast();
+		unlock();
+		for(unsigned int i = 0; i < size(); ++i) delete (*this)[i];
+	}
+	void push(SharedQueueTask& inTask) {
+		inTask.reset();
+		lock();
+		mTasks.push(&inTask);
+		signal();
+		unlock();
+	}
+
+	std::queue<SharedQueueTask*> mTasks;
+};
+
+void SharedQueueSlave::main() {
+	while(!mCancel) {
+		mPool->lock();
+		while(mPool->mTasks.empty() && !mCancel) mPool->wait();
+		if(!mCancel) {
+			SharedQueueTask* lTask = mPool->mTasks.front();
+			mPool->mTasks.pop();
+			mPool->unlock();
+			lTask->lock();
+			lTask->mRunning = true;
+			lTask->broadcast();
+			lTask->unlock();
+			lTask->main();
+			lTask->lock();
+			lTask->mRunning = false;
+			lTask->mCompleted = true;
+			lTask->broadcast();
+			lTask->unlock();
+		}
+		else mPool->unlock();
+	}
+}
+
+//! Task of PACC::Threading::ThreadPool doing the same work.
+class WorkTask : public PACC::Threading::Task {
+public:
+	WorkTask() : mResult(0), mIterations(0) {}
+	virtual void main() { mResult = work(mIterations); }
+	double mResult;
+	unsigned int mIterations;
+};
+
+//! Return the number of iterations of each task, the same sequence for both pools.
+static vector<unsigned int> makeCosts(unsigned int inNbTasks, bool inSpread) {
+	vector<unsigned int> lCosts(inNbTasks);
+	unsigned long lState = 1;
+	for(unsigned int i = 0; i < inNbTasks; ++i) {
+		lState = lState*1103515245UL + 12345UL;
+		if(inSpread) {
+			//10 to 100000 iterations, uniform in the logarithm
+			unsigned int lDecade = (lState >> 16) % 4;
+			unsigned int lCost = 10;
+			for(unsigned int d = 0; d < lDecade; ++d) lCost *= 10;
+			lCosts[i] = lCost + (unsigned int)((lState >> 8) % (9*lCost));
+		} else {
+			lCosts[i] = 10;
+		}
+	}
+	return lCosts;
+}
+
+//! Run the tasks on the current pool, return the time in seconds.
+static double runCurrent(unsigned int inNbThreads, const vector<unsigned int>& inCosts) {
+	vector<WorkTask> lTasks(inCosts.size());
+	PACC::Timer lTimer;
+	{
+		PACC::Threading::ThreadPool lPool(inNbThreads);
+		for(unsigned int i = 0; i < lTasks.size(); ++i) {
+			lTasks[i].mIterations = inCosts[i];
+			lPool.push(lTasks[i]);
+		}
+		for(unsigned int i = 0; i < lTasks.size(); ++i)
+			lTasks[i].wait();
+	}
+	return lTimer.getValue();
+}
+
+//! Run the tasks on the shared queue pool, return the time in seconds.
+static double runSharedQueue(unsigned int inNbThreads, const vector<unsigned int>& inCosts) {
+	vector<SharedQueueTask> lTasks(inCosts.size());
+	PACC::Timer lTimer;
+	{
+		SharedQueuePool lPool(inNbThreads);
+		for(unsigned int i = 0; i < lTasks.size(); ++i) {
+			lTasks[i].mIterations = inCosts[i];
+			lPool.push(lTasks[i]);
+		}
+		for(unsigned int i = 0; i < lTasks.size(); ++i)
+			lTasks[i].wait();
+	}
+	return lTimer.getValue();
+}
+
+int main(int argc, char** argv) {
+	unsigned int lNbTasks = argc > 1 ? atoi(argv[1]) : 20000;
+	unsigned int lMaxThreads = argc > 2 ? atoi(argv[2]) : 64;
+
+	for(int lSpread = 0; lSpread < 2; ++lSpread) {
+		vector<unsigned int> lCosts = makeCosts(lNbTasks, lSpread == 1);
+		cout << (lSpread ? "Spread tasks" : "Short tasks") << ", " << lNbTasks << " tasks, thousands of tasks per second" << endl;
+		cout << setw(8) << "threads" << setw(14) << "shared queue" << setw(14) << "per slave" << endl;
+		for(unsigned int lNbThreads = 1; lNbThreads <= lMaxThreads; lNbThreads *= 2) {
+			double lShared = runSharedQueue(lNbThreads, lCosts);
+			double lCurrent = runCurrent(lNbThreads, lCosts);
+			cout << setw(8) << lNbThreads << fixed << setprecision(1)
+				 << setw(14) << lNbTasks/lShared/1000 << setw(14) << lNbTasks/lCurrent/1000 << endl;
+		}
+	}
+	return EXIT_SUCCESS;
+}
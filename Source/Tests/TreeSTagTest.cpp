@@ -0,0 +1,207 @@
+/*
+ *  TreeSTagTest.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+/*
+ *  Check the preorder encoding of TreeSTag and the removal of the NOP. Random trees are built
+ *  from a recursive description, which gives the expected depth, subtree size and ephemeral
+ *  slot of each node, and the expected tree once its NOP are removed. The encoding must also be
+ *  rebuilt when a node of the tree is changed in place.
+ *
+ *  Usage: TreeSTagTest [trees]
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "TreeSTag.h"
+
+using namespace std;
+
+//! Primitive only known by its name and number of arguments, it is never executed.
+class NamedPrimitive : public Beagle::GP::Primitive {
+public:
+	NamedPrimitive(unsigned int inN, std::string inName) : Beagle::GP::Primitive(inN, inName) {}
+	virtual void execute(Beagle::GP::Datum& outDatum, Beagle::GP::Context& ioContext) {}
+};
+
+//! Tree giving access to the NOP removal, TreeSTag::removeNOP calls it on the tree of an individual.
+class TestTree : public TreeSTag {
+public:
+	void removeNOPs() { removeNOPNodes(); }
+};
+
+//! Node of the recursive description of a tree.
+struct DescribedNode {
+	Beagle::GP::Primitive::Handle mPrimitive;
+	std::vector<DescribedNode> mChildren;
+};
+
+/*! \brief Build random trees from the primitives of the bond graph trees
+ *  The same seed always gives the same tree.
+ */
+class RandomTree {
+public:
+	explicit RandomTree(unsigned long inSeed) : mState(inSeed) {
+		mPrimitives.push_back(new NamedPrimitive(2, "ADD"));
+		mPrimitives.push_back(new NamedPrimitive(2, "SUB"));
+		mPrimitives.push_back(new NamedPrimitive(1, "NOP"));
+		mPrimitives.push_back(new NamedPrimitive(0, "E"));
+		mPrimitives.push_back(new NamedPrimitive(0, "X"));
+	}
+
+	//! Return a random tree of at most inMaxDepth levels.
+	DescribedNode build(unsigned int inMaxDepth) {
+		DescribedNode lNode;
+		lNode.mPrimitive = mPrimitives[inMaxDepth > 1 ? roll(mPrimitives.size()) : 3+roll(2)];
+		for(unsigned int i = 0; i < lNode.mPrimitive->getNumberArguments(); ++i)
+			lNode.mChildren.push_back(build(inMaxDepth-1));
+		return lNode;
+	}
+
+	//! Return the primitive of the same number of arguments as inPrimitive and of another name.
+	Beagle::GP::Primitive::Handle getOther(Beagle::GP::Primitive::Handle inPrimitive) const {
+		for(unsigned int i = 0; i < mPrimitives.size(); ++i) {
+			if(mPrimitives[i]->getNumberArguments() == inPrimitive->getNumberArguments() && mPrimitives[i]->getName() != inPrimitive->getName())
+				return mPrimitives[i];
+		}
+		return inPrimitive;
+	}
+
+	//! Return a pseudo-random integer in [0,inMax[, the sequence only depends on the seed.
+	unsigned int roll(unsigned int inMax) {
+		mState = mState*1103515245UL + 12345UL;
+		return (unsigned int)((mState >> 16) % inMax);
+	}
+
+protected:
+	unsigned long mState;
+	std::vector<Beagle::GP::Primitive::Handle> mPrimitives;
+};
+
+/*! \brief Append a described tree to a GP tree and to its expected encoding, in preorder
+ *  \param  inNode Root of the described subtree.
+ *  \param  inDepth Depth of inNode.
+ *  \param  inSkipNOP Leave out the NOP, their argument takes their place.
+ *  \param  ioTree Tree to append the nodes to.
+ *  \param  ioEncoding Expected encoding of the nodes.
+ *  \param  ioNbParameters Number of ephemeral constants appended so far.
+ *  \return Size of the appended subtree.
+ */
+static unsigned int append(const DescribedNode& inNode, unsigned int inDepth, bool inSkipNOP, TreeSTag& ioTree,
+						   std::vector<TreeSTag::FlatNode>& ioEncoding, unsigned int& ioNbParameters) {
+	if(inSkipNOP && inNode.mPrimitive->getName() == "NOP")
+		return append(inNode.mChildren[0], inDepth, inSkipNOP, ioTree, ioEncoding, ioNbParameters);
+
+	unsigned int lIndex = ioTree.size();
+	ioTree.push_back(Beagle::GP::Node(inNode.mPrimitive, 0));
+	TreeSTag::FlatNode lFlatNode;
+	lFlatNode.mPrimitiveID = TreeSTag::getPrimitiveID(inNode.mPrimitive->getName());
+	lFlatNode.mDepth = inDepth;
+	lFlatNode.mParameterSlot = inNode.mPrimitive->getName() == "E" ? int(ioNbParameters++) : -1;
+	ioEncoding.push_back(lFlatNode);
+
+	unsigned int lSize = 1;
+	for(unsigned int i = 0; i < inNode.mChildren.size(); ++i)
+		lSize += append(inNode.mChildren[i], inDepth+1, inSkipNOP, ioTree, ioEncoding, ioNbParameters);
+	ioTree[lIndex].mSubTreeSize = lSize;
+	ioEncoding[lIndex].mSubTreeSize = lSize;
+	return lSize;
+}
+
+//! Return true if the encoding of the tree is the expected one.
+static bool checkEncoding(const TreeSTag& inTree, const std::vector<TreeSTag::FlatNode>& inExpected, unsigned int inNbParameters) {
+	const std::vector<TreeSTag::FlatNode>& lEncoding = inTree.getFlatEncoding();
+	if(lEncoding.size() != inExpected.size() || inTree.getNumberParameters() != inNbParameters)
+		return false;
+	for(unsigned int i = 0; i < lEncoding.size(); ++i) {
+		if(lEncoding[i].mPrimitiveID != inExpected[i].mPrimitiveID || lEncoding[i].mSubTreeSize != inExpected[i].mSubTreeSize ||
+		   lEncoding[i].mDepth != inExpected[i].mDepth || lEncoding[i].mParameterSlot != inExpected[i].mParameterSlot)
+			return false;
+	}
+	return true;
+}
+
+//! Return true if the two trees have the same primitives and subtree sizes.
+static bool equalTrees(const TreeSTag& inLeft, const TreeSTag& inRight) {
+	if(inLeft.size() != inRight.size())
+		return false;
+	for(unsigned int i = 0; i < inLeft.size(); ++i) {
+		if(inLeft[i].mPrimitive != inRight[i].mPrimitive || inLeft[i].mSubTreeSize != inRight[i].mSubTreeSize)
+			return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	unsigned int lNbTrees = argc > 1 ? atoi(argv[1]) : 1000;
+	unsigned int lNbFailures = 0;
+	unsigned int lNbNOPTrees = 0;
+
+	for(unsigned int t = 0; t < lNbTrees; ++t) {
+		RandomTree lGenerator(t+1);
+		DescribedNode lRoot = lGenerator.build(1+t%8);
+
+		TestTree lTree;
+		std::vector<TreeSTag::FlatNode> lExpected;
+		unsigned int lNbParameters = 0;
+		append(lRoot, 1, false, lTree, lExpected, lNbParameters);
+		if(!checkEncoding(lTree, lExpected, lNbParameters)) {
+			cerr << "Tree " << t+1 << ": wrong preorder encoding" << endl;
+			++lNbFailures;
+			continue;
+		}
+
+		//The encoding follows a change of a node in place
+		unsigned int lChanged = lGenerator.roll(lTree.size());
+		Beagle::GP::Primitive::Handle lOriginal = lTree[lChanged].mPrimitive;
+		Beagle::GP::Primitive::Handle lOther = lGenerator.getOther(lOriginal);
+		lTree[lChanged].mPrimitive = lOther;
+		lExpected[lChanged].mPrimitiveID = TreeSTag::getPrimitiveID(lOther->getName());
+		lNbParameters = 0;
+		for(unsigned int i = 0; i < lExpected.size(); ++i) {
+			bool lIsParameter = lTree[i].mPrimitive->getName() == "E";
+			lExpected[i].mParameterSlot = lIsParameter ? int(lNbParameters++) : -1;
+		}
+		if(!checkEncoding(lTree, lExpected, lNbParameters)) {
+			cerr << "Tree " << t+1 << ": the encoding wasn't rebuilt after the change of node " << lChanged << endl;
+			++lNbFailures;
+			continue;
+		}
+		lTree[lChanged].mPrimitive = lOriginal;
+
+		//Without its NOP, the tree is the one described without them
+		TestTree lWithoutNOP;
+		std::vector<TreeSTag::FlatNode> lExpectedWithoutNOP;
+		lNbParameters = 0;
+		append(lRoot, 1, true, lWithoutNOP, lExpectedWithoutNOP, lNbParameters);
+		if(lWithoutNOP.size() != lTree.size())
+			++lNbNOPTrees;
+		lTree.removeNOPs();
+		if(!equalTrees(lTree, lWithoutNOP) || !checkEncoding(lTree, lExpectedWithoutNOP, lNbParameters) || !lTree.compareTopology(lWithoutNOP)) {
+			cerr << "Tree " << t+1 << ": the tree without its NOP differs from the expected one" << endl;
+			++lNbFailures;
+		}
+	}
+
+	cout << lNbTrees << " trees, " << lNbNOPTrees << " with NOP, " << lNbFailures << " failures" << endl;
+	return lNbFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,177 @@
+/*
+ *  XMLParserTest.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+/*
+ *  Check the streaming XML parser used to read the checkpoints. A small document is read with the
+ *  parser and with PACC::XML::Document and both must agree. A large document, generated while it
+ *  is read, is then parsed individual by individual: the memory used must stay far under the size
+ *  of the document, which the DOM would need several times.
+ *
+ *  Usage: XMLParserTest [individuals]
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <sys/resource.h>
+#include <PACC/XML.hpp>
+
+using namespace std;
+
+//! Return the text of an individual of the generated documents.
+static string makeIndividual(unsigned int inIndex) {
+	ostringstream lStream;
+	lStream << "<Individual size=\"1\"><Fitness type=\"LogFitness\"><Obj>" << inIndex << "</Obj></Fitness>"
+			<< "<Genotype type=\"gptree\" size=\"3\"><Root><Add/><Value>" << inIndex*2 << "</Value></Root></Genotype>"
+			<< "<!-- padding padding padding padding padding padding padding padding --></Individual>";
+	return lStream.str();
+}
+
+/*! \brief Stream buffer generating a migration buffer of inNbIndividuals individuals
+ *  The document is produced as it is read, it is never held in memory.
+ */
+class GeneratedDocument : public streambuf {
+public:
+	explicit GeneratedDocument(unsigned int inNbIndividuals) : mNbIndividuals(inNbIndividuals), mNext(0), mSize(0) {
+		mBuffer = "<?xml version=\"1.0\"?>\n<MigrationBuffer>";
+		setg(&mBuffer[0], &mBuffer[0], &mBuffer[0]+mBuffer.size());
+	}
+
+	//! Return the number of characters generated so far.
+	unsigned long getSize() const { return mSize + (gptr() - eback()); }
+
+protected:
+	virtual int_type underflow() {
+		if(gptr() < egptr())
+			return traits_type::to_int_type(*gptr());
+		mSize += egptr() - eback();
+		if(mNext < mNbIndividuals) {
+			mBuffer = makeIndividual(mNext++);
+		} else if(mNext == mNbIndividuals) {
+			mBuffer = "</MigrationBuffer>\n";
+			++mNext;
+		} else {
+			return traits_type::eof();
+		}
+		setg(&mBuffer[0], &mBuffer[0], &mBuffer[0]+mBuffer.size());
+		return traits_type::to_int_type(*gptr());
+	}
+
+	unsigned int mNbIndividuals;
+	unsigned int mNext;
+	unsigned long mSize;
+	string mBuffer;
+};
+
+//! Return the maximum resident memory of the process in kB.
+static long getMaxResident() {
+	struct rusage lUsage;
+	getrusage(RUSAGE_SELF, &lUsage);
+	return lUsage.ru_maxrss;
+}
+
+/*! \brief Read the individuals of a migration buffer with the streaming parser
+ *  \param  ioStream Document to read.
+ *  \param  outSum Sum of the fitness of the individuals.
+ *  \return Number of individuals read.
+ */
+static unsigned int readIndividuals(istream& ioStream, double& outSum) {
+	PACC::XML::Parser lParser(ioStream);
+	unsigned int lNbIndividuals = 0;
+	outSum = 0;
+	while(lParser.next() != PACC::XML::Parser::eEndOfDocument) {
+		if(lParser.getEvent() != PACC::XML::Parser::eStartTag || lParser.getName() != "Individual")
+			continue;
+		PACC::XML::Subtree lIndividual(lParser.readSubtree());
+		PACC::XML::ConstIterator lFitness = lIndividual.getRoot()->getFirstChild();
+		if(!lFitness || lFitness->getValue() != "Fitness" || lFitness->getAttribute("type") != "LogFitness")
+			throw runtime_error("invalid <Fitness> tag");
+		outSum += atof(lFitness->getFirstChild()->getFirstChild()->getValue().c_str());
+		++lNbIndividuals;
+	}
+	return lNbIndividuals;
+}
+
+//! Compare the parser events of a small document with its DOM.
+static bool checkSmallDocument() {
+	string lText = "<?xml version=\"1.0\"?>\n<MigrationBuffer>";
+	for(unsigned int i = 0; i < 10; ++i)
+		lText += makeIndividual(i);
+	lText += "<Empty/></MigrationBuffer>\n";
+
+	istringstream lDocumentStream(lText);
+	PACC::XML::Document lDocument(lDocumentStream);
+	PACC::XML::ConstIterator lRoot = lDocument.getFirstDataTag();
+
+	istringstream lParserStream(lText);
+	PACC::XML::Parser lParser(lParserStream);
+	while(lParser.next() != PACC::XML::Parser::eStartTag) { }
+	if(lParser.getName() != lRoot->getValue())
+		return false;
+	PACC::XML::ConstIterator lChild = lRoot->getFirstChild();
+	for(PACC::XML::Parser::Event lEvent = lParser.next(); lEvent != PACC::XML::Parser::eEndTag; lEvent = lParser.next(), ++lChild) {
+		if(lEvent != PACC::XML::Parser::eStartTag || !lChild)
+			return false;
+		PACC::XML::Subtree lSubtree(lParser.readSubtree());
+		ostringstream lExpected, lRead;
+		PACC::XML::Streamer lExpectedStreamer(lExpected), lReadStreamer(lRead);
+		lChild->serialize(lExpectedStreamer);
+		lSubtree.getRoot()->serialize(lReadStreamer);
+		if(lExpected.str() != lRead.str()) {
+			cerr << "Subtree " << lRead.str() << " differs from " << lExpected.str() << endl;
+			return false;
+		}
+	}
+	return !lChild && lParser.next() == PACC::XML::Parser::eEndOfDocument;
+}
+
+int main(int argc, char** argv) {
+	unsigned int lNbIndividuals = argc > 1 ? atoi(argv[1]) : 400000;
+
+	if(!checkSmallDocument()) {
+		cerr << "The parser and the document disagree on the small document" << endl;
+		return EXIT_FAILURE;
+	}
+
+	long lResidentBefore = getMaxResident();
+	GeneratedDocument lBuffer(lNbIndividuals);
+	istream lStream(&lBuffer);
+	double lSum;
+	unsigned int lNbRead = readIndividuals(lStream, lSum);
+	long lResidentGrowth = getMaxResident() - lResidentBefore;
+
+	double lExpectedSum = 0.5*double(lNbIndividuals)*(lNbIndividuals-1);
+	unsigned long lDocumentSize = lBuffer.getSize()/1024;
+	cout << lNbRead << " individuals read from a document of " << lDocumentSize << " kB, the resident memory grew by "
+		 << lResidentGrowth << " kB" << endl;
+	if(lNbRead != lNbIndividuals || lSum != lExpectedSum) {
+		cerr << "Expected " << lNbIndividuals << " individuals of fitness sum " << lExpectedSum << endl;
+		return EXIT_FAILURE;
+	}
+	if(lResidentGrowth > 8*1024 && lResidentGrowth*4 > long(lDocumentSize)) {
+		cerr << "The memory grew with the document, it was built" << endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
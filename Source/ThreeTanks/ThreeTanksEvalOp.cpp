@@ -31,7 +31,6 @@
 #include <cfloat>
 #include "ThreeTanksLookaheadController.h"
 #include "BGException.h"
-#include "ParametersHolder.h"
 
 using namespace Beagle;
 using namespace BG;
@@ -78,7 +77,18 @@ using namespace BG;
 
 ThreeTanksEvalOp::ThreeTanksEvalOp(std::string inName) : BondGraphEvalOp(inName)
 { 
+	mIndividualCounter = 0;
 	
+	//Signals used by the error computation and kept in the fitness log
+	mTimeSignal = mSignals.add("time");
+	for(unsigned int k = 0; k < NBOUTPUTS; ++k) {
+		mOutputSignals.push_back(mSignals.add(std::string("Output_")+int2str(k)));
+		mTargetSignals.push_back(mSignals.add(std::string("Target_")+int2str(k)));
+	}
+	const char* lKeptSignals[] = {"Output_0","Output_1","Output_2","Target_0","Target_1","Target_2","State","time","S1","S2"};
+	for(unsigned int k = 0; k < sizeof(lKeptSignals)/sizeof(lKeptSignals[0]); ++k) {
+		mKeptSignals.push_back(mSignals.add(lKeptSignals[k]));
+	}
 }
 
 ThreeTanksEvalOp::~ThreeTanksEvalOp() {
@@ -183,7 +193,7 @@ ThreeTanksEvalOp::~ThreeTanksEvalOp() {
 //					for(unsigned int i = 0; i < mSimulationCases[g].getSize(); ++i) {
 //						if( mSimulationCases[g].getTime(i) >= mSimulationDuration->getWrappedValue() )
 //							throw Beagle_RunTimeExceptionM("ThreeTanksEvalOp : Applying control target later than simulation end");
-//						if(mSimulationCases[g].getTargets(i).size() != NBTANKS)
+//						if(mSimulationCases[g].getNbTargets(i) != NBTANKS)
 //							throw Beagle_RunTimeExceptionM("ThreeTanksEvalOp : There should be a target tripple for each control time");
 //						
 //						lController->setTarget(mSimulationCases[g].getTargets(i));
@@ -333,35 +343,29 @@ Beagle::Fitness::Handle ThreeTanksEvalOp::evaluate(Beagle::GP::Individual& inInd
 	BGFitness *lFitness = new BGFitness(-1);
 	GrowingHybridBondGraph::Handle lBondGraph;
 	TreeSTag::Handle lTree = castHandleT<TreeSTag>(inIndividual[0]);
-	
+	std::string lCacheKey;
 	
 	
 	try {
-//		//Get the parameters
-//		Beagle::Component::Handle lHolderComponent = ioContext.getSystem().getComponent("ParametersHolder");
-//		if(lHolderComponent==NULL)
-//			throw Beagle_RunTimeExceptionM("No ParameterHolder holder component found in the system!");
-//		ParametersHolder::Handle lHolder = castHandleT<ParametersHolder>(lHolderComponent);
-//		if(lHolder==NULL)
-//			throw Beagle_RunTimeExceptionM("Component named \"ParameterHolder\" found is not of the good type!");
-//		lHolder->clear();
+		//Release the previous bond graph and reuse its memory for this one
+		BGContext& lContext = castObjectT<BGContext&>(ioContext);
+		lContext.setBondGraph(NULL);
+		lContext.getComponentArena().reset();
 		
 		//Run the individual to create the bond graph.
 		RootReturn lResult;
 		inIndividual.run(lResult, ioContext);
-		BGContext& lContext = castObjectT<BGContext&>(ioContext);
 		lBondGraph = castHandleT<GrowingHybridBondGraph>(lContext.getBondGraph());
 		
-		GrowingHybridBondGraph::Handle lSaveNonSimplifiedBondGraph = new GrowingHybridBondGraph;
-		*lSaveNonSimplifiedBondGraph = *lBondGraph;
-		lFitness->setBondGraph(lSaveNonSimplifiedBondGraph);	
+		//Keep the bond graph before its simplification
+		lFitness->setBondGraphSnapshot(*lBondGraph);
 		
-		Beagle_LogDebugM(
+		BondGraph_LogSafeM(Beagle_LogDebugM(
 						 ioContext.getSystem().getLogger(),
 						 "evaluation", "ThreeTanksEvalOp",
 						 std::string("Evaluating bondgrap: ")+
 						 lBondGraph->BondGraph::serialize()
-						 );
+						 ));
 		
 #ifdef DEBUG
 		ofstream lFilestream("Bondgraph_ns.xml");
@@ -383,12 +387,12 @@ Beagle::Fitness::Handle ThreeTanksEvalOp::evaluate(Beagle::GP::Individual& inInd
 		/*//////////////////
 		
 		
-		Beagle_LogDebugM(
+		BondGraph_LogSafeM(Beagle_LogDebugM(
 						 ioContext.getSystem().getLogger(),
 						 "evaluation", "DCDCBoostEvalOp",
 						 std::string("Evaluating simplified bondgrap: ")+
 						 lBondGraph->BondGraph::serialize()
-						 );
+						 ));
 #ifdef DEBUG
 		lBondGraph->plotGraph("BondGraph.svg");
 		ofstream lFilestream2("Bondgraph.xml");
@@ -404,6 +408,25 @@ Beagle::Fitness::Handle ThreeTanksEvalOp::evaluate(Beagle::GP::Individual& inInd
 			return lFitness;
 		}
 		
+		//Reuse the fitness of an identical bond graph already simulated on the same cases
+		if(mFitnessCache.getCapacity() > 0) {
+			std::ostringstream lCases;
+			for(int g = mSimulationCases.size()-1; g >= 0; --g) {
+				if( ((*mGenerationSteps)[0] < 0) || (ioContext.getGeneration() >= (*mGenerationSteps)[g]) )
+					lCases << g << ",";
+			}
+			lCacheKey = getFitnessCacheKey(*lBondGraph, lCases.str());
+			if(mFitnessCache.lookup(lCacheKey, *lFitness)) {
+				BondGraph_LogSafeM(Beagle_LogDebugM(
+								 ioContext.getSystem().getLogger(),
+								 "evaluation", "ThreeTanksEvalOp",
+								 std::string("Fitness found in the cache: ")+
+								 dbl2str(lFitness->getValue())
+								 ));
+				return lFitness;
+			}
+		}
+		
 		//Evaluate the bond graph
 		//Initialize the simulation
 		std::map<std::string, std::vector<double> > &lLogger = lBondGraph->getSimulationLog();
@@ -415,6 +438,9 @@ Beagle::Fitness::Handle ThreeTanksEvalOp::evaluate(Beagle::GP::Individual& inInd
 		}
 		
 		try {
+			//The other threads can run Beagle code during the simulation, which only uses the
+			//bond graph, the controller and the parameters of this context
+			BeagleLock::Release lBeagleRelease;
 			double g = 9.81;
 			double lFluidDensity = 998.2;
 			std::vector<double> lInitialLevels(mTanksLevelsIni->size());
@@ -425,7 +451,18 @@ Beagle::Fitness::Handle ThreeTanksEvalOp::evaluate(Beagle::GP::Individual& inInd
 			//Simulate every target prior to this generation
 			vector<double> lFitnessVector;
 			unsigned int lTry = 0;
+			unsigned int lNbCases = 0;
 			for(int g = mSimulationCases.size()-1; g >= 0; --g) {
+				if( ((*mGenerationSteps)[0] < 0) || (ioContext.getGeneration() >= (*mGenerationSteps)[g]) )
+					++lNbCases;
+			}
+			double lFitnessSum = 0;
+			bool lAborted = false;
+			
+			//The signals logged by the previous case are preallocated for the next one
+			std::vector<unsigned int> lLoggedSignals;
+			unsigned int lNbLogRows = (unsigned int)(mSimulationDuration->getWrappedValue()/mContinuousTimeStep->getWrappedValue()) + 2;
+			for(int g = mSimulationCases.size()-1; g >= 0 && !lAborted; --g) {
 				bool lRun = false;
 				if( (*mGenerationSteps)[0] < 0 )
 					lRun = true;
@@ -440,13 +477,13 @@ Beagle::Fitness::Handle ThreeTanksEvalOp::evaluate(Beagle::GP::Individual& inInd
 						
 						if( mSimulationCases[g].getTime(i) >= mSimulationDuration->getWrappedValue() )
 							throw Beagle_RunTimeExceptionM("ThreeTanksEvalOp : Applying control target later than simulation end");
-						if(mSimulationCases[g].getTargets(i).size() != NBOUTPUTS)
+						if(mSimulationCases[g].getNbTargets(i) != NBOUTPUTS)
 							throw Beagle_RunTimeExceptionM("ThreeTanksEvalOp : There should be 1 target value for each control time");
-//						if(mSimulationCases[g].getParameters(i).size() != NBPARAMETERS)
+//						if(mSimulationCases[g].getNbParameters(i) != NBPARAMETERS)
 //							throw Beagle_RunTimeExceptionM("ThreeTanksEvalOp : There should be 1 parameter value for each control time");
 //						
 //						//Assign parameters
-//						const vector<double>& lParameters = mSimulationCases[g].getParameters(i);
+//						vector<double> lParameters = mSimulationCases[g].getParameters(i);
 //						if(!lParameters.empty()) {
 //							lBondGraph->clearStateMatrix();
 //						}
@@ -460,23 +497,15 @@ Beagle::Fitness::Handle ThreeTanksEvalOp::evaluate(Beagle::GP::Individual& inInd
 						lController->setTarget(lTargets);
 						
 						if(i == 0) {
-							//Find a valid initial state
-							unsigned int lInitialSwitchState = 0;
-							double lMaxConfiguration = pow(2.0,int(lBondGraph->getSwitches().size()));
-							for(;lInitialSwitchState < lMaxConfiguration; ++lInitialSwitchState) { 
-								try{ 
-									lController->initialize(&(*lBondGraph),lInitialSwitchState,lInitialLevels);
-								} catch(BG::CausalityException inError) {
-									continue;
-								} 
-								
-								break;
-							}
+							//Find a valid initial state, the configurations with a conflicting causality are
+							//remembered by the controller from one case to the other
+							int lInitialSwitchState = lController->findInitialState(&(*lBondGraph),lInitialLevels);
 							
 							//Check if a valid initial state have been found
-							if(lInitialSwitchState == lMaxConfiguration) {
+							if(lInitialSwitchState < 0) {
 								if(mAllowDifferentialCausality->getWrappedValue() == 2) {
 									lBondGraph->setDifferentialCausalitySupport(true);
+									lController->clearCausalityTable();
 									lInitialSwitchState = 0;
 								} else {
 									lSimulationRan = false;
@@ -487,6 +516,7 @@ Beagle::Fitness::Handle ThreeTanksEvalOp::evaluate(Beagle::GP::Individual& inInd
 							
 							//Reset the bond graph
 							lLogger.clear();
+							SimulationLog::reserve(lLogger,mSignals,lLoggedSignals,lNbLogRows);
 							lBondGraph->reset();
 						}
 						
@@ -503,26 +533,15 @@ Beagle::Fitness::Handle ThreeTanksEvalOp::evaluate(Beagle::GP::Individual& inInd
 					
 					//Evaluate the results
 					if(lSimulationRan) {
-						lF = computeError(&(*lBondGraph),lLogger);
-						
-						
+						SimulationLog lLogView(lLogger,mSignals);
+						lF = computeError(&(*lBondGraph),lLogView);
 						
 						//Clean logger
-						for(map<std::string, vector<double> >::iterator lIter = lLogger.begin(); lIter != lLogger.end();) {
-							if(lIter->first != "Output_0" &&
-							   lIter->first != "Output_1" &&
-							   lIter->first != "Output_2" &&
-							   lIter->first != "Target_0" &&
-							   lIter->first != "Target_1" &&
-							   lIter->first != "Target_2" &&
-							   lIter->first != "State" &&
-							   lIter->first != "time" &&
-							   lIter->first != "S1" &&
-							   lIter->first != "S2") {
-								lLogger.erase(lIter++);
-							} else {
-								++lIter;		
-							}
+						lLogView.retain(mKeptSignals);
+						lLoggedSignals.clear();
+						for(unsigned int k = 0; k < mKeptSignals.size(); ++k) {
+							if(lLogView.hasColumn(mKeptSignals[k]))
+								lLoggedSignals.push_back(mKeptSignals[k]);
 						}
 						//lBondGraph->writeSimulationLog(std::string("DCDCBoost_Lookahead_")+uint2str(g)+std::string(".csv"));
 					} else {
@@ -536,6 +555,19 @@ Beagle::Fitness::Handle ThreeTanksEvalOp::evaluate(Beagle::GP::Individual& inInd
 						lFitness->addData(lIter->first, lIter->second,lTry);
 					}
 					++lTry;
+					
+					//Stop when the remaining cases can't bring the fitness over the racing threshold
+					lFitnessSum += lF;
+					if(isHopeless(lFitnessSum, lFitnessVector.size(), lNbCases)) {
+						lAborted = true;
+						lCacheKey.clear();
+						BondGraph_LogSafeM(Beagle_LogDebugM(
+										 ioContext.getSystem().getLogger(),
+										 "evaluation", "ThreeTanksEvalOp",
+										 std::string("Evaluation stopped by racing after ")+uint2str(lFitnessVector.size())+
+										 std::string(" of ")+uint2str(lNbCases)+std::string(" cases")
+										 ));
+					}
 				}
 			}
 			
@@ -544,8 +576,11 @@ Beagle::Fitness::Handle ThreeTanksEvalOp::evaluate(Beagle::GP::Individual& inInd
 			for(unsigned int i = 0; i < lFitnessVector.size(); ++i) {
 				lAvg += lFitnessVector[i];
 			}
-			lAvg = lAvg/lFitnessVector.size();
-			lFitness->setValue(lAvg);
+			//The cases skipped by the racing count as null fitness
+			if(lAborted)
+				lFitness->setValue(getRacingFitness(lAvg, lNbCases));
+			else
+				lFitness->setValue(lAvg/lFitnessVector.size());
 			
 			/*	
 			 //Look at the worst test case
@@ -568,29 +603,34 @@ Beagle::Fitness::Handle ThreeTanksEvalOp::evaluate(Beagle::GP::Individual& inInd
 		} 
 		catch(BG::CausalityException inError) {
 			lFitness->setValue(0);
-			Beagle_LogDetailedM(
+			BondGraph_LogSafeM(Beagle_LogDetailedM(
 							 ioContext.getSystem().getLogger(),
 							 "evaluation", "ThreeTanksEvalOp",
 							 std::string("Error occured during evaluation of fitness: ")+
 							 inError.what()
-							 );
+							 ));
 		}
 		
 	}
 	catch(std::runtime_error inError) {
-		std::cerr << "Error catched while evaluating the bond graph: " << inError.what() << std::endl;
+		lCacheKey.clear();
 		
 		//Save bond graph for debuging
 		std::ostringstream lFilename;
+		mLogMutex.lock();
+		std::cerr << "Error catched while evaluating the bond graph: " << inError.what() << std::endl;
 		lFilename << "bug/bondgraph_bug_" << ioContext.getGeneration() << "_" << mIndividualCounter++;//ioContext.getIndividualIndex();
+		mLogMutex.unlock();
 #ifndef WITHOUT_GRAPHVIZ
 		lBondGraph->plotGraph(lFilename.str()+std::string(".svg"));
 #endif
-		ofstream lFileStream((lFilename.str()+std::string(".xml")).c_str());
+		std::ostringstream lFileStream;
 		PACC::XML::Streamer lStreamer(lFileStream);
 		lBondGraph->write(lStreamer);
 		inIndividual.write(lStreamer);
 		lFileStream << endl;	
+		std::string lBuffer = lFileStream.str();
+		mFileWriter->write(lFilename.str()+std::string(".xml"), lBuffer);
 		//Assign null fitness
 		lFitness->setValue(0);
 		
@@ -599,6 +639,11 @@ Beagle::Fitness::Handle ThreeTanksEvalOp::evaluate(Beagle::GP::Individual& inInd
 #endif
     }
 	
+	//Keep the fitness for the identical bond graphs to come
+	if(!lCacheKey.empty()) {
+		mFitnessCache.insert(lCacheKey, *lFitness);
+	}
+	
 	
 	
 	//delete lBondGraph;
@@ -606,33 +651,33 @@ Beagle::Fitness::Handle ThreeTanksEvalOp::evaluate(Beagle::GP::Individual& inInd
 #ifdef NOSIMULATION
 	lFitness->setValue(ioContext.getSystem().getRandomizer().rollUniform(0,0.999));
 #endif
-	Beagle_LogDebugM(
+	BondGraph_LogSafeM(Beagle_LogDebugM(
 					 ioContext.getSystem().getLogger(),
 					 "evaluation", "ThreeTanksEvalOp",
 					 std::string("Result of evaluation: ")+
 					 lFitness->serialize()
-					 );
+					 ));
 	
-	Beagle_LogTraceM(
+	BondGraph_LogSafeM(Beagle_LogTraceM(
 					 ioContext.getSystem().getLogger(),
 					 "evaluation", "ThreeTanksEvalOp",
 					 std::string("Result of evaluation: ")+
 					 dbl2str(lFitness->getValue())
-					 );
+					 ));
 	
 	return lFitness;
 	
 	Beagle_StackTraceEndM("void ThreeTanksEvalOp::evaluate(Beagle::GP::Individual& inIndividual, Beagle::GP::Context& ioContext)");
 }
 
-double ThreeTanksEvalOp::computeError(const BondGraph* inBondGraph, std::map<std::string, std::vector<double> > &inSimulationLog) {
+double ThreeTanksEvalOp::computeError(const BondGraph* inBondGraph, const SimulationLog& inSimulationLog) {
 	
 	std::vector<double> lErrors(NBOUTPUTS,0);
 	std::vector<bool> lZeroOutput(NBOUTPUTS,true);
+	const std::vector<double>& lTime = inSimulationLog.getColumn(mTimeSignal);
 	for(unsigned int k = 0; k < NBOUTPUTS; ++k) {
-		const std::vector<double>& lTarget = inSimulationLog[std::string("Target_")+int2str(k)];
-		std::vector<double>& lOutput = inSimulationLog[std::string("Output_")+int2str(k)];
-		const std::vector<double>& lTime = inSimulationLog["time"];
+		const std::vector<double>& lTarget = inSimulationLog.getColumn(mTargetSignals[k]);
+		const std::vector<double>& lOutput = inSimulationLog.getColumn(mOutputSignals[k]);
 		
 		unsigned int lDataSize = lTime.size();
 		assert(lTime.size() == lOutput.size());
@@ -688,11 +733,7 @@ double ThreeTanksEvalOp::computeError(const BondGraph* inBondGraph, std::map<std
 
 
 void ThreeTanksEvalOp::initialize(Beagle::System& ioSystem) {
-#ifdef USE_MPI
-	Beagle::MPI::EvaluationOp::initialize(ioSystem);
-#else
-	Beagle::EvaluationOp::initialize(ioSystem);
-#endif
+	BondGraphEvalOp::initialize(ioSystem);
 	
 	PACC::XML::Streamer lStreamer(std::cout);
 	ioSystem.getRegister().write(lStreamer,true);
@@ -731,7 +772,7 @@ void ThreeTanksEvalOp::initialize(Beagle::System& ioSystem) {
 										   "Controller target, by pair for each control time",
 										   "String",
 										   mTargetString->serialize(),
-										   "Tank levels target for the controller"
+										   "Tank levels target for the controller, or @filename to read the cases from a binary simulation case file"
 										   );
 		ioSystem.getRegister().addEntry("sim.control.target", mTargetString, lDescription);
 	}
@@ -796,13 +837,7 @@ void ThreeTanksEvalOp::initialize(Beagle::System& ioSystem) {
  */
 void ThreeTanksEvalOp::postInit(Beagle::System& ioSystem)
 {
-#ifdef USE_MPI
-	Beagle::MPI::EvaluationOp::postInit(ioSystem);
-#else
-	Beagle::EvaluationOp::postInit(ioSystem);
-#endif
-	
-	ioSystem.addComponent(new ParametersHolder);
+	BondGraphEvalOp::postInit(ioSystem);
 	
 	if(*mTargetString == Beagle::String("")) {
 		SimulationCase lCase;
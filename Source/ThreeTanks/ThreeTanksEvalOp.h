@@ -26,6 +26,7 @@
 #include <beagle/GP.hpp>
 #include "BondGraphEvalOp.h"
 #include "SimulationCase.h"
+#include "SimulationLog.h"
 #include "BondGraph.h"
 #include <map>
 #include <vector>
@@ -47,12 +48,11 @@ public:
 
 	
 private:
-	double computeError(const BG::BondGraph* inBondGraph, std::map<std::string, std::vector<double> > &inSimulationLog);
+	double computeError(const BG::BondGraph* inBondGraph, const SimulationLog& inSimulationLog);
 	
 	static bool mIsInitialized;
 	
 	Beagle::String::Handle mTargetString;
-	std::vector<SimulationCase> mSimulationCases;
 	Beagle::FloatArray::Handle mGenerationSteps;
 	
 //	Beagle::Float::Handle mTargetTolerances;
@@ -70,6 +70,12 @@ private:
 	std::vector<Beagle::FloatArray::Handle> mTargetArrays;
 	
 	long int mIndividualCounter;
+	
+	SimulationLog::Signals mSignals;             //!< Identifiers of the logged signals, read concurrently by the evaluations
+	unsigned int mTimeSignal;                    //!< Identifier of the time signal
+	std::vector<unsigned int> mOutputSignals;    //!< Identifiers of the output signals
+	std::vector<unsigned int> mTargetSignals;    //!< Identifiers of the target signals
+	std::vector<unsigned int> mKeptSignals;      //!< Signals kept in the fitness log
 };
 
 #endif
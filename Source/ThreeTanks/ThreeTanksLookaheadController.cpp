@@ -33,8 +33,8 @@ void ThreeTanksLookaheadController::writeLog() {
 	
 	(*mLogger)["State"].push_back(mCurrentState);
 	for(unsigned int i = 0; i < mTargets.size(); ++i) {
-		(*mLogger)[string("Target_")+int2str(i)].push_back(mTargets[i]);
-		(*mLogger)[string("Output_")+int2str(i)].push_back(lLevels[i]);
+		(*mLogger)[getLogColumn(mTargetColumns,"Target_",i)].push_back(mTargets[i]);
+		(*mLogger)[getLogColumn(mOutputColumns,"Output_",i)].push_back(lLevels[i]);
 	}
 }
 
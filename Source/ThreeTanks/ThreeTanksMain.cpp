@@ -46,6 +46,9 @@
 #include "BGSpeciationOp.h"
 #include "BGSpeciationVerificationOp.h"
 #include "StructuralHierarchicalFairCompetitionOp.h"
+#include "AsyncIslandEvolver.h"
+#include "CheckpointWriteOp.h"
+#include "CheckpointReadOp.h"
 #include "StatsCalcStructuralFitnessOp.h"
 #include "CrossoverSelectiveConstrainedOp.hpp"
 #include "MutationStandardSelectiveConstrainedOp.hpp"
@@ -124,13 +127,15 @@ int main(int argc, char *argv[]) {
 #ifdef USE_MPI	
 		MPI::GP::Evolver::Handle lEvolver = new MPI::GP::Evolver(lEvalOp);
 #else
-		GP::Evolver::Handle lEvolver = new GP::Evolver(lEvalOp);
+		AsyncIslandEvolver::Handle lEvolver = new AsyncIslandEvolver(lEvalOp);
 #endif
 		lEvolver->addOperator(new LogIndividualDataOp);
 		lEvolver->addOperator(new BGSpeciationVerificationOp);
 		lEvolver->addOperator(new StatsCalcStructuralFitnessOp);
 		lEvolver->addOperator(new BGSpeciationOp);
 		lEvolver->addOperator(new StructuralHierarchicalFairCompetitionOp);
+		lEvolver->addOperator(new CheckpointWriteOp);
+		lEvolver->addOperator(new CheckpointReadOp);
 		lEvolver->addOperator(new Beagle::GP::CrossoverSelectiveConstrainedOp);
 		lEvolver->addOperator(new Beagle::GP::MutationStandardSelectiveConstrainedOp);
 		lEvolver->addOperator(new Beagle::GP::MutationShrinkSelectiveConstrainedOp);
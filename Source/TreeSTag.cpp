@@ -28,6 +28,9 @@
 
 using namespace Beagle;
 
+std::map<std::string, unsigned int> TreeSTag::smPrimitiveIDs;
+PACC::Threading::Mutex TreeSTag::smPrimitiveIDsMutex;
+
 TreeSTag::~TreeSTag() { }
 
 
@@ -36,59 +39,103 @@ void TreeSTag::setStructureIDInvalid() {
 	mValidStructure = false;
 }
 
+/*! \brief Set the values of the ephemeral constants
+ *  The values are assigned in preorder, as given by computeParameterVector.
+ */
 void TreeSTag::assignNewParameterVector(Beagle::GA::FloatVector::Handle inParameters, Beagle::GP::Context& ioContext) {
 	mParametersVector = inParameters;
-	mAssignmentIndex = 0;
 	mValidStructure = false;
-	parseSubTreeAssign(0, ioContext);
-	return;
-}
-
-unsigned int TreeSTag::parseSubTreeAssign(unsigned int inN, GP::Context& ioContext) {
-	unsigned int lNumberArguments = (*this)[inN].mPrimitive->getNumberArguments();
-	
-	//Identify the primitive
-	if( /*((*this)[inN].mPrimitive->getReturnType(ioContext) == ArgEph) &&*/ ((*this)[inN].mPrimitive->getName() == "E")) {
-		Double lValue = (*mParametersVector)[mAssignmentIndex++];
-		(*this)[inN].mPrimitive->setValue(lValue);
-	}
 	
-	//Parse all child
-	unsigned int lSubTreeSize = 1;
-	for(unsigned int i=0; i<lNumberArguments; ++i) {
-		lSubTreeSize += parseSubTreeAssign((lSubTreeSize+inN), ioContext);
+	const std::vector<FlatNode>& lNodes = getFlatEncoding();
+	for(unsigned int i = 0; i < mParameterNodes.size(); ++i) {
+		unsigned int lNode = mParameterNodes[i];
+		Double lValue = (*mParametersVector)[lNodes[lNode].mParameterSlot];
+		(*this)[lNode].mPrimitive->setValue(lValue);
 	}
-	return lSubTreeSize;
 }
 
+/*! \brief Return the values of the ephemeral constants of the tree, in preorder
+ */
 GA::FloatVector::Handle TreeSTag::computeParameterVector(GP::Context& ioContext){
 	mParametersVector->resize(0);
-	parseSubTree(0, ioContext);
+	
+	getFlatEncoding();
+	for(unsigned int i = 0; i < mParameterNodes.size(); ++i) {
+		GP::Primitive::Handle lPrimitive = (*this)[mParameterNodes[i]].mPrimitive;
+		if(lPrimitive->haveValue()) {
+			Double lValue;
+			lPrimitive->getValue(lValue);
+			mParametersVector->push_back(lValue);
+		}
+	}
 	return mParametersVector;
 }
 
-unsigned int TreeSTag::parseSubTree(unsigned int inN, GP::Context& ioContext) {
+/*! \brief Return the identifier of a primitive name
+ *  The names are interned once, the identifiers are shared by all the trees.
+ */
+unsigned int TreeSTag::getPrimitiveID(const std::string& inName) {
+	smPrimitiveIDsMutex.lock();
+	std::map<std::string, unsigned int>::const_iterator lIter = smPrimitiveIDs.find(inName);
+	unsigned int lID;
+	if(lIter != smPrimitiveIDs.end()) {
+		lID = lIter->second;
+	} else {
+		lID = smPrimitiveIDs.size();
+		smPrimitiveIDs[inName] = lID;
+	}
+	smPrimitiveIDsMutex.unlock();
+	return lID;
+}
 
-	unsigned int lNumberArguments = (*this)[inN].mPrimitive->getNumberArguments();
-	
-	//Identify the primitive
-	if( /*((*this)[inN].mPrimitive->getReturnType(ioContext) == ArgEph) &&*/ ((*this)[inN].mPrimitive->getName() == "E")) {
-		Double lValue;
-		if((*this)[inN].mPrimitive->haveValue()) {
-			(*this)[inN].mPrimitive->getValue(lValue);
-			mParametersVector->push_back(lValue);
-		}
+/*! \brief Check that the preorder encoding describes the current tree
+ *  A tree is fully described by its primitives in preorder, a modification of the tree by any
+ *	operator changes the primitive or the subtree size of at least one node.
+ */
+bool TreeSTag::isFlatEncodingValid() const {
+	if(mFlatNodes.size() != size())
+		return false;
+	for(unsigned int i = 0; i < size(); ++i) {
+		if((mFlatPrimitives[i] != (*this)[i].mPrimitive) || (mFlatNodes[i].mSubTreeSize != (*this)[i].mSubTreeSize))
+			return false;
 	}
+	return true;
+}
+
+/*! \brief Return the preorder encoding of the tree
+ *  The encoding is rebuilt in a single pass when the tree was modified. It gives the primitive
+ *	identifier, the subtree size, the depth and the ephemeral constant slot of each node.
+ */
+const std::vector<TreeSTag::FlatNode>& TreeSTag::getFlatEncoding() const {
+	if(isFlatEncodingValid())
+		return mFlatNodes;
+	
+	mFlatNodes.resize(size());
+	mFlatPrimitives.resize(size());
+	mParameterNodes.clear();
 	
-	//Parse all child
-	unsigned int lSubTreeSize = 1;
-	for(unsigned int i=0; i<lNumberArguments; ++i) {
-		lSubTreeSize += parseSubTree((lSubTreeSize+inN), ioContext);
+	//End index of the subtrees of the ancestors of the current node
+	std::vector<unsigned int> lAncestorEnds;
+	for(unsigned int i = 0; i < size(); ++i) {
+		while(!lAncestorEnds.empty() && lAncestorEnds.back() <= i)
+			lAncestorEnds.pop_back();
+		
+		FlatNode& lNode = mFlatNodes[i];
+		mFlatPrimitives[i] = (*this)[i].mPrimitive;
+		lNode.mPrimitiveID = getPrimitiveID((*this)[i].mPrimitive->getName());
+		lNode.mSubTreeSize = (*this)[i].mSubTreeSize;
+		lNode.mDepth = lAncestorEnds.size()+1;
+		lNode.mParameterSlot = -1;
+		if((*this)[i].mPrimitive->getName() == "E") {
+			lNode.mParameterSlot = mParameterNodes.size();
+			mParameterNodes.push_back(i);
+		}
+		
+		lAncestorEnds.push_back(i+lNode.mSubTreeSize);
 	}
-	return lSubTreeSize;
+	return mFlatNodes;
 }
 
-
 TreeSTag::TreeSTag(unsigned int inSize, unsigned int inPrimitiveSetIndex, unsigned int inNumberArguments) {
 	Beagle::GP::Tree(inSize,inPrimitiveSetIndex,inNumberArguments);
 	mStructureID = 0;
@@ -218,8 +265,10 @@ bool TreeSTag::compareTopology(const TreeSTag& inRightTree) const {
 	if(this->size() != inRightTree.size())
 		return false;
 	
-	for(unsigned int i = 0; i < (*this).size(); ++i) {
-		if(((*this)[i].mPrimitive->getName() != inRightTree[i].mPrimitive->getName()) || ((*this)[i].mSubTreeSize != inRightTree[i].mSubTreeSize) )
+	const std::vector<FlatNode>& lLeftNodes = getFlatEncoding();
+	const std::vector<FlatNode>& lRightNodes = inRightTree.getFlatEncoding();
+	for(unsigned int i = 0; i < lLeftNodes.size(); ++i) {
+		if((lLeftNodes[i].mPrimitiveID != lRightNodes[i].mPrimitiveID) || (lLeftNodes[i].mSubTreeSize != lRightNodes[i].mSubTreeSize) )
 			return false;
 	}
 	
@@ -241,42 +290,34 @@ bool TreeSTag::findMatchingTopology(Deme& ioDeme, Context& ioContext, TreeSTag::
 	return false;
 }
 
-void TreeSTag::removeNOPLoop(unsigned int inN, GP::Context& ioContext) {
-	GP::Tree& lActualTree = ioContext.getGenotype();
+/*! \brief Remove the NOP primitives of the tree
+ *  The NOP has a single argument which takes its place. The subtree size of a node is reduced
+ *	by the number of NOP in its subtree, they are counted with a prefix sum over the preorder
+ *	encoding, and the remaining nodes are compacted in a single pass.
+ */
+void TreeSTag::removeNOPNodes() {
+	const std::vector<FlatNode>& lNodes = getFlatEncoding();
+	unsigned int lNOPID = getPrimitiveID("NOP");
 	
-	if(lActualTree[inN].mPrimitive->getName() == "NOP") {
-		//Decrease the subtree size of the call stack
-		for(unsigned i = 0; i < ioContext.getCallStackSize(); ++i) {
-			lActualTree[ioContext.getCallStack()[i]].mSubTreeSize -= 1;
-		}
-		
-		//Delete the primitive from the tree
-		std::vector< GP::Node,BEAGLE_STLALLOCATOR<GP::Node> >::iterator lPrimitiveIter = lActualTree.begin();
-		lPrimitiveIter += inN;
-		lActualTree.erase(lPrimitiveIter);
-
-		
-//		cout << "Callstack: " << ioContext.getCallStack()[0];
-//		for(unsigned int i = 1; i < ioContext.getCallStackSize() ; ++i) {
-//			cout << ", " << ioContext.getCallStack()[0];
-//		} cout << endl;
-//		for(unsigned int i = 0; i < lActualTree.size(); ++i) {
-//			cout << i << " : " << lActualTree[i].mPrimitive->getName() << " : " << lActualTree[i].mSubTreeSize << endl;
-//		}
-		
-		removeNOPLoop(inN, ioContext);
-		
-	} else {
-		//Parse all arguments
-		ioContext.pushCallStack(inN);
-		for(unsigned int i = 0; i < lActualTree[inN].mPrimitive->getNumberArguments(); ++i) {
-			removeNOPLoop(lActualTree[inN].mPrimitive->getChildrenNodeIndex(i,ioContext), ioContext);
-		}
-		ioContext.popCallStack();
+	//Number of NOP before each node
+	std::vector<unsigned int> lNOPCount(size()+1, 0);
+	for(unsigned int i = 0; i < size(); ++i) {
+		lNOPCount[i+1] = lNOPCount[i] + (lNodes[i].mPrimitiveID == lNOPID ? 1 : 0);
+	}
+	if(lNOPCount[size()] == 0)
+		return;
+	
+	unsigned int lNewSize = 0;
+	for(unsigned int i = 0; i < size(); ++i) {
+		if(lNodes[i].mPrimitiveID == lNOPID)
+			continue;
+		GP::Node lNode = (*this)[i];
+		lNode.mSubTreeSize -= lNOPCount[i+lNode.mSubTreeSize] - lNOPCount[i];
+		(*this)[lNewSize++] = lNode;
 	}
+	erase(begin()+lNewSize, end());
 }
 
-
 void TreeSTag::removeNOP(Individual& inIndividual, GP::Context& ioContext) {
 //	Beagle_LogDebugM(
 //					 ioContext.getSystem().getLogger(),
@@ -286,22 +327,7 @@ void TreeSTag::removeNOP(Individual& inIndividual, GP::Context& ioContext) {
 	
 	
 	TreeSTag::Handle lTree = castHandleT<TreeSTag>((inIndividual)[0]);
-	GP::Individual& lIndividual = castObjectT<GP::Individual&>(inIndividual);
-	
-	GP::Individual::Handle lOldIndividualHandle = ioContext.getIndividualHandle();
-	unsigned int lOldGenotypeIndex = ioContext.getGenotypeIndex();
-	GP::Tree::Handle lOldGenotypeHandle = ioContext.getGenotypeHandle();	
-	
-	ioContext.setIndividualHandle(&lIndividual);
-	ioContext.setGenotypeIndex(0);
-	ioContext.setGenotypeHandle(lIndividual[0]);
-	
-	ioContext.getCallStack().clear();
-	removeNOPLoop(0,ioContext);
-	
-	ioContext.setIndividualHandle(lOldIndividualHandle);
-	ioContext.setGenotypeIndex(lOldGenotypeIndex);
-	ioContext.setGenotypeHandle(lOldGenotypeHandle);
+	lTree->removeNOPNodes();
 	
 //	Beagle_LogDebugM(
 //					 ioContext.getSystem().getLogger(),
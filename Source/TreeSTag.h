@@ -25,6 +25,10 @@
 
 #include <beagle/GP.hpp>
 #include <beagle/GA.hpp>
+#include <PACC/Threading.hpp>
+#include <map>
+#include <string>
+#include <vector>
 #include "GrowingBG.h"
 
 class TreeSTag : public Beagle::GP::Tree {
@@ -36,6 +40,14 @@ public:
 	//! Bag type.
 	typedef Beagle::ContainerT<TreeSTag,Beagle::GP::Tree::Bag> Bag;
 	
+	//! Node of the preorder encoding of the tree.
+	struct FlatNode {
+		unsigned int mPrimitiveID;	//!< Identifier of the primitive name, see getPrimitiveID
+		unsigned int mSubTreeSize;	//!< Number of nodes of the subtree rooted at this node
+		unsigned int mDepth;		//!< Depth of the node, the root is at depth 1
+		int mParameterSlot;			//!< Index of the ephemeral constant in the parameter vector, -1 if none
+	};
+	
 	explicit TreeSTag(unsigned int inSize=0,
 				  unsigned int inPrimitiveSetIndex=UINT_MAX,
 				  unsigned int inNumberArguments=0);
@@ -65,22 +77,32 @@ public:
 	
 	static void removeNOP(Beagle::Individual& inIndividual, Beagle::GP::Context& ioContext);
 	
+	const std::vector<FlatNode>& getFlatEncoding() const;
+	unsigned int getNumberParameters() const { getFlatEncoding(); return mParameterNodes.size(); }
+	static unsigned int getPrimitiveID(const std::string& inName);
+	
 	bool isStructureIDValid() const { return mValidStructure; }
 	void setStructureIDInvalid();
 	void setStructureIDValid() { mValidStructure = true; }
 	
 protected:
-	static void removeNOPLoop(unsigned int inN, Beagle::GP::Context& ioContext);
+	void removeNOPNodes();
+	bool isFlatEncodingValid() const;
 	
 	//GrowingBG::Handle mBondGraph;
 	unsigned int mAge;
 	bool mValidStructure;
 	unsigned int mStructureID;
 
-	unsigned int mAssignmentIndex;
 	Beagle::GA::FloatVector::Handle mParametersVector;
-	unsigned int parseSubTreeAssign(unsigned int inN, Beagle::GP::Context& ioContext);
-	unsigned int parseSubTree(unsigned int inN, Beagle::GP::Context& ioContext);
+	
+	//The preorder encoding is rebuilt when the primitives or the subtree sizes of the tree change
+	mutable std::vector<FlatNode> mFlatNodes;
+	mutable std::vector<Beagle::GP::Primitive::Handle> mFlatPrimitives;	//!< Primitives of the encoded tree, kept alive for the validity check
+	mutable std::vector<unsigned int> mParameterNodes;	//!< Index of the ephemeral constants in preorder
+	
+	static std::map<std::string, unsigned int> smPrimitiveIDs;
+	static PACC::Threading::Mutex smPrimitiveIDsMutex;
 };
 
 #endif
@@ -0,0 +1,141 @@
+/*
+ *  ZOHPropagator.cpp
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *  
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#include "ZOHPropagator.h"
+#include <cmath>
+#include <stdexcept>
+
+/*! \brief Compute the discrete matrices for a time step
+ *  \param  inA State matrix.
+ *  \param  inB Input matrix.
+ *  \param  inTimeStep Time step of the discretization.
+ */
+void ZOHPropagator::discretize(const PACC::Matrix& inA, const PACC::Matrix& inB, double inTimeStep) {
+	if(inA.getRows() != inA.getCols())
+		throw std::runtime_error("ZOHPropagator::discretize: the state matrix should be square");
+	if(inB.getRows() > 0 && inB.getRows() != inA.getRows())
+		throw std::runtime_error("ZOHPropagator::discretize: the state and input matrices don't have the same number of rows");
+	
+	unsigned int lNbStates = inA.getRows();
+	unsigned int lNbInputs = inB.getRows() > 0 ? inB.getCols() : 0;
+	unsigned int lSize = lNbStates + lNbInputs;
+	
+	//Augmented matrix [A B; 0 0]T
+	PACC::Matrix lM;
+	lM.setZero(lSize,lSize);
+	for(unsigned int i = 0; i < lNbStates; ++i) {
+		for(unsigned int j = 0; j < lNbStates; ++j) {
+			lM(i,j) = inA(i,j)*inTimeStep;
+		}
+		for(unsigned int j = 0; j < lNbInputs; ++j) {
+			lM(i,lNbStates+j) = inB(i,j)*inTimeStep;
+		}
+	}
+	
+	PACC::Matrix lExp = exponential(lM);
+	
+	mAd.resize(lNbStates,lNbStates);
+	mBd.resize(lNbStates,lNbInputs);
+	for(unsigned int i = 0; i < lNbStates; ++i) {
+		for(unsigned int j = 0; j < lNbStates; ++j) {
+			mAd(i,j) = lExp(i,j);
+		}
+		for(unsigned int j = 0; j < lNbInputs; ++j) {
+			mBd(i,j) = lExp(i,lNbStates+j);
+		}
+	}
+	mTimeStep = inTimeStep;
+}
+
+/*! \brief Propagate the state of one time step
+ *  \param  inState State at the beginning of the step.
+ *  \param  inInputs Inputs, held constant during the step.
+ *  \param  outState State at the end of the step.
+ *  \return False if the vectors don't match the size of the discretized mode.
+ */
+bool ZOHPropagator::step(const std::vector<double>& inState, const std::vector<double>& inInputs, std::vector<double>& outState) const {
+	if(mTimeStep <= 0 || inState.size() != mAd.getRows() || inInputs.size() != mBd.getCols())
+		return false;
+	
+	outState.assign(inState.size(),0);
+	for(unsigned int i = 0; i < mAd.getRows(); ++i) {
+		double lValue = 0;
+		for(unsigned int j = 0; j < mAd.getCols(); ++j) {
+			lValue += mAd(i,j)*inState[j];
+		}
+		for(unsigned int j = 0; j < mBd.getCols(); ++j) {
+			lValue += mBd(i,j)*inInputs[j];
+		}
+		outState[i] = lValue;
+	}
+	return true;
+}
+
+/*! \brief Matrix exponential
+ *  Computed by scaling and squaring with a diagonal Pade approximant of order 6.
+ *  \param  inMatrix Square matrix.
+ *  \return Exponential of the matrix.
+ */
+PACC::Matrix ZOHPropagator::exponential(const PACC::Matrix& inMatrix) {
+	unsigned int lSize = inMatrix.getRows();
+	PACC::Matrix lIdentity;
+	lIdentity.setIdentity(lSize);
+	if(lSize == 0)
+		return lIdentity;
+	
+	//Scale the matrix so that its infinity norm is below 0.5
+	double lNorm = 0;
+	for(unsigned int i = 0; i < lSize; ++i) {
+		double lRowSum = 0;
+		for(unsigned int j = 0; j < lSize; ++j) {
+			lRowSum += fabs(inMatrix(i,j));
+		}
+		if(lRowSum > lNorm)
+			lNorm = lRowSum;
+	}
+	int lSquarings = 0;
+	if(lNorm > 0.5)
+		lSquarings = int(ceil(log(lNorm/0.5)/log(2.0)));
+	PACC::Matrix lX = inMatrix*(1.0/pow(2.0,lSquarings));
+	
+	//Pade approximant N(X)/D(X), with D(X) = N(-X)
+	const unsigned int lOrder = 6;
+	PACC::Matrix lN = lIdentity;
+	PACC::Matrix lD = lIdentity;
+	PACC::Matrix lPower = lIdentity;
+	double lCoefficient = 1;
+	for(unsigned int k = 1; k <= lOrder; ++k) {
+		lCoefficient *= double(lOrder-k+1)/double(k*(2*lOrder-k+1));
+		lPower = lPower*lX;
+		lN += lPower*lCoefficient;
+		if(k % 2 == 0)
+			lD += lPower*lCoefficient;
+		else
+			lD -= lPower*lCoefficient;
+	}
+	PACC::Matrix lExp = lD.invert()*lN;
+	
+	for(int s = 0; s < lSquarings; ++s) {
+		lExp = lExp*lExp;
+	}
+	return lExp;
+}
@@ -0,0 +1,60 @@
+/*
+ *  ZOHPropagator.h
+ *  Copyright 2010 Jean-Francois Dupuis.
+ *
+ *  This file is part of HBGGP.
+ *  
+ *  HBGGP is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HBGGP is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HBGGP.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ *  This file was created by Jean-Francois Dupuis on 14/06/10.
+ */
+
+#ifndef ZOHPropagator_H
+#define ZOHPropagator_H
+
+#include <vector>
+#include <PACC/Math.hpp>
+
+/*! \brief Exact discrete-time propagator of a linear time-invariant mode
+ *  The state equation dx/dt = Ax + Bu is discretized with a zero-order hold on the input,
+ *	x(t+T) = Ad x(t) + Bd u(t), where Ad and Bd are taken from the matrix exponential of the
+ *	augmented matrix [A B; 0 0]T. A step of length T is then a single matrix-vector product.
+ *
+ *	With USE_ZOH, the lookahead propagates the candidate modes with it. The simulation of the
+ *	individuals is integrated by libBondGraph with the method selected by USE_RKF or USE_RKFVS,
+ *	which can't be replaced from this project.
+ */
+class ZOHPropagator {
+public:
+	ZOHPropagator() : mTimeStep(0) {}
+	~ZOHPropagator() {}
+	
+	void discretize(const PACC::Matrix& inA, const PACC::Matrix& inB, double inTimeStep);
+	bool isDiscretized(double inTimeStep) const { return mTimeStep > 0 && mTimeStep == inTimeStep; }
+	double getTimeStep() const { return mTimeStep; }
+	
+	const PACC::Matrix& getAd() const { return mAd; }
+	const PACC::Matrix& getBd() const { return mBd; }
+	
+	bool step(const std::vector<double>& inState, const std::vector<double>& inInputs, std::vector<double>& outState) const;
+	
+	static PACC::Matrix exponential(const PACC::Matrix& inMatrix);
+	
+private:
+	double mTimeStep;	//!< Time step of the discretization, 0 if not discretized
+	PACC::Matrix mAd;
+	PACC::Matrix mBd;
+};
+
+#endif
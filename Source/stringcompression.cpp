@@ -85,14 +85,76 @@ void string2hex(string& ioString) {
 }
 
 void hex2string(string& ioString) {
-	string Out;
-	string Temp = ioString;
-	string ffStr = "ff";
-	while(!Temp.empty()) {
-		Out += (char )strtol(Temp.substr(0, 2).c_str(), 0, 16);
-		Temp = Temp.substr(2);
+	string lResult;
+	lResult.resize(ioString.size() / 2);
+	
+	const char* lDataIn = ioString.data();
+	char* lDataOut = (char*)lResult.data();
+	
+	for(unsigned int i = 0; i < lResult.size(); ++i) {
+		char lHigh = lDataIn[2*i];
+		char lLow = lDataIn[2*i+1];
+		lHigh = (lHigh >= 'a') ? lHigh-'a'+10 : ((lHigh >= 'A') ? lHigh-'A'+10 : lHigh-'0');
+		lLow = (lLow >= 'a') ? lLow-'a'+10 : ((lLow >= 'A') ? lLow-'A'+10 : lLow-'0');
+		lDataOut[i] = (char)((lHigh << 4) | (lLow & 0xf));
 	}
-	ioString = Out;
+	
+	ioString = lResult;
 } 
 
+static const char gBase64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+void string2base64(string& ioString) {
+	string lResult;
+	lResult.reserve(((ioString.size()+2)/3)*4);
+	
+	const unsigned char* lDataIn = (const unsigned char*)ioString.data();
+	unsigned int i = 0;
+	for(; i + 2 < ioString.size(); i += 3) {
+		unsigned long lBlock = (lDataIn[i] << 16) | (lDataIn[i+1] << 8) | lDataIn[i+2];
+		lResult += gBase64Chars[(lBlock >> 18) & 0x3f];
+		lResult += gBase64Chars[(lBlock >> 12) & 0x3f];
+		lResult += gBase64Chars[(lBlock >> 6) & 0x3f];
+		lResult += gBase64Chars[lBlock & 0x3f];
+	}
+	if(i < ioString.size()) {
+		unsigned long lBlock = lDataIn[i] << 16;
+		if(i + 1 < ioString.size())
+			lBlock |= lDataIn[i+1] << 8;
+		lResult += gBase64Chars[(lBlock >> 18) & 0x3f];
+		lResult += gBase64Chars[(lBlock >> 12) & 0x3f];
+		lResult += (i + 1 < ioString.size()) ? gBase64Chars[(lBlock >> 6) & 0x3f] : '=';
+		lResult += '=';
+	}
+	
+	ioString = lResult;
+}
+
+void base642string(string& ioString) {
+	int lValues[256];
+	for(unsigned int i = 0; i < 256; ++i)
+		lValues[i] = -1;
+	for(unsigned int i = 0; i < 64; ++i)
+		lValues[(unsigned char)gBase64Chars[i]] = i;
+	
+	string lResult;
+	lResult.reserve((ioString.size()/4)*3);
+	
+	unsigned long lBlock = 0;
+	unsigned int lNbBits = 0;
+	for(unsigned int i = 0; i < ioString.size(); ++i) {
+		int lValue = lValues[(unsigned char)ioString[i]];
+		if(lValue < 0) //Padding and white spaces
+			continue;
+		lBlock = (lBlock << 6) | lValue;
+		lNbBits += 6;
+		if(lNbBits >= 8) {
+			lNbBits -= 8;
+			lResult += char((lBlock >> lNbBits) & 0xff);
+		}
+	}
+	
+	ioString = lResult;
+}
+
 #endif
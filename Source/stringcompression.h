@@ -29,10 +29,13 @@ using namespace std;
 */
 
 void compressString(const string& inString, string& outString, unsigned int inCompressionLevel = 9);
-void uncompressString(string& ioString, unsigned int inUncompressedSize);
+void uncompressString(string& ioString, unsigned long inUncompressedSize);
 
 void string2hex(string& ioString);
 void hex2string(string& ioString);
+
+void string2base64(string& ioString);
+void base642string(string& ioString);
 		
 
 #endif